@@ -0,0 +1,182 @@
+#include "Any.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+
+namespace exc {
+
+
+namespace {
+
+constexpr size_t MinClassSize = 32;
+constexpr size_t NumClasses = 10; // up to 16 kiB
+constexpr size_t MaxBlocksPerClass = 64;
+constexpr size_t MaxSharedBlocksPerClass = 4 * MaxBlocksPerClass;
+
+std::atomic<uint64_t> numHeapAllocations(0);
+std::atomic<uint64_t> numPoolReuses(0);
+std::atomic<uint64_t> numInlineStores(0);
+std::atomic<uint64_t> numClones(0);
+
+// Index of the smallest class the size fits in, NumClasses if none.
+size_t SizeClass(size_t size) {
+	size_t index = 0;
+	size_t classSize = MinClassSize;
+	while (index < NumClasses && classSize < size) {
+		classSize *= 2;
+		++index;
+	}
+	return index;
+}
+
+size_t ClassSize(size_t index) {
+	return MinClassSize << index;
+}
+
+// Blocks that threads hand back and forth. A thread that frees more than it allocates,
+// like the consumer of a pipeline, moves its surplus here, the producer picks it up.
+struct SharedLists {
+	SharedLists() {
+		for (auto& list : lists) {
+			list.reserve(MaxSharedBlocksPerClass);
+		}
+	}
+	~SharedLists() {
+		std::lock_guard<std::mutex> lkg(mtx);
+		isDestroyed = true;
+		for (auto& list : lists) {
+			for (auto block : list) {
+				::operator delete(block);
+			}
+			list.clear();
+		}
+	}
+	// Move blocks from the end of list, up to count, to the shared list. Deletes what doesn't fit.
+	void Give(size_t index, std::vector<void*>& list, size_t count) {
+		std::lock_guard<std::mutex> lkg(mtx);
+		auto& shared = lists[index];
+		for (; count > 0; --count) {
+			if (!isDestroyed && shared.size() < MaxSharedBlocksPerClass) {
+				shared.push_back(list.back());
+			}
+			else {
+				::operator delete(list.back());
+			}
+			list.pop_back();
+		}
+	}
+	// Move up to count blocks from the shared list to the end of list.
+	void Take(size_t index, std::vector<void*>& list, size_t count) {
+		std::lock_guard<std::mutex> lkg(mtx);
+		auto& shared = lists[index];
+		for (; count > 0 && !shared.empty(); --count) {
+			list.push_back(shared.back());
+			shared.pop_back();
+		}
+	}
+
+	std::mutex mtx;
+	bool isDestroyed = false;
+	std::vector<void*> lists[NumClasses];
+};
+
+// on first use, so Any objects of static storage can use it
+SharedLists& GetSharedLists() {
+	static SharedLists lists;
+	return lists;
+}
+
+struct FreeLists {
+	FreeLists() {
+		for (auto& list : lists) {
+			list.reserve(MaxBlocksPerClass);
+		}
+	}
+	~FreeLists() {
+		isDestroyed = true;
+		// other threads may still use them
+		for (size_t index = 0; index < NumClasses; ++index) {
+			GetSharedLists().Give(index, lists[index], lists[index].size());
+		}
+	}
+	std::vector<void*> lists[NumClasses];
+	static thread_local bool isDestroyed;
+};
+
+thread_local bool FreeLists::isDestroyed = false;
+thread_local FreeLists freeLists;
+
+} // namespace
+
+
+void* impl::AnyPool::Allocate(size_t size) {
+	size_t index = SizeClass(size);
+	if (index < NumClasses) {
+		// blocks of a class are always the full class size, whichever list they end up in
+		size = ClassSize(index);
+		if (!FreeLists::isDestroyed) {
+			auto& list = freeLists.lists[index];
+			if (list.empty()) {
+				GetSharedLists().Take(index, list, MaxBlocksPerClass / 2);
+			}
+			if (!list.empty()) {
+				void* block = list.back();
+				list.pop_back();
+				numPoolReuses.fetch_add(1, std::memory_order_relaxed);
+				return block;
+			}
+		}
+	}
+	numHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+	return ::operator new(size);
+}
+
+
+void impl::AnyPool::Deallocate(void* block, size_t size) {
+	// blocks freed by another thread than the one that allocated them go to this thread's pool,
+	// when that fills up, half of it goes to the shared lists, where the allocating thread finds them
+	size_t index = SizeClass(size);
+	if (index < NumClasses && !FreeLists::isDestroyed) {
+		auto& list = freeLists.lists[index];
+		if (list.size() == MaxBlocksPerClass) {
+			GetSharedLists().Give(index, list, MaxBlocksPerClass / 2);
+		}
+		list.push_back(block);
+	}
+	else {
+		::operator delete(block);
+	}
+}
+
+
+auto Any::GetAllocationStats() -> AllocationStats {
+	AllocationStats stats;
+	stats.numHeapAllocations = numHeapAllocations.load(std::memory_order_relaxed);
+	stats.numPoolReuses = numPoolReuses.load(std::memory_order_relaxed);
+	stats.numInlineStores = numInlineStores.load(std::memory_order_relaxed);
+	stats.numClones = numClones.load(std::memory_order_relaxed);
+	return stats;
+}
+
+
+void Any::ResetAllocationStats() {
+	numHeapAllocations = 0;
+	numPoolReuses = 0;
+	numInlineStores = 0;
+	numClones = 0;
+}
+
+
+void Any::CountClone() {
+	numClones.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void Any::CountInlineStore() {
+	numInlineStores.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+} // namespace exc
@@ -1,95 +1,254 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
 #include <stdexcept>
 #include <typeindex>
-#include <memory>
+#include <typeinfo>
+#include <type_traits>
+#include <utility>
 
 
 namespace exc {
 
 
+namespace impl {
+
+/// <summary>
+/// Recycles the memory of large Any payloads. Blocks are kept in per-thread
+/// free lists of a few size classes, each holding a limited number of blocks.
+/// Threads exchange their surplus through shared lists, so a thread that only
+/// allocates gets back the blocks another thread frees. Sizes above the largest
+/// class go straight to the heap.
+/// </summary>
+class AnyPool {
+public:
+	static void* Allocate(size_t size);
+	static void Deallocate(void* block, size_t size);
+};
+
+} // namespace impl
+
+
+
+/// <summary>
+/// <para> Holds a single object of any copyable type. </para>
+/// <para>
+/// Small trivially copyable objects, like numbers, are stored inside the Any, without allocation.
+/// Larger objects are placed in pooled memory. Moving an Any never copies the object.
+/// </para>
+/// </summary>
 class Any {
-	struct Data {
-		virtual ~Data() = default;
-		virtual void* Get() = 0;
-		virtual const void* Get() const = 0;
-		virtual size_t Size() const = 0;
-		virtual Data* Clone() const = 0;
-		virtual std::type_index Type() const = 0;
+public:
+	/// <summary> Counters of the memory operations of all Any objects, for profiling. </summary>
+	struct AllocationStats {
+		/// <summary> Blocks requested from the heap. </summary>
+		uint64_t numHeapAllocations;
+		/// <summary> Blocks reused from the pool. </summary>
+		uint64_t numPoolReuses;
+		/// <summary> Objects stored inline, without any memory allocation. </summary>
+		uint64_t numInlineStores;
+		/// <summary> Objects copied by copying an Any. </summary>
+		uint64_t numClones;
 	};
+
+	static constexpr size_t InlineSize = 3 * sizeof(void*);
+	static constexpr size_t InlineAlignment = alignof(double) > alignof(void*) ? alignof(double) : alignof(void*);
+private:
+	union Storage {
+		void* block;
+		alignas(InlineAlignment) unsigned char buffer[InlineSize];
+	};
+
+	// Type-specific operations of the stored object.
+	struct Ops {
+		const std::type_info& (*type)();
+		bool isInline;
+		void (*copy)(const Storage& source, Storage& destination);
+		void (*destroy)(Storage& storage);
+	};
+
+	template <class T>
+	using IsInline = std::integral_constant<bool,
+		sizeof(T) <= InlineSize && alignof(T) <= InlineAlignment && std::is_trivially_copyable<T>::value>;
+
+	template <class T>
+	struct OpsFor;
 public:
 	Any() = default;
 
-	template <class T>
+	template <class T, class = std::enable_if_t<!std::is_same<std::decay_t<T>, Any>::value>>
 	explicit Any(T&& obj) {
-		struct DataSpec : public Data {
-			DataSpec(const T& obj) : obj(obj) {}
-			DataSpec(std::decay_t<T>&& obj) : obj(std::forward<T>(obj)) {}
-			virtual void* Get() override { return &obj; };
-			virtual const void* Get() const override { return &obj; }
-			virtual size_t Size() const override { return sizeof(T); }
-			virtual Data* Clone() const override { return new DataSpec(obj); }
-			virtual std::type_index Type() const override { return typeid(T); }
-			std::decay_t<T> obj;
-		};
-		m_data = std::make_unique<DataSpec>(std::forward<T>(obj));
-	}
-
-	Any(const Any& rhs) : m_data(rhs.m_data->Clone()) {}
-	Any(Any&& rhs) : m_data(std::move(rhs.m_data)) {}
-	Any& operator=(const Any& rhs) { m_data.reset(rhs.m_data->Clone()); return *this; }
-	Any& operator=(Any&& rhs) { m_data = std::move(rhs.m_data); return *this; }
+		Construct<std::decay_t<T>>(IsInline<std::decay_t<T>>{}, std::forward<T>(obj));
+	}
 
-	template <class T>
+	Any(const Any& rhs) : m_ops(rhs.m_ops) {
+		if (m_ops) {
+			m_ops->copy(rhs.m_storage, m_storage);
+			CountClone();
+		}
+	}
+	Any(Any&& rhs) noexcept : m_ops(rhs.m_ops), m_storage(rhs.m_storage) {
+		rhs.m_ops = nullptr;
+	}
+	Any& operator=(const Any& rhs) {
+		if (this != &rhs) {
+			*this = Any(rhs);
+		}
+		return *this;
+	}
+	Any& operator=(Any&& rhs) noexcept {
+		if (this != &rhs) {
+			Reset();
+			m_ops = rhs.m_ops;
+			m_storage = rhs.m_storage;
+			rhs.m_ops = nullptr;
+		}
+		return *this;
+	}
+	~Any() {
+		Reset();
+	}
+
+	template <class T, class = std::enable_if_t<!std::is_same<std::decay_t<T>, Any>::value>>
 	Any& operator=(T&& obj) {
 		*this = Any(std::forward<T>(obj));
 		return *this;
 	}
 
 
-	explicit operator bool() const { return (bool)m_data; }
-	bool HasValue() const { return (bool)m_data; }
+	explicit operator bool() const { return m_ops != nullptr; }
+	bool HasValue() const { return m_ops != nullptr; }
+
+	/// <summary> Destroy the stored object. </summary>
+	void Reset() {
+		if (m_ops) {
+			m_ops->destroy(m_storage);
+			m_ops = nullptr;
+		}
+	}
 
 
 	template <class T>
 	T& Get() {
-		if (!m_data) {
+		if (!m_ops) {
 			throw std::logic_error("Object is empty.");
 		}
-		if (typeid(T) != m_data->Type()) {
-			throw std::bad_cast("Types don't match.");
+		if (typeid(T) != m_ops->type()) {
+			throw std::bad_cast();
 		}
-		return *reinterpret_cast<T*>(m_data->Get());
+		return *reinterpret_cast<T*>(Pointer());
 	}
 
 	template <class T>
 	const T& Get() const {
-		if (!m_data) {
+		if (!m_ops) {
 			throw std::logic_error("Object is empty.");
 		}
-		if (typeid(T) != m_data->Type()) {
-			throw std::bad_cast("Types don't match.");
+		if (typeid(T) != m_ops->type()) {
+			throw std::bad_cast();
 		}
-		return *reinterpret_cast<const T*>(m_data->Get());
+		return *reinterpret_cast<const T*>(Pointer());
 	}
 
 	const void* Raw() const {
-		if (!m_data) {
+		if (!m_ops) {
 			throw std::logic_error("Object is empty.");
 		}
-		return m_data->Get();
+		return Pointer();
 	}
 
 	std::type_index Type() const {
-		if (!m_data) {
+		if (!m_ops) {
 			throw std::logic_error("Object is empty.");
 		}
-		return m_data->Type();
+		return m_ops->type();
 	}
+
+	/// <summary> Get the counters of memory operations since the start, or the last reset. </summary>
+	static AllocationStats GetAllocationStats();
+	/// <summary> Set all counters of memory operations to zero. </summary>
+	static void ResetAllocationStats();
 private:
-	std::unique_ptr<Data> m_data;
+	template <class T, class... Args>
+	void Construct(std::true_type, Args&&... args) {
+		new (m_storage.buffer) T(std::forward<Args>(args)...);
+		m_ops = &OpsFor<T>::ops;
+		CountInlineStore();
+	}
+
+	template <class T, class... Args>
+	void Construct(std::false_type, Args&&... args) {
+		void* block = impl::AnyPool::Allocate(sizeof(T));
+		try {
+			new (block) T(std::forward<Args>(args)...);
+		}
+		catch (...) {
+			impl::AnyPool::Deallocate(block, sizeof(T));
+			throw;
+		}
+		m_storage.block = block;
+		m_ops = &OpsFor<T>::ops;
+	}
+
+	void* Pointer() { return m_ops->isInline ? m_storage.buffer : m_storage.block; }
+	const void* Pointer() const { return m_ops->isInline ? m_storage.buffer : m_storage.block; }
+
+	static void CountClone();
+	static void CountInlineStore();
+private:
+	const Ops* m_ops = nullptr;
+	Storage m_storage;
+};
+
+
+template <class T>
+struct Any::OpsFor {
+	static const std::type_info& Type() {
+		return typeid(T);
+	}
+	static void Copy(const Storage& source, Storage& destination) {
+		CopyImpl(IsInline<T>{}, source, destination);
+	}
+	static void Destroy(Storage& storage) {
+		DestroyImpl(IsInline<T>{}, storage);
+	}
+
+	static void CopyImpl(std::true_type, const Storage& source, Storage& destination) {
+		std::memcpy(destination.buffer, source.buffer, sizeof(T));
+		CountInlineStore();
+	}
+	static void CopyImpl(std::false_type, const Storage& source, Storage& destination) {
+		void* block = impl::AnyPool::Allocate(sizeof(T));
+		try {
+			new (block) T(*reinterpret_cast<const T*>(source.block));
+		}
+		catch (...) {
+			impl::AnyPool::Deallocate(block, sizeof(T));
+			throw;
+		}
+		destination.block = block;
+	}
+	static void DestroyImpl(std::true_type, Storage&) {}
+	static void DestroyImpl(std::false_type, Storage& storage) {
+		reinterpret_cast<T*>(storage.block)->~T();
+		impl::AnyPool::Deallocate(storage.block, sizeof(T));
+	}
+
+	static const Ops ops;
+};
+
+
+template <class T>
+const Any::Ops Any::OpsFor<T>::ops = {
+	&OpsFor<T>::Type,
+	IsInline<T>::value,
+	&OpsFor<T>::Copy,
+	&OpsFor<T>::Destroy,
 };
 
 
 
-} // namespace exc
\ No newline at end of file
+} // namespace exc
@@ -0,0 +1,176 @@
+#include "BatchAnalyzer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <thread>
+
+
+namespace {
+
+// Finds the kicks in the beat track of BeatFinder, at the time in the file they are centred on.
+class BeatCollector
+	// sample rate, beat probability: kick, snare
+	: public exc::InputPortConfig<int, exc::StreamChunk>,
+	public exc::OutputPortConfig<>
+{
+public:
+	BeatCollector(float threshold, std::vector<double>& beats)
+		: m_threshold(threshold), m_beats(beats) {}
+
+	void Notify(exc::InputPortBase* sender) override {}
+	void Update() override {
+		exc::StreamWindow window = m_reader.Read(GetInput<1>().Get());
+		if (window.IsEmpty()) {
+			return;
+		}
+		const float* kick = window.GetSamples(0);
+		for (size_t i = 0; i < window.GetNumSamples(); ++i) {
+			if (!m_isBeat && kick[i] > m_threshold) {
+				m_isBeat = true;
+				m_beats.push_back(window.GetTimestamp().Advanced(int64_t(i)).GetSourceTime());
+			}
+			else if (m_isBeat && kick[i] < m_threshold * 0.5f) {
+				m_isBeat = false;
+			}
+		}
+	}
+private:
+	exc::StreamReader m_reader;
+	float m_threshold;
+	std::vector<double>& m_beats;
+	bool m_isBeat = false;
+};
+
+} // namespace
+
+
+BatchAnalyzer::BatchAnalyzer(LinkFunction link, size_t numThreads)
+	: m_link(std::move(link)),
+	m_numThreads(numThreads > 0 ? numThreads : std::max(1u, std::thread::hardware_concurrency()))
+{}
+
+
+auto BatchAnalyzer::Run(const std::vector<std::string>& paths, std::function<void(const Result&)> onResult) -> std::vector<Result> {
+	std::vector<Result> results(paths.size());
+	std::atomic<size_t> next(0);
+	std::mutex resultMutex;
+	std::exception_ptr exception;
+
+	auto work = [&] {
+		for (size_t index = next++; index < paths.size(); index = next++) {
+			results[index] = Analyze(paths[index]);
+			if (onResult) {
+				std::lock_guard<std::mutex> lock(resultMutex);
+				try {
+					onResult(results[index]);
+				}
+				catch (...) {
+					exception = std::current_exception();
+					next = paths.size();
+				}
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	size_t numWorkers = std::min(m_numThreads, paths.size());
+	for (size_t i = 1; i < numWorkers; ++i) {
+		workers.emplace_back(work);
+	}
+	work();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	if (exception) {
+		std::rethrow_exception(exception);
+	}
+	return results;
+}
+
+
+auto BatchAnalyzer::Analyze(const std::string& path) -> Result {
+	Result result;
+	result.path = path;
+	auto start = std::chrono::steady_clock::now();
+
+	try {
+		FileSource source(4410);
+		source.Open(path);
+		SplitStereo split;
+		DownSample decimate;
+		Wavelet wavelet;
+		BeatFinder beatFinder;
+		BeatCollector collector(m_beatThreshold, result.beats);
+		m_link(source, split, decimate, wavelet, beatFinder);
+		beatFinder.GetOutput(0)->Link(collector.GetInput(0));
+		beatFinder.GetOutput(1)->Link(collector.GetInput(1));
+
+		// the wavelet runs on the decimated signal, so that's the rate its tables are made for
+		size_t factor = decimate.GetInput<2>().Get();
+		std::shared_ptr<const Wavelet::Tables> tables = GetTables(wavelet.GetBands(), source.GetSampleRate() / int(factor));
+		wavelet.SwapTables(tables);
+
+		exc::SdfExecutor executor = {
+			&source,
+			&split,
+			&decimate,
+			&wavelet,
+			&beatFinder,
+			&collector,
+		};
+		executor.SetBlockSize(4410); // 100 ms of input, nothing waits for it, so larger blocks just mean less overhead
+		executor.SetEvaluationMode(exc::GraphExecutor::EvaluationMode::Pull);
+		executor.Compile();
+
+		while (!source.IsEndOfStream()) {
+			executor.Run();
+		}
+		// push the end of the file through the delay of the filters, and out of the last partial block
+		source.SetTailLength(decimate.GetKernelHistory() / 2 + wavelet.GetKernelHistory() / 2 * factor + executor.GetBlockSize());
+		while (!source.IsEndOfStream()) {
+			executor.Run();
+		}
+
+		result.duration = double(source.GetNumFrames()) / source.GetSampleRate();
+		auto end = std::remove_if(result.beats.begin(), result.beats.end(), [&result](double time) { return time >= result.duration; });
+		result.beats.erase(end, result.beats.end());
+	}
+	catch (std::exception& ex) {
+		result.beats.clear();
+		result.error = ex.what();
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	result.processingTime = elapsed.count();
+	return result;
+}
+
+
+auto BatchAnalyzer::GetTables(const std::vector<Wavelet::Band>& bands, int sampleRate) -> std::shared_ptr<const Wavelet::Tables> {
+	std::promise<std::shared_ptr<const Wavelet::Tables>> promise;
+	std::shared_future<std::shared_ptr<const Wavelet::Tables>> tables;
+	bool isPreparing = false;
+	{
+		std::lock_guard<std::mutex> lock(m_tablesMutex);
+		auto it = m_tables.find(sampleRate);
+		if (it == m_tables.end()) {
+			it = m_tables.emplace(sampleRate, promise.get_future().share()).first;
+			isPreparing = true;
+		}
+		tables = it->second;
+	}
+
+	// prepare outside the lock, so workers on files of other rates don't wait for it
+	if (isPreparing) {
+		try {
+			promise.set_value(Wavelet::PrepareTables(bands, sampleRate));
+		}
+		catch (...) {
+			promise.set_exception(std::current_exception());
+		}
+	}
+	return tables.get();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Node_FileSource.hpp"
+#include "Node_SplitStereo.hpp"
+#include "Node_DownSample.hpp"
+#include "Node_Wavelet.hpp"
+#include "Node_BeatFinder.hpp"
+
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+/// <summary>
+/// <para> Analyzes many files in parallel, faster than realtime. </para>
+/// <para>
+/// Worker threads take the next file from a shared queue and play it through a graph of their own,
+/// without pacing, then flush the delay of the filters with silence. Each file gets a fresh graph,
+/// so nothing carries over from the previous one. The wavelet filter banks are the only expensive part
+/// of building it; they are computed once per sample rate and shared by all workers.
+/// </para>
+/// </summary>
+class BatchAnalyzer {
+public:
+	/// <summary> Links the analysis nodes and sets them up. It must set the same bands on every call. </summary>
+	using LinkFunction = std::function<void(exc::NodeBase& source, SplitStereo& split, DownSample& decimate, Wavelet& wavelet, BeatFinder& beatFinder)>;
+
+	struct Result {
+		std::string path;
+		/// <summary> Length of the file in seconds. </summary>
+		double duration = 0.0;
+		/// <summary> Wall time spent on the file in seconds. </summary>
+		double processingTime = 0.0;
+		/// <summary> Kicks found, in seconds from the start of the file, corrected for the delay of the filters. </summary>
+		std::vector<double> beats;
+		/// <summary> Why the file could not be analyzed, empty on success. </summary>
+		std::string error;
+	};
+public:
+	/// <summary> Zero threads means one per hardware thread. </summary>
+	explicit BatchAnalyzer(LinkFunction link, size_t numThreads = 0);
+
+	/// <summary> A kick starts where the beat track rises above the threshold, and ends where it falls below half of it. </summary>
+	void SetBeatThreshold(float threshold) { m_beatThreshold = threshold; }
+	float GetBeatThreshold() const { return m_beatThreshold; }
+	size_t GetNumThreads() const { return m_numThreads; }
+
+	/// <summary> Analyze the files, and return the results in the same order. Files that fail don't stop the others. </summary>
+	/// <param name="onResult"> Called as soon as a file is done, from the worker threads, but only one call at a time. </param>
+	/// <exception cref="std::exception"> Exceptions from onResult are rethrown after the workers stopped. </exception>
+	std::vector<Result> Run(const std::vector<std::string>& paths, std::function<void(const Result&)> onResult = {});
+private:
+	Result Analyze(const std::string& path);
+	std::shared_ptr<const Wavelet::Tables> GetTables(const std::vector<Wavelet::Band>& bands, int sampleRate);
+private:
+	LinkFunction m_link;
+	size_t m_numThreads;
+	float m_beatThreshold = 0.5f;
+	// tables by sample rate, prepared by the first worker that needs them while the others wait on the future
+	std::mutex m_tablesMutex;
+	std::map<int, std::shared_future<std::shared_ptr<const Wavelet::Tables>>> m_tables;
+};
@@ -4,8 +4,10 @@
 #include <complex>
 
 
-float ScalarProductSimple(float* a, float* b, size_t dim);
-float ScalarProductAVX(float* a, float* b, size_t dim);
-float ScalarProduct(float* a, float* b, size_t dim);
+float ScalarProductSimple(const float* a, const float* b, size_t dim);
+float ScalarProductAVX(const float* a, const float* b, size_t dim);
+/// <summary> Dot product of two arrays. The result is the same wherever the arrays are in memory,
+///		so the same signal gives the same bits whichever buffer it is read from. </summary>
+float ScalarProduct(const float* a, const float* b, size_t dim);
 
-std::complex<float> ScalarProduct(float* ar, float* ai, float* b, size_t dim);
\ No newline at end of file
+std::complex<float> ScalarProduct(const float* ar, const float* ai, const float* b, size_t dim);
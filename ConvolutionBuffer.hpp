@@ -19,7 +19,7 @@ public:
 	size_t GetSize() const { return m_size; }
 
 
-	void AddSamples(float* samples, size_t count) {
+	void AddSamples(const float* samples, size_t count) {
 		ptrdiff_t space = m_bufferEnd - m_cursor;
 
 		if (count >= m_size) {
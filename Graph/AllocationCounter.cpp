@@ -0,0 +1,168 @@
+#include "AllocationCounter.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+
+namespace exc {
+
+
+namespace {
+
+std::atomic<uint64_t> numAllocations(0);
+thread_local uint64_t numThreadAllocations = 0;
+
+void Count() {
+	numAllocations.fetch_add(1, std::memory_order_relaxed);
+	++numThreadAllocations;
+}
+
+void* Allocate(size_t size) {
+	Count();
+	return std::malloc(size ? size : 1);
+}
+
+#ifdef __cpp_aligned_new
+void* AllocateAligned(size_t size, std::align_val_t alignment) {
+	Count();
+	size = size ? size : 1;
+#ifdef _WIN32
+	return _aligned_malloc(size, size_t(alignment));
+#else
+	// aligned_alloc wants the size to be a multiple of the alignment
+	size = (size + size_t(alignment) - 1) / size_t(alignment) * size_t(alignment);
+	return std::aligned_alloc(size_t(alignment), size);
+#endif
+}
+
+void FreeAligned(void* block) {
+#ifdef _WIN32
+	_aligned_free(block);
+#else
+	std::free(block);
+#endif
+}
+#endif
+
+} // namespace
+
+
+uint64_t AllocationCounter::GetNumAllocations() {
+	return numAllocations.load(std::memory_order_relaxed);
+}
+
+
+uint64_t AllocationCounter::GetNumThreadAllocations() {
+	return numThreadAllocations;
+}
+
+
+void AllocationCounter::RestoreNumThreadAllocations(uint64_t numAllocations) {
+	numThreadAllocations = numAllocations;
+}
+
+
+} // namespace exc
+
+
+
+//------------------------------------------------------------------------------
+// Replacements of the global allocation functions.
+//------------------------------------------------------------------------------
+
+void* operator new(size_t size) {
+	void* block = exc::Allocate(size);
+	if (!block) {
+		throw std::bad_alloc();
+	}
+	return block;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	return exc::Allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return exc::Allocate(size);
+}
+
+void operator delete(void* block) noexcept {
+	std::free(block);
+}
+
+void operator delete[](void* block) noexcept {
+	std::free(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+	std::free(block);
+}
+
+void operator delete[](void* block, size_t) noexcept {
+	std::free(block);
+}
+
+void operator delete(void* block, const std::nothrow_t&) noexcept {
+	std::free(block);
+}
+
+void operator delete[](void* block, const std::nothrow_t&) noexcept {
+	std::free(block);
+}
+
+
+#ifdef __cpp_aligned_new
+void* operator new(size_t size, std::align_val_t alignment) {
+	void* block = exc::AllocateAligned(size, alignment);
+	if (!block) {
+		throw std::bad_alloc();
+	}
+	return block;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return exc::AllocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return exc::AllocateAligned(size, alignment);
+}
+
+void operator delete(void* block, std::align_val_t) noexcept {
+	exc::FreeAligned(block);
+}
+
+void operator delete[](void* block, std::align_val_t) noexcept {
+	exc::FreeAligned(block);
+}
+
+void operator delete(void* block, size_t, std::align_val_t) noexcept {
+	exc::FreeAligned(block);
+}
+
+void operator delete[](void* block, size_t, std::align_val_t) noexcept {
+	exc::FreeAligned(block);
+}
+
+void operator delete(void* block, std::align_val_t, const std::nothrow_t&) noexcept {
+	exc::FreeAligned(block);
+}
+
+void operator delete[](void* block, std::align_val_t, const std::nothrow_t&) noexcept {
+	exc::FreeAligned(block);
+}
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+
+namespace exc {
+
+
+/// <summary>
+/// <para> Counts the heap allocations of the program. </para>
+/// <para>
+/// Replaces the global allocation functions, all forms of operator new and delete, including
+/// the nothrow and the over-aligned ones. Every allocation is counted, whichever code makes it.
+/// </para>
+/// </summary>
+class AllocationCounter {
+public:
+	/// <summary> Number of allocations made by all threads since the program started. </summary>
+	static uint64_t GetNumAllocations();
+	/// <summary> Number of allocations made by the calling thread since it started. </summary>
+	static uint64_t GetNumThreadAllocations();
+	/// <summary> Set the count of the calling thread back to an earlier value, so that bookkeeping
+	///		done since then is not attributed to the code being measured. The total is not changed. </summary>
+	static void RestoreNumThreadAllocations(uint64_t numAllocations);
+};
+
+
+} // namespace exc
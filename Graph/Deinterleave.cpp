@@ -0,0 +1,176 @@
+#include "Deinterleave.hpp"
+
+#include <immintrin.h>
+#include <cstdint>
+#include <cstring>
+
+
+namespace exc {
+
+
+namespace {
+
+constexpr float Int16Scale = 1.0f / 32768.0f;
+constexpr float Int24Scale = 1.0f / 8388608.0f;
+
+
+float LoadSample(const uint8_t* sample, SampleFormat format) {
+	switch (format) {
+		case SampleFormat::Int16: {
+			int16_t value;
+			memcpy(&value, sample, sizeof(value));
+			return value * Int16Scale;
+		}
+		case SampleFormat::Int24: {
+			// into the upper bytes, then back down so the sign is extended
+			int32_t value = int32_t(uint32_t(sample[0]) << 8 | uint32_t(sample[1]) << 16 | uint32_t(sample[2]) << 24) >> 8;
+			return value * Int24Scale;
+		}
+		default: {
+			float value;
+			memcpy(&value, sample, sizeof(value));
+			return value;
+		}
+	}
+}
+
+
+// Eight consecutive samples as floats.
+__m256 LoadRow(const uint8_t* samples, SampleFormat format) {
+	switch (format) {
+		case SampleFormat::Int16: {
+			__m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples));
+			__m128i low = _mm_cvtepi16_epi32(values);
+			__m128i high = _mm_cvtepi16_epi32(_mm_srli_si128(values, 8));
+			__m256i wide = _mm256_insertf128_si256(_mm256_castsi128_si256(low), high, 1);
+			return _mm256_mul_ps(_mm256_cvtepi32_ps(wide), _mm256_set1_ps(Int16Scale));
+		}
+		case SampleFormat::Int24: {
+			// each 3 byte sample into the upper bytes of a 32 bit lane, the shift extends the sign
+			const __m128i spread = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+			__m128i low = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(samples)), spread);
+			__m128i high = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + 12)), spread);
+			__m256i wide = _mm256_insertf128_si256(_mm256_castsi128_si256(_mm_srai_epi32(low, 8)), _mm_srai_epi32(high, 8), 1);
+			return _mm256_mul_ps(_mm256_cvtepi32_ps(wide), _mm256_set1_ps(Int24Scale));
+		}
+		default:
+			return _mm256_loadu_ps(reinterpret_cast<const float*>(samples));
+	}
+}
+
+
+// Number of bytes LoadRow reads, the 24 bit version reads a little past its samples.
+size_t GetRowSize(SampleFormat format) {
+	return format == SampleFormat::Int24 ? 28 : 8 * GetSampleSize(format);
+}
+
+
+void Transpose8x8(__m256 (&rows)[8]) {
+	__m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+	__m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+	__m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+	__m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+	__m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+	__m256 t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+	__m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+	__m256 t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+	__m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+	rows[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+	rows[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+	rows[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+	rows[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+	rows[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+	rows[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+	rows[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+	rows[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+} // namespace
+
+
+size_t GetSampleSize(SampleFormat format) {
+	switch (format) {
+		case SampleFormat::Int16: return 2;
+		case SampleFormat::Int24: return 3;
+		default: return 4;
+	}
+}
+
+
+void DeinterleaveSimple(const void* frames, SampleFormat format, size_t numChannels, size_t numFrames, float* const* channels) {
+	const uint8_t* data = static_cast<const uint8_t*>(frames);
+	size_t sampleSize = GetSampleSize(format);
+	size_t frameSize = numChannels * sampleSize;
+	for (size_t channel = 0; channel < numChannels; ++channel) {
+		const uint8_t* sample = data + channel * sampleSize;
+		float* output = channels[channel];
+		for (size_t i = 0; i < numFrames; ++i, sample += frameSize) {
+			output[i] = LoadSample(sample, format);
+		}
+	}
+}
+
+
+void DeinterleaveAVX(const void* frames, SampleFormat format, size_t numChannels, size_t numFrames, float* const* channels) {
+	if (numChannels != 2 && numChannels != 6 && numChannels != 8) {
+		DeinterleaveSimple(frames, format, numChannels, numFrames, channels);
+		return;
+	}
+
+	const uint8_t* data = static_cast<const uint8_t*>(frames);
+	size_t frameSize = numChannels * GetSampleSize(format);
+	size_t size = numFrames * frameSize;
+	size_t i = 0;
+
+	if (numChannels == 2) {
+		// 8 frames are two rows, regroup their 128 bit halves, then pick the even and the odd samples
+		size_t reach = 4 * frameSize + GetRowSize(format);
+		for (; i + 8 <= numFrames && i * frameSize + reach <= size; i += 8) {
+			const uint8_t* block = data + i * frameSize;
+			__m256 first = LoadRow(block, format);
+			__m256 second = LoadRow(block + 4 * frameSize, format);
+			__m256 low = _mm256_permute2f128_ps(first, second, 0x20);
+			__m256 high = _mm256_permute2f128_ps(first, second, 0x31);
+			_mm256_storeu_ps(channels[0] + i, _mm256_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm256_storeu_ps(channels[1] + i, _mm256_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+	}
+	else {
+		// a row of 8 samples per frame, 6 channel rows reach into the next frame, that part is ignored
+		size_t reach = 7 * frameSize + GetRowSize(format);
+		for (; i + 8 <= numFrames && i * frameSize + reach <= size; i += 8) {
+			const uint8_t* block = data + i * frameSize;
+			__m256 rows[8];
+			for (size_t frame = 0; frame < 8; ++frame) {
+				rows[frame] = LoadRow(block + frame * frameSize, format);
+			}
+			Transpose8x8(rows);
+			for (size_t channel = 0; channel < numChannels; ++channel) {
+				_mm256_storeu_ps(channels[channel] + i, rows[channel]);
+			}
+		}
+	}
+
+	if (i < numFrames) {
+		float* rest[8];
+		for (size_t channel = 0; channel < numChannels; ++channel) {
+			rest[channel] = channels[channel] + i;
+		}
+		DeinterleaveSimple(data + i * frameSize, format, numChannels, numFrames - i, rest);
+	}
+}
+
+
+void Deinterleave(const void* frames, SampleFormat format, size_t numChannels, size_t numFrames, float* const* channels) {
+	DeinterleaveAVX(frames, format, numChannels, numFrames, channels);
+}
+
+
+} // namespace exc
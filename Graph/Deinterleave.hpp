@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+
+namespace exc {
+
+
+enum class SampleFormat {
+	Int16,
+	Int24,
+	Float32,
+};
+
+/// <summary> Size of one sample in bytes. </summary>
+size_t GetSampleSize(SampleFormat format);
+
+void DeinterleaveSimple(const void* frames, SampleFormat format, size_t numChannels, size_t numFrames, float* const* channels);
+/// <summary> Vectorized for 2, 6 and 8 channels, other channel counts fall back to the simple version. </summary>
+void DeinterleaveAVX(const void* frames, SampleFormat format, size_t numChannels, size_t numFrames, float* const* channels);
+/// <summary> Convert interleaved little-endian frames into a float array per channel. Integers are scaled to [-1, 1).
+///		The frames don't have to be aligned, and the channel arrays may be anywhere. </summary>
+void Deinterleave(const void* frames, SampleFormat format, size_t numChannels, size_t numFrames, float* const* channels);
+
+
+} // namespace exc
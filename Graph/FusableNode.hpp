@@ -0,0 +1,65 @@
+#pragma once
+
+#include "MultiRateNode.hpp"
+#include "SampleStream.hpp"
+
+#include <cstddef>
+
+
+namespace exc {
+
+
+/// <summary> A stream output written by a kernel, and the number of channels the kernel writes to it. </summary>
+struct KernelOutput {
+	size_t port;
+	size_t numChannels;
+};
+
+
+/// <summary>
+/// <para> Interface for multi-rate nodes whose stream processing can run inside a fused stage. </para>
+/// <para>
+/// The node's work on its stream is a kernel: it maps the new samples of one stream input, preceded by
+/// a fixed history, to samples on one or more stream outputs. The kernel must give the same results however
+/// the samples are split into calls, which it can keep track of between calls, such as a decimation phase.
+/// The node's own Update() runs the kernel on the whole window it reads.
+/// </para>
+/// <para>
+/// An <see cref="SdfExecutor"/> merges chains of such nodes into a single pass over each block. The kernels
+/// are called tile by tile, and the samples passed from one kernel to the next stay in small buffers,
+/// instead of going through the stream of the output that links them. Outputs read outside the chain
+/// are still written through GetKernelWriter(), so the rest of the graph sees the same streams.
+/// </para>
+/// </summary>
+class FusableNode : public MultiRateNode {
+public:
+	/// <summary> Index of the stream input the kernel processes. </summary>
+	virtual size_t GetKernelInput() const = 0;
+	/// <summary> Called before every block. Read the other inputs, set the other outputs,
+	///		and set up the kernel for the number of channels on its input. </summary>
+	virtual void BeginKernel(size_t numInputChannels) = 0;
+	/// <summary> Read the new samples of the kernel input, preceded by GetKernelHistory() samples. </summary>
+	virtual StreamWindow ReadKernelInput() = 0;
+
+	/// <summary> Number of samples before the new ones the kernel looks at. Valid after BeginKernel(). </summary>
+	virtual size_t GetKernelHistory() const = 0;
+	/// <summary> Number of stream outputs the kernel writes. </summary>
+	virtual size_t GetNumKernelOutputs() const = 0;
+	/// <summary> The port of a kernel output never changes, the number of channels is valid after BeginKernel(). </summary>
+	virtual KernelOutput GetKernelOutput(size_t index) const = 0;
+	/// <summary> The writer of a kernel output's stream. </summary>
+	virtual StreamWriter& GetKernelWriter(size_t index) = 0;
+
+	/// <summary> Timestamp of the first sample the next RunKernel() call writes to the kernel outputs, given that of the
+	///		first new input sample. Nodes that delay or decimate the input override it, the default passes it on. </summary>
+	virtual StreamTimestamp GetKernelTimestamp(const StreamTimestamp& input) const { return input; }
+
+	/// <summary> Process new samples. </summary>
+	/// <param name="input"> One pointer per input channel, to the oldest history sample. The new samples follow the history. </param>
+	/// <param name="output"> One pointer per output channel, the channels of all kernel outputs one after the other. </param>
+	/// <returns> The number of samples written to each output channel. </returns>
+	virtual size_t RunKernel(const float* const* input, size_t numSamples, float* const* output) = 0;
+};
+
+
+} // namespace exc
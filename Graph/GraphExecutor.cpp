@@ -0,0 +1,248 @@
+#include "GraphExecutor.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+
+
+namespace exc {
+
+
+GraphExecutor::GraphExecutor(std::initializer_list<NodeBase*> nodes) {
+	for (auto node : nodes) {
+		AddNode(node);
+	}
+}
+
+
+void GraphExecutor::AddNode(NodeBase* node) {
+	if (std::find(m_nodes.begin(), m_nodes.end(), node) == m_nodes.end()) {
+		m_nodes.push_back(node);
+		Invalidate();
+	}
+}
+
+
+void GraphExecutor::RemoveNode(NodeBase* node) {
+	auto it = std::find(m_nodes.begin(), m_nodes.end(), node);
+	if (it != m_nodes.end()) {
+		m_nodes.erase(it);
+		Invalidate();
+	}
+}
+
+
+void GraphExecutor::Clear() {
+	m_nodes.clear();
+	Invalidate();
+}
+
+
+const std::vector<NodeBase*>& GraphExecutor::GetNodes() const {
+	return m_nodes;
+}
+
+
+void GraphExecutor::Compile() {
+	// let derived executors undo whatever they did to the network for the previous schedule
+	Invalidate();
+
+	const size_t numNodes = m_nodes.size();
+
+	// find which node owns each output port
+	std::unordered_map<const OutputPortBase*, size_t> outputOwners;
+	for (size_t i = 0; i < numNodes; ++i) {
+		for (size_t p = 0; p < m_nodes[i]->GetNumOutputs(); ++p) {
+			outputOwners[m_nodes[i]->GetOutput(p)] = i;
+		}
+	}
+
+	// collect the edges: a node depends on the owners of the outputs its inputs are linked to
+	std::vector<std::vector<size_t>> successors(numNodes);
+	std::vector<size_t> numPredecessors(numNodes, 0);
+	for (size_t i = 0; i < numNodes; ++i) {
+		for (size_t p = 0; p < m_nodes[i]->GetNumInputs(); ++p) {
+			auto it = outputOwners.find(m_nodes[i]->GetInput(p)->GetLink());
+			if (it != outputOwners.end()) {
+				successors[it->second].push_back(i);
+			}
+		}
+	}
+	for (auto& list : successors) {
+		std::sort(list.begin(), list.end());
+		list.erase(std::unique(list.begin(), list.end()), list.end());
+		for (auto s : list) {
+			++numPredecessors[s];
+		}
+	}
+
+	// topological sort, ties are broken by the order the nodes were added
+	std::vector<size_t> remaining = numPredecessors;
+	std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> ready;
+	for (size_t i = 0; i < numNodes; ++i) {
+		if (remaining[i] == 0) {
+			ready.push(i);
+		}
+	}
+	std::vector<size_t> order;
+	order.reserve(numNodes);
+	while (!ready.empty()) {
+		size_t current = ready.top();
+		ready.pop();
+		order.push_back(current);
+		for (auto s : successors[current]) {
+			if (--remaining[s] == 0) {
+				ready.push(s);
+			}
+		}
+	}
+
+	if (order.size() != numNodes) {
+		std::string message = "Graph contains a cycle, involving these nodes:";
+		for (size_t i = 0; i < numNodes; ++i) {
+			if (remaining[i] != 0) {
+				message += " ";
+				message += typeid(*m_nodes[i]).name();
+				message += "@" + std::to_string(i);
+			}
+		}
+		throw std::logic_error(message);
+	}
+
+	// translate the graph to schedule indices
+	std::vector<size_t> position(numNodes);
+	for (size_t i = 0; i < numNodes; ++i) {
+		position[order[i]] = i;
+	}
+	m_schedule.clear();
+	m_schedule.reserve(numNodes);
+	for (auto index : order) {
+		ScheduledNode entry;
+		entry.node = m_nodes[index];
+		entry.numPredecessors = numPredecessors[index];
+		for (auto s : successors[index]) {
+			entry.successors.push_back(position[s]);
+		}
+		std::sort(entry.successors.begin(), entry.successors.end());
+		m_schedule.push_back(std::move(entry));
+	}
+
+	// nothing has been seen yet, so every node is updated on the first tick
+	m_inputStates.clear();
+	m_inputStates.reserve(numNodes);
+	for (auto& entry : m_schedule) {
+		InputState state;
+		state.isSource = true;
+		for (size_t p = 0; p < entry.node->GetNumInputs(); ++p) {
+			const InputPortBase* port = entry.node->GetInput(p);
+			state.ports.push_back(port);
+			state.seenVersions.push_back(port->GetVersion() - 1);
+			state.isSource = state.isSource && port->GetLink() == nullptr;
+		}
+		state.alwaysUpdate = m_alwaysUpdate.count(entry.node) > 0;
+		m_inputStates.push_back(std::move(state));
+	}
+	m_numSkipped.reset(new std::atomic<uint64_t>[numNodes]());
+
+	m_isCompiled = true;
+	OnCompiled();
+}
+
+
+void GraphExecutor::Invalidate() {
+	m_isCompiled = false;
+	m_schedule.clear();
+	OnInvalidated();
+	// derived executors may still update nodes until they are done with OnInvalidated
+	m_inputStates.clear();
+	m_numSkipped.reset();
+}
+
+
+bool GraphExecutor::IsCompiled() const {
+	return m_isCompiled;
+}
+
+
+auto GraphExecutor::GetSchedule() const -> const std::vector<ScheduledNode>& {
+	return m_schedule;
+}
+
+
+void GraphExecutor::SetEvaluationMode(EvaluationMode mode) {
+	m_evaluationMode = mode;
+}
+
+
+auto GraphExecutor::GetEvaluationMode() const -> EvaluationMode {
+	return m_evaluationMode;
+}
+
+
+void GraphExecutor::SetAlwaysUpdate(NodeBase* node, bool alwaysUpdate) {
+	if (alwaysUpdate) {
+		m_alwaysUpdate.insert(node);
+	}
+	else {
+		m_alwaysUpdate.erase(node);
+	}
+	for (size_t i = 0; i < m_inputStates.size(); ++i) {
+		if (m_schedule[i].node == node) {
+			m_inputStates[i].alwaysUpdate = alwaysUpdate;
+		}
+	}
+}
+
+
+uint64_t GraphExecutor::GetNumSkipped(NodeBase* node) const {
+	for (size_t i = 0; i < m_schedule.size(); ++i) {
+		if (m_schedule[i].node == node) {
+			return m_numSkipped[i].load(std::memory_order_relaxed);
+		}
+	}
+	throw std::invalid_argument("Node is not in the schedule.");
+}
+
+
+bool GraphExecutor::ShouldUpdate(size_t index) {
+	if (m_evaluationMode == EvaluationMode::Push) {
+		return true;
+	}
+
+	// versions must be recorded even if the node is updated anyway, so the next tick compares to them
+	InputState& state = m_inputStates[index];
+	bool hasNewData = false;
+	for (size_t p = 0; p < state.ports.size(); ++p) {
+		uint64_t version = state.ports[p]->GetVersion();
+		if (version != state.seenVersions[p]) {
+			state.seenVersions[p] = version;
+			hasNewData = true;
+		}
+	}
+
+	if (hasNewData || state.isSource || state.alwaysUpdate) {
+		return true;
+	}
+	m_numSkipped[index].fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+
+void GraphExecutor::Run() {
+	if (!m_isCompiled) {
+		Compile();
+	}
+	for (size_t i = 0; i < m_schedule.size(); ++i) {
+		if (ShouldUpdate(i)) {
+			GRAPH_PROFILE_UPDATE(m_schedule[i].node);
+			m_schedule[i].node->Update();
+		}
+	}
+}
+
+
+} // namespace exc
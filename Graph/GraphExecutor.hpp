@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Node.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <set>
+#include <vector>
+
+
+namespace exc {
+
+
+/// <summary>
+/// <para> Updates a network of nodes in an order that respects their links. </para>
+/// <para>
+/// Add the nodes of the network to the executor, then call Run() once per tick.
+/// The executor walks the links between the ports of the added nodes and
+/// computes a schedule where every node is updated after all nodes it
+/// receives data from. Links to nodes that were not added are ignored.
+/// </para>
+/// <para>
+/// The schedule is computed once and cached. Adding or removing nodes discards it,
+/// but the executor cannot see links changing: call Invalidate() after relinking.
+/// </para>
+/// <para>
+/// In pull mode, a node is only updated if any of its input ports received data since
+/// its previous update, otherwise its outputs keep the last results. Nodes that have
+/// no linked inputs are sources, and are always updated. Sinks that must run every tick,
+/// like displays, can be marked with SetAlwaysUpdate().
+/// </para>
+/// </summary>
+class GraphExecutor {
+public:
+	/// <summary> An entry of the compiled schedule. </summary>
+	struct ScheduledNode {
+		NodeBase* node;
+		/// <summary> Indices of the schedule entries that receive data from this node. </summary>
+		std::vector<size_t> successors;
+		/// <summary> Number of schedule entries this node receives data from. </summary>
+		size_t numPredecessors;
+	};
+
+	/// <summary> Decides which nodes are updated on a tick. </summary>
+	enum class EvaluationMode {
+		/// <summary> Update every node on every tick. </summary>
+		Push,
+		/// <summary> Update only sources and the nodes that have new input data. </summary>
+		Pull,
+	};
+public:
+	GraphExecutor() = default;
+	GraphExecutor(std::initializer_list<NodeBase*> nodes);
+	GraphExecutor(const GraphExecutor&) = delete;
+	GraphExecutor& operator=(const GraphExecutor&) = delete;
+	virtual ~GraphExecutor() = default;
+
+	/// <summary> Add a node to the network. Adding the same node twice has no effect. </summary>
+	void AddNode(NodeBase* node);
+	/// <summary> Remove a node from the network. </summary>
+	void RemoveNode(NodeBase* node);
+	/// <summary> Remove all nodes. </summary>
+	void Clear();
+	/// <summary> Get the nodes added to the executor. </summary>
+	const std::vector<NodeBase*>& GetNodes() const;
+
+	/// <summary> Compute the schedule from the current links. </summary>
+	/// <exception cref="std::logic_error"> The links form a cycle. </exception>
+	void Compile();
+	/// <summary> Discard the schedule, it will be recomputed on the next Run(). </summary>
+	void Invalidate();
+	/// <summary> True if the schedule is up to date. </summary>
+	bool IsCompiled() const;
+	/// <summary> Get the compiled schedule in execution order. Empty until compiled. </summary>
+	const std::vector<ScheduledNode>& GetSchedule() const;
+
+	/// <summary> Set which nodes are updated on a tick. The default is push mode. </summary>
+	void SetEvaluationMode(EvaluationMode mode);
+	/// <summary> Get which nodes are updated on a tick. </summary>
+	EvaluationMode GetEvaluationMode() const;
+	/// <summary> Update the node on every tick in pull mode, even if it has no new input data. </summary>
+	void SetAlwaysUpdate(NodeBase* node, bool alwaysUpdate = true);
+	/// <summary> Get how many times the node was skipped in pull mode since the schedule was compiled. </summary>
+	/// <exception cref="std::invalid_argument"> The node is not in the schedule. </exception>
+	uint64_t GetNumSkipped(NodeBase* node) const;
+
+	/// <summary> Update each node once, in schedule order. Compiles the schedule if needed. </summary>
+	virtual void Run();
+protected:
+	/// <summary> Tells if the node at the schedule index has to be updated on this tick,
+	///		and counts it as skipped if not. Call it exactly once per node per tick. </summary>
+	bool ShouldUpdate(size_t index);
+
+	/// <summary> Called after a new schedule has been computed. </summary>
+	virtual void OnCompiled() {}
+	/// <summary> Called when the schedule is discarded, and before it is recomputed. </summary>
+	virtual void OnInvalidated() {}
+protected:
+	std::vector<NodeBase*> m_nodes;
+	std::vector<ScheduledNode> m_schedule;
+	bool m_isCompiled = false;
+private:
+	// Input versions seen by the last update of a scheduled node.
+	struct InputState {
+		std::vector<const InputPortBase*> ports;
+		std::vector<uint64_t> seenVersions;
+		bool isSource;
+		bool alwaysUpdate;
+	};
+
+	EvaluationMode m_evaluationMode = EvaluationMode::Push;
+	std::set<NodeBase*> m_alwaysUpdate;
+	std::vector<InputState> m_inputStates;
+	std::unique_ptr<std::atomic<uint64_t>[]> m_numSkipped;
+};
+
+
+} // namespace exc
@@ -0,0 +1,165 @@
+#include "GraphInstance.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+
+namespace exc {
+
+
+namespace {
+
+constexpr size_t MinChunkSize = 16 * 1024;
+
+} // namespace
+
+
+GraphInstance& GraphInstance::operator=(GraphInstance&& rhs) {
+	if (this != &rhs) {
+		Clear();
+		m_chunks = std::move(rhs.m_chunks);
+		m_nodes = std::move(rhs.m_nodes);
+		m_isInArena = std::move(rhs.m_isInArena);
+		m_names = std::move(rhs.m_names);
+		m_indices = std::move(rhs.m_indices);
+	}
+	return *this;
+}
+
+
+GraphInstance::~GraphInstance() {
+	Clear();
+}
+
+
+NodeBase* GraphInstance::CreateNode(const NodeFactory::NodeInfo& info, const std::string& name) {
+	if (m_indices.count(name) > 0) {
+		throw std::invalid_argument("Node name \"" + name + "\" is already used.");
+	}
+
+	// a node that throws from its constructor just leaves a hole in the arena
+	void* place = Allocate(info.size, info.alignment);
+	NodeBase* node = info.construct(place);
+	try {
+		Register(node, name, true);
+	}
+	catch (...) {
+		node->~NodeBase();
+		throw;
+	}
+	return node;
+}
+
+
+NodeBase* GraphInstance::AddNode(std::unique_ptr<NodeBase> node, const std::string& name) {
+	if (!node) {
+		throw std::invalid_argument("Node is null.");
+	}
+	if (m_indices.count(name) > 0) {
+		throw std::invalid_argument("Node name \"" + name + "\" is already used.");
+	}
+
+	Register(node.get(), name, false);
+	return node.release();
+}
+
+
+void GraphInstance::Reserve(size_t numBytes) {
+	if (!m_chunks.empty() && m_chunks.back().size - m_chunks.back().used >= numBytes) {
+		return;
+	}
+	Chunk chunk;
+	chunk.size = std::max(numBytes, MinChunkSize);
+	chunk.used = 0;
+	chunk.memory.reset(new unsigned char[chunk.size]);
+	m_chunks.push_back(std::move(chunk));
+}
+
+
+size_t GraphInstance::GetArenaSize() const {
+	size_t size = 0;
+	for (auto& chunk : m_chunks) {
+		size += chunk.used;
+	}
+	return size;
+}
+
+
+size_t GraphInstance::GetArenaCapacity() const {
+	size_t capacity = 0;
+	for (auto& chunk : m_chunks) {
+		capacity += chunk.size;
+	}
+	return capacity;
+}
+
+
+NodeBase* GraphInstance::GetNode(const std::string& name) const {
+	auto it = m_indices.find(name);
+	return it != m_indices.end() ? m_nodes[it->second] : nullptr;
+}
+
+
+const std::vector<NodeBase*>& GraphInstance::GetNodes() const {
+	return m_nodes;
+}
+
+
+const std::string& GraphInstance::GetName(size_t index) const {
+	return m_names.at(index);
+}
+
+
+size_t GraphInstance::GetNumNodes() const {
+	return m_nodes.size();
+}
+
+
+void GraphInstance::Clear() {
+	// later nodes usually receive data from earlier ones, so unlinking goes from the sinks up
+	for (size_t i = m_nodes.size(); i-- > 0;) {
+		if (m_isInArena[i]) {
+			m_nodes[i]->~NodeBase();
+		}
+		else {
+			delete m_nodes[i];
+		}
+	}
+	m_nodes.clear();
+	m_isInArena.clear();
+	m_names.clear();
+	m_indices.clear();
+	m_chunks.clear();
+}
+
+
+void* GraphInstance::Allocate(size_t size, size_t alignment) {
+	// padding for the alignment is reserved up front, the block itself is only aligned for fundamental types
+	Reserve(size + alignment - 1);
+	Chunk& chunk = m_chunks.back();
+	uintptr_t address = reinterpret_cast<uintptr_t>(chunk.memory.get()) + chunk.used;
+	uintptr_t aligned = (address + alignment - 1) / alignment * alignment;
+	chunk.used += (aligned - address) + size;
+	return reinterpret_cast<void*>(aligned);
+}
+
+
+void GraphInstance::Register(NodeBase* node, const std::string& name, bool isInArena) {
+	// the caller still owns the node if this throws
+	m_nodes.push_back(node);
+	try {
+		m_isInArena.push_back(isInArena);
+		m_names.push_back(name);
+		m_indices.insert({ name, m_nodes.size() - 1 });
+	}
+	catch (...) {
+		m_nodes.resize(m_indices.size());
+		m_isInArena.resize(m_indices.size());
+		m_names.resize(m_indices.size());
+		throw;
+	}
+}
+
+
+} // namespace exc
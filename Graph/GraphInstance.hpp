@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Node.hpp"
+#include "NodeFactory.hpp"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace exc {
+
+
+/// <summary>
+/// <para> Owns the nodes of a network built at runtime, for example by a <see cref="GraphLoader"/>. </para>
+/// <para>
+/// Nodes are kept in the order they were added, and can be looked up by their instance name.
+/// Pass GetNodes() to an executor to run the network. The nodes are destroyed together with the
+/// instance, in reverse order, and they unlink themselves from everything they were linked to.
+/// </para>
+/// <para>
+/// Nodes created by CreateNode() are placed next to each other in an arena owned by the instance,
+/// so walking the schedule touches contiguous memory. Reserve() the total size of the nodes
+/// beforehand to get a single block. The arena is released at once when the instance is cleared.
+/// </para>
+/// </summary>
+class GraphInstance {
+public:
+	GraphInstance() = default;
+	GraphInstance(const GraphInstance&) = delete;
+	GraphInstance(GraphInstance&&) = default;
+	GraphInstance& operator=(const GraphInstance&) = delete;
+	GraphInstance& operator=(GraphInstance&&);
+	~GraphInstance();
+
+	/// <summary> Construct a node of the described class in the arena. </summary>
+	/// <exception cref="std::invalid_argument"> The name is already used. </exception>
+	NodeBase* CreateNode(const NodeFactory::NodeInfo& info, const std::string& name);
+	/// <summary> Take ownership of a node allocated on the heap. </summary>
+	/// <exception cref="std::invalid_argument"> The node is null, or the name is already used. </exception>
+	NodeBase* AddNode(std::unique_ptr<NodeBase> node, const std::string& name);
+
+	/// <summary> Make sure the arena has a contiguous block of at least numBytes free. </summary>
+	void Reserve(size_t numBytes);
+	/// <summary> Returns the number of bytes of the arena used by nodes. </summary>
+	size_t GetArenaSize() const;
+	/// <summary> Returns the number of bytes allocated for the arena. </summary>
+	size_t GetArenaCapacity() const;
+
+	/// <summary> Get a node by its instance name. </summary>
+	/// <returns> The node, or null if there's no such node. </returns>
+	NodeBase* GetNode(const std::string& name) const;
+	/// <summary> Get all nodes in the order they were added. </summary>
+	const std::vector<NodeBase*>& GetNodes() const;
+	/// <summary> Get the instance name of a node by its index. </summary>
+	const std::string& GetName(size_t index) const;
+	/// <summary> Returns the number of nodes. </summary>
+	size_t GetNumNodes() const;
+
+	/// <summary> Destroy all nodes and release the arena. </summary>
+	void Clear();
+private:
+	struct Chunk {
+		std::unique_ptr<unsigned char[]> memory;
+		size_t size;
+		size_t used;
+	};
+
+	void* Allocate(size_t size, size_t alignment);
+	void Register(NodeBase* node, const std::string& name, bool isInArena);
+private:
+	std::vector<Chunk> m_chunks;
+	std::vector<NodeBase*> m_nodes;
+	std::vector<bool> m_isInArena;
+	std::vector<std::string> m_names;
+	std::unordered_map<std::string, size_t> m_indices;
+};
+
+
+} // namespace exc
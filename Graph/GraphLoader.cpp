@@ -0,0 +1,638 @@
+#include "GraphLoader.hpp"
+
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+
+namespace exc {
+
+
+namespace {
+
+const char BinaryMagic[4] = { 'E', 'X', 'G', 'R' };
+constexpr uint32_t BinaryVersion = 1;
+
+// type tags of parameters in the binary format
+enum class ValueTag : uint8_t {
+	Int = 0,
+	Float = 1,
+	Double = 2,
+	Bool = 3,
+	String = 4,
+};
+
+
+//------------------------------------------------------------------------------
+// Text helpers
+//------------------------------------------------------------------------------
+
+std::runtime_error LineError(size_t line, const std::string& message) {
+	return std::runtime_error("Line " + std::to_string(line) + ": " + message);
+}
+
+
+// Splits a line into tokens at whitespace. Quoted strings are a single token, quotes included.
+std::vector<std::string> Tokenize(const std::string& line, size_t lineNumber) {
+	std::vector<std::string> tokens;
+	size_t i = 0;
+	while (i < line.size()) {
+		char c = line[i];
+		if (c == '#') {
+			break;
+		}
+		else if (std::isspace((unsigned char)c)) {
+			++i;
+		}
+		else if (c == '"') {
+			std::string token = "\"";
+			++i;
+			while (i < line.size() && line[i] != '"') {
+				if (line[i] == '\\' && i + 1 < line.size()) {
+					++i;
+				}
+				token += line[i];
+				++i;
+			}
+			if (i == line.size()) {
+				throw LineError(lineNumber, "missing closing quote.");
+			}
+			token += '"';
+			++i;
+			tokens.push_back(std::move(token));
+		}
+		else {
+			size_t begin = i;
+			while (i < line.size() && !std::isspace((unsigned char)line[i]) && line[i] != '#') {
+				++i;
+			}
+			tokens.push_back(line.substr(begin, i - begin));
+		}
+	}
+	return tokens;
+}
+
+
+// Port names in node infos may carry a description after a colon.
+std::string PortName(const std::string& infoName) {
+	return infoName.substr(0, infoName.find(':'));
+}
+
+
+bool ParseIndex(const std::string& token, size_t& index) {
+	if (token.empty() || token.find_first_not_of("0123456789") != std::string::npos) {
+		return false;
+	}
+	index = (size_t)std::strtoull(token.c_str(), nullptr, 10);
+	return true;
+}
+
+
+bool ParseDouble(const std::string& token, double& value) {
+	char* end = nullptr;
+	value = std::strtod(token.c_str(), &end);
+	return !token.empty() && end == token.c_str() + token.size();
+}
+
+
+Any ParseValue(const std::string& token, std::type_index type, size_t lineNumber) {
+	bool isString = token.size() >= 2 && token.front() == '"' && token.back() == '"';
+	double number = 0.0;
+	bool isNumber = !isString && ParseDouble(token, number);
+	bool isBool = token == "true" || token == "false";
+
+	// ports of any type get the literal's own type
+	if (type == typeid(Any)) {
+		if (isString) {
+			type = typeid(std::string);
+		}
+		else if (isBool) {
+			type = typeid(bool);
+		}
+		else if (isNumber && token.find_first_of(".eE") == std::string::npos) {
+			type = typeid(int);
+		}
+		else {
+			type = typeid(float);
+		}
+	}
+
+	if (type == typeid(std::string)) {
+		if (!isString) {
+			throw LineError(lineNumber, "expected a quoted string instead of " + token + ".");
+		}
+		return Any(token.substr(1, token.size() - 2));
+	}
+	if (type == typeid(bool)) {
+		if (isBool) {
+			return Any(token == "true");
+		}
+		if (isNumber && (number == 0.0 || number == 1.0)) {
+			return Any(number != 0.0);
+		}
+		throw LineError(lineNumber, "expected true or false instead of " + token + ".");
+	}
+	if (!isNumber) {
+		throw LineError(lineNumber, "expected a number instead of " + token + ".");
+	}
+	if (type == typeid(int)) {
+		if (number != (double)(int)number) {
+			throw LineError(lineNumber, token + " is not an integer.");
+		}
+		return Any((int)number);
+	}
+	if (type == typeid(float)) {
+		return Any(std::strtof(token.c_str(), nullptr));
+	}
+	if (type == typeid(double)) {
+		return Any(number);
+	}
+	throw LineError(lineNumber, std::string("parameters cannot be set on ports of type ") + type.name() + ".");
+}
+
+
+std::string FormatValue(const Any& value) {
+	std::ostringstream ss;
+	ss << std::setprecision(std::numeric_limits<double>::max_digits10);
+	if (value.Type() == typeid(int)) {
+		ss << value.Get<int>();
+	}
+	else if (value.Type() == typeid(float)) {
+		ss << std::setprecision(std::numeric_limits<float>::max_digits10) << value.Get<float>();
+		// keep it a float literal for any-type ports
+		if (ss.str().find_first_of(".eEn") == std::string::npos) {
+			ss << ".0";
+		}
+	}
+	else if (value.Type() == typeid(double)) {
+		ss << value.Get<double>();
+		if (ss.str().find_first_of(".eEn") == std::string::npos) {
+			ss << ".0";
+		}
+	}
+	else if (value.Type() == typeid(bool)) {
+		ss << (value.Get<bool>() ? "true" : "false");
+	}
+	else if (value.Type() == typeid(std::string)) {
+		ss << '"';
+		for (char c : value.Get<std::string>()) {
+			if (c == '"' || c == '\\') {
+				ss << '\\';
+			}
+			ss << c;
+		}
+		ss << '"';
+	}
+	else {
+		throw std::invalid_argument(std::string("Parameters of type ") + value.Type().name() + " are not supported.");
+	}
+	return ss.str();
+}
+
+
+//------------------------------------------------------------------------------
+// Binary helpers
+//------------------------------------------------------------------------------
+
+class BinaryReader {
+public:
+	explicit BinaryReader(std::vector<char> data) : m_data(std::move(data)), m_position(0) {}
+
+	const char* Read(size_t size) {
+		if (m_data.size() - m_position < size) {
+			throw std::runtime_error("Graph description is truncated.");
+		}
+		const char* bytes = m_data.data() + m_position;
+		m_position += size;
+		return bytes;
+	}
+	uint8_t ReadU8() {
+		return (uint8_t)*Read(1);
+	}
+	uint32_t ReadU32() {
+		auto bytes = reinterpret_cast<const unsigned char*>(Read(4));
+		return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+	}
+	uint64_t ReadU64() {
+		uint64_t low = ReadU32();
+		uint64_t high = ReadU32();
+		return low | high << 32;
+	}
+	std::string ReadString() {
+		uint32_t size = ReadU32();
+		return std::string(Read(size), size);
+	}
+	// element counts are checked against the remaining data so corrupt counts can't trigger huge allocations
+	uint32_t ReadCount(size_t minElementSize) {
+		uint32_t count = ReadU32();
+		if ((m_data.size() - m_position) / minElementSize < count) {
+			throw std::runtime_error("Graph description is truncated.");
+		}
+		return count;
+	}
+private:
+	std::vector<char> m_data;
+	size_t m_position;
+};
+
+
+class BinaryWriter {
+public:
+	explicit BinaryWriter(std::ostream& out) : m_out(out) {}
+
+	void Write(const void* data, size_t size) {
+		m_out.write(reinterpret_cast<const char*>(data), size);
+	}
+	void WriteU8(uint8_t value) {
+		Write(&value, 1);
+	}
+	void WriteU32(uint32_t value) {
+		unsigned char bytes[4] = { (unsigned char)value, (unsigned char)(value >> 8), (unsigned char)(value >> 16), (unsigned char)(value >> 24) };
+		Write(bytes, 4);
+	}
+	void WriteU64(uint64_t value) {
+		WriteU32((uint32_t)value);
+		WriteU32((uint32_t)(value >> 32));
+	}
+	void WriteString(const std::string& value) {
+		WriteU32((uint32_t)value.size());
+		Write(value.data(), value.size());
+	}
+private:
+	std::ostream& m_out;
+};
+
+
+std::vector<char> ReadAll(std::istream& in) {
+	return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+
+//------------------------------------------------------------------------------
+// Instantiation helpers
+//------------------------------------------------------------------------------
+
+void SetParameter(InputPortBase* port, const Any& value) {
+	if (port->GetType() == typeid(Any)) {
+		static_cast<InputPort<Any>*>(port)->Set(value);
+		return;
+	}
+	if (!port->IsCompatible(value.Type())) {
+		throw std::runtime_error(std::string("Parameter of type ") + value.Type().name() + " does not fit port of type " + port->GetType().name() + ".");
+	}
+	if (value.Type() == typeid(int)) {
+		port->SetConvert(value.Get<int>());
+	}
+	else if (value.Type() == typeid(float)) {
+		port->SetConvert(value.Get<float>());
+	}
+	else if (value.Type() == typeid(double)) {
+		port->SetConvert(value.Get<double>());
+	}
+	else if (value.Type() == typeid(bool)) {
+		port->SetConvert(value.Get<bool>());
+	}
+	else if (value.Type() == typeid(std::string)) {
+		port->SetConvert(value.Get<std::string>());
+	}
+	else {
+		throw std::runtime_error(std::string("Parameters of type ") + value.Type().name() + " are not supported.");
+	}
+}
+
+} // namespace
+
+
+
+GraphLoader::GraphLoader(NodeFactory* factory) {
+	if (factory == nullptr) {
+		throw std::invalid_argument("Factory must not be null.");
+	}
+	m_factory = factory;
+}
+
+
+GraphDescription GraphLoader::ParseText(std::istream& in) const {
+	GraphDescription description;
+	std::unordered_map<std::string, size_t> nodeIndices;
+	std::vector<const NodeFactory::NodeInfo*> nodeInfos;
+
+	// resolves name.port to node and port indices
+	auto resolvePort = [&](const std::string& token, bool isInput, size_t lineNumber, size_t& node, size_t& port) {
+		size_t dot = token.find('.');
+		if (dot == std::string::npos) {
+			throw LineError(lineNumber, "expected node.port instead of " + token + ".");
+		}
+		auto it = nodeIndices.find(token.substr(0, dot));
+		if (it == nodeIndices.end()) {
+			throw LineError(lineNumber, "node " + token.substr(0, dot) + " is not declared.");
+		}
+		node = it->second;
+
+		const NodeFactory::NodeInfo& info = *nodeInfos[node];
+		const std::vector<std::string>& names = isInput ? info.inputNames : info.outputNames;
+		const size_t numPorts = isInput ? info.numInputPorts : info.numOutputPorts;
+		std::string portToken = token.substr(dot + 1);
+		if (!ParseIndex(portToken, port)) {
+			port = numPorts;
+			for (size_t i = 0; i < names.size(); ++i) {
+				if (PortName(names[i]) == portToken) {
+					port = i;
+					break;
+				}
+			}
+		}
+		if (port >= numPorts) {
+			throw LineError(lineNumber, std::string(isInput ? "input" : "output") + " " + token + " does not exist.");
+		}
+	};
+
+	std::string line;
+	size_t lineNumber = 0;
+	while (std::getline(in, line)) {
+		++lineNumber;
+		std::vector<std::string> tokens = Tokenize(line, lineNumber);
+		if (tokens.empty()) {
+			continue;
+		}
+
+		const std::string& statement = tokens[0];
+		if (statement == "node") {
+			if (tokens.size() != 3) {
+				throw LineError(lineNumber, "expected node <name> <type>.");
+			}
+			const NodeFactory::NodeInfo* info = m_factory->GetNodeInfo(tokens[2]);
+			if (info == nullptr) {
+				throw LineError(lineNumber, "node type " + tokens[2] + " is not registered.");
+			}
+			if (tokens[1].find('.') != std::string::npos) {
+				throw LineError(lineNumber, "node names cannot contain dots.");
+			}
+			if (!nodeIndices.insert({ tokens[1], description.nodes.size() }).second) {
+				throw LineError(lineNumber, "node " + tokens[1] + " is already declared.");
+			}
+			description.nodes.push_back({ tokens[1], tokens[2] });
+			nodeInfos.push_back(info);
+		}
+		else if (statement == "set") {
+			if (tokens.size() != 3) {
+				throw LineError(lineNumber, "expected set <node>.<input> <value>.");
+			}
+			GraphDescription::Parameter parameter;
+			resolvePort(tokens[1], true, lineNumber, parameter.node, parameter.port);
+			parameter.value = ParseValue(tokens[2], nodeInfos[parameter.node]->inputTypes[parameter.port], lineNumber);
+			description.parameters.push_back(std::move(parameter));
+		}
+		else if (statement == "link") {
+			if (tokens.size() != 3) {
+				throw LineError(lineNumber, "expected link <node>.<output> <node>.<input>.");
+			}
+			GraphDescription::Link link;
+			resolvePort(tokens[1], false, lineNumber, link.sourceNode, link.sourcePort);
+			resolvePort(tokens[2], true, lineNumber, link.destinationNode, link.destinationPort);
+			description.links.push_back(link);
+		}
+		else {
+			throw LineError(lineNumber, "unknown statement " + statement + ".");
+		}
+	}
+
+	return description;
+}
+
+
+GraphDescription GraphLoader::ParseBinary(std::istream& in) const {
+	BinaryReader reader(ReadAll(in));
+	if (std::memcmp(reader.Read(sizeof(BinaryMagic)), BinaryMagic, sizeof(BinaryMagic)) != 0) {
+		throw std::runtime_error("Data is not a binary graph description.");
+	}
+	uint32_t version = reader.ReadU32();
+	if (version != BinaryVersion) {
+		throw std::runtime_error("Unsupported graph description version " + std::to_string(version) + ".");
+	}
+
+	GraphDescription description;
+
+	uint32_t numNodes = reader.ReadCount(8);
+	description.nodes.resize(numNodes);
+	for (auto& node : description.nodes) {
+		node.name = reader.ReadString();
+		node.type = reader.ReadString();
+	}
+
+	uint32_t numParameters = reader.ReadCount(9);
+	description.parameters.resize(numParameters);
+	for (auto& parameter : description.parameters) {
+		parameter.node = reader.ReadU32();
+		parameter.port = reader.ReadU32();
+		if (parameter.node >= numNodes) {
+			throw std::runtime_error("Parameter refers to a node that does not exist.");
+		}
+		switch ((ValueTag)reader.ReadU8()) {
+			case ValueTag::Int: parameter.value = Any((int)reader.ReadU32()); break;
+			case ValueTag::Float: {
+				uint32_t bits = reader.ReadU32();
+				float value;
+				std::memcpy(&value, &bits, sizeof(value));
+				parameter.value = Any(value);
+				break;
+			}
+			case ValueTag::Double: {
+				uint64_t bits = reader.ReadU64();
+				double value;
+				std::memcpy(&value, &bits, sizeof(value));
+				parameter.value = Any(value);
+				break;
+			}
+			case ValueTag::Bool: parameter.value = Any(reader.ReadU8() != 0); break;
+			case ValueTag::String: parameter.value = Any(reader.ReadString()); break;
+			default: throw std::runtime_error("Unknown parameter type in graph description.");
+		}
+	}
+
+	uint32_t numLinks = reader.ReadCount(16);
+	description.links.resize(numLinks);
+	for (auto& link : description.links) {
+		link.sourceNode = reader.ReadU32();
+		link.sourcePort = reader.ReadU32();
+		link.destinationNode = reader.ReadU32();
+		link.destinationPort = reader.ReadU32();
+		if (link.sourceNode >= numNodes || link.destinationNode >= numNodes) {
+			throw std::runtime_error("Link refers to a node that does not exist.");
+		}
+	}
+
+	return description;
+}
+
+
+void GraphLoader::WriteText(std::ostream& out, const GraphDescription& description) const {
+	std::vector<const NodeFactory::NodeInfo*> nodeInfos;
+	for (auto& node : description.nodes) {
+		nodeInfos.push_back(m_factory->GetNodeInfo(node.type));
+		out << "node " << node.name << " " << node.type << "\n";
+	}
+
+	auto portName = [&](size_t node, size_t port, bool isInput) {
+		std::string name;
+		if (nodeInfos[node] != nullptr) {
+			const auto& names = isInput ? nodeInfos[node]->inputNames : nodeInfos[node]->outputNames;
+			if (port < names.size()) {
+				name = PortName(names[port]);
+			}
+		}
+		// fall back to the index if the name is ambiguous or would read as one
+		size_t index;
+		bool isUnique = !name.empty() && !ParseIndex(name, index) && name.find_first_of(" \t#\"") == std::string::npos;
+		for (size_t i = 0; isUnique && i < port; ++i) {
+			const auto& names = isInput ? nodeInfos[node]->inputNames : nodeInfos[node]->outputNames;
+			isUnique = PortName(names[i]) != name;
+		}
+		return description.nodes[node].name + "." + (isUnique ? name : std::to_string(port));
+	};
+
+	for (auto& parameter : description.parameters) {
+		out << "set " << portName(parameter.node, parameter.port, true) << " " << FormatValue(parameter.value) << "\n";
+	}
+	for (auto& link : description.links) {
+		out << "link " << portName(link.sourceNode, link.sourcePort, false) << " " << portName(link.destinationNode, link.destinationPort, true) << "\n";
+	}
+}
+
+
+void GraphLoader::WriteBinary(std::ostream& out, const GraphDescription& description) const {
+	BinaryWriter writer(out);
+	writer.Write(BinaryMagic, sizeof(BinaryMagic));
+	writer.WriteU32(BinaryVersion);
+
+	writer.WriteU32((uint32_t)description.nodes.size());
+	for (auto& node : description.nodes) {
+		writer.WriteString(node.name);
+		writer.WriteString(node.type);
+	}
+
+	writer.WriteU32((uint32_t)description.parameters.size());
+	for (auto& parameter : description.parameters) {
+		writer.WriteU32((uint32_t)parameter.node);
+		writer.WriteU32((uint32_t)parameter.port);
+		const Any& value = parameter.value;
+		if (value.Type() == typeid(int)) {
+			writer.WriteU8((uint8_t)ValueTag::Int);
+			writer.WriteU32((uint32_t)value.Get<int>());
+		}
+		else if (value.Type() == typeid(float)) {
+			uint32_t bits;
+			std::memcpy(&bits, &value.Get<float>(), sizeof(bits));
+			writer.WriteU8((uint8_t)ValueTag::Float);
+			writer.WriteU32(bits);
+		}
+		else if (value.Type() == typeid(double)) {
+			uint64_t bits;
+			std::memcpy(&bits, &value.Get<double>(), sizeof(bits));
+			writer.WriteU8((uint8_t)ValueTag::Double);
+			writer.WriteU64(bits);
+		}
+		else if (value.Type() == typeid(bool)) {
+			writer.WriteU8((uint8_t)ValueTag::Bool);
+			writer.WriteU8(value.Get<bool>() ? 1 : 0);
+		}
+		else if (value.Type() == typeid(std::string)) {
+			writer.WriteU8((uint8_t)ValueTag::String);
+			writer.WriteString(value.Get<std::string>());
+		}
+		else {
+			throw std::invalid_argument(std::string("Parameters of type ") + value.Type().name() + " are not supported.");
+		}
+	}
+
+	writer.WriteU32((uint32_t)description.links.size());
+	for (auto& link : description.links) {
+		writer.WriteU32((uint32_t)link.sourceNode);
+		writer.WriteU32((uint32_t)link.sourcePort);
+		writer.WriteU32((uint32_t)link.destinationNode);
+		writer.WriteU32((uint32_t)link.destinationPort);
+	}
+}
+
+
+GraphInstance GraphLoader::Instantiate(const GraphDescription& description) const {
+	GraphInstance graph;
+
+	// size the arena up front so that all nodes end up in a single block
+	std::vector<const NodeFactory::NodeInfo*> nodeInfos;
+	nodeInfos.reserve(description.nodes.size());
+	size_t arenaSize = 0;
+	for (auto& node : description.nodes) {
+		const NodeFactory::NodeInfo* info = m_factory->GetNodeInfo(node.type);
+		if (info == nullptr) {
+			throw std::runtime_error("Node type " + node.type + " is not registered.");
+		}
+		nodeInfos.push_back(info);
+		arenaSize += info->size + info->alignment - 1;
+	}
+	graph.Reserve(arenaSize);
+
+	for (size_t i = 0; i < description.nodes.size(); ++i) {
+		graph.CreateNode(*nodeInfos[i], description.nodes[i].name);
+	}
+
+	const auto& nodes = graph.GetNodes();
+	auto nodeAt = [&](size_t index) {
+		if (index >= nodes.size()) {
+			throw std::runtime_error("Node index " + std::to_string(index) + " is out of range.");
+		}
+		return nodes[index];
+	};
+
+	for (auto& parameter : description.parameters) {
+		InputPortBase* port = nodeAt(parameter.node)->GetInput(parameter.port);
+		if (port == nullptr) {
+			throw std::runtime_error("Input " + std::to_string(parameter.port) + " of node " + graph.GetName(parameter.node) + " does not exist.");
+		}
+		SetParameter(port, parameter.value);
+	}
+
+	for (auto& link : description.links) {
+		OutputPortBase* source = nodeAt(link.sourceNode)->GetOutput(link.sourcePort);
+		InputPortBase* destination = nodeAt(link.destinationNode)->GetInput(link.destinationPort);
+		if (source == nullptr || destination == nullptr) {
+			throw std::runtime_error("Link from " + graph.GetName(link.sourceNode) + " to " + graph.GetName(link.destinationNode) + " refers to a port that does not exist.");
+		}
+		if (!source->Link(destination)) {
+			throw std::runtime_error("Cannot link " + graph.GetName(link.sourceNode) + "." + std::to_string(link.sourcePort)
+									 + " to " + graph.GetName(link.destinationNode) + "." + std::to_string(link.destinationPort)
+									 + ": types are incompatible, or the input is already linked.");
+		}
+	}
+
+	return graph;
+}
+
+
+GraphInstance GraphLoader::LoadFile(const std::string& path) const {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("Cannot open graph description " + path + ".");
+	}
+
+	char magic[sizeof(BinaryMagic)] = {};
+	file.read(magic, sizeof(magic));
+	bool isBinary = file.gcount() == sizeof(magic) && std::memcmp(magic, BinaryMagic, sizeof(magic)) == 0;
+	file.clear();
+	file.seekg(0);
+
+	return Instantiate(isBinary ? ParseBinary(file) : ParseText(file));
+}
+
+
+} // namespace exc
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "GraphInstance.hpp"
+#include "NodeFactory.hpp"
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+
+namespace exc {
+
+
+/// <summary>
+/// <para> Lists the node instances, input parameters and links of a network. </para>
+/// <para> Nodes are referred to by their index in the node list, ports by their index on the node.
+///		Parameters hold an int, float, double, bool or std::string. </para>
+/// </summary>
+struct GraphDescription {
+	struct Node {
+		/// <summary> Instance name, unique within the graph. </summary>
+		std::string name;
+		/// <summary> The group/name the node class is registered by in the <see cref="NodeFactory"/>. </summary>
+		std::string type;
+	};
+	struct Parameter {
+		size_t node;
+		size_t port;
+		Any value;
+	};
+	struct Link {
+		size_t sourceNode;
+		size_t sourcePort;
+		size_t destinationNode;
+		size_t destinationPort;
+	};
+
+	std::vector<Node> nodes;
+	std::vector<Parameter> parameters;
+	std::vector<Link> links;
+};
+
+
+/// <summary>
+/// <para> Reads and writes graph descriptions, and builds networks from them through a <see cref="NodeFactory"/>. </para>
+/// <para>
+/// The text format is meant for editing. Each line is a statement, # starts a comment:
+/// <code>
+/// node &lt;name&gt; &lt;group/type&gt;
+/// set &lt;name&gt;.&lt;input&gt; &lt;value&gt;
+/// link &lt;name&gt;.&lt;output&gt; &lt;name&gt;.&lt;input&gt;
+/// </code>
+/// Ports are given by index or by their name in the node info. Values are numbers, true/false
+/// or "quoted strings", and are converted to the type of the input port.
+/// </para>
+/// <para>
+/// The binary format is meant for loading fast: names are already resolved to indices,
+/// and values are stored in their final type. Convert with ParseText() and WriteBinary().
+/// </para>
+/// </summary>
+class GraphLoader {
+public:
+	/// <summary> Nodes will be created by the factory, which also describes their ports. </summary>
+	explicit GraphLoader(NodeFactory* factory = NodeFactory::GetInstance());
+
+	/// <summary> Read a description in the text format. Node types and port names are resolved by the factory. </summary>
+	/// <exception cref="std::runtime_error"> Syntax error, or unknown node, port or type. The line number is in the message. </exception>
+	GraphDescription ParseText(std::istream& in) const;
+	/// <summary> Read a description in the binary format. </summary>
+	/// <exception cref="std::runtime_error"> The data is not a valid graph description. </exception>
+	GraphDescription ParseBinary(std::istream& in) const;
+
+	/// <summary> Write a description in the text format. Ports are written by name where the factory knows them. </summary>
+	void WriteText(std::ostream& out, const GraphDescription& description) const;
+	/// <summary> Write a description in the binary format. </summary>
+	void WriteBinary(std::ostream& out, const GraphDescription& description) const;
+
+	/// <summary> Create, configure and link the nodes of the description. </summary>
+	/// <exception cref="std::runtime_error"> A node cannot be created, or a parameter or link does not fit the ports. </exception>
+	GraphInstance Instantiate(const GraphDescription& description) const;
+
+	/// <summary> Read a description file in either format, and instantiate it. </summary>
+	GraphInstance LoadFile(const std::string& path) const;
+private:
+	NodeFactory* m_factory;
+};
+
+
+} // namespace exc
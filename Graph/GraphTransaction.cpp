@@ -0,0 +1,159 @@
+#include "GraphTransaction.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+
+namespace exc {
+
+
+GraphTransaction::GraphTransaction(GraphExecutor& executor)
+	: m_executor(executor)
+{}
+
+
+GraphTransaction::~GraphTransaction() {
+	if (m_preparation.valid()) {
+		m_preparation.wait();
+	}
+}
+
+
+void GraphTransaction::AddNode(NodeBase* node) {
+	CheckStaging();
+	m_addedNodes.push_back(node);
+}
+
+
+void GraphTransaction::RemoveNode(NodeBase* node) {
+	CheckStaging();
+	m_removedNodes.push_back(node);
+}
+
+
+void GraphTransaction::Link(OutputPortBase* source, InputPortBase* destination) {
+	CheckStaging();
+	if (!destination->IsCompatible(source->GetType()) && source->GetType() != typeid(Any)) {
+		throw std::invalid_argument("Cannot link ports of incompatible types.");
+	}
+	m_relinks.push_back({ source, destination });
+}
+
+
+void GraphTransaction::Unlink(InputPortBase* destination) {
+	CheckStaging();
+	m_relinks.push_back({ nullptr, destination });
+}
+
+
+void GraphTransaction::Prepare() {
+	CheckStaging();
+	m_isPreparing = true;
+	if (m_reconfigurations.empty()) {
+		return;
+	}
+	m_preparation = std::async(std::launch::async, [this] {
+		for (auto& reconfiguration : m_reconfigurations) {
+			reconfiguration.prepare();
+		}
+	});
+}
+
+
+bool GraphTransaction::IsPrepared() const {
+	if (!m_isPreparing) {
+		return false;
+	}
+	return !m_preparation.valid() || m_preparation.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+
+void GraphTransaction::Apply() {
+	if (m_isApplied) {
+		throw std::logic_error("The transaction has already been applied.");
+	}
+	if (m_isFailed) {
+		throw std::logic_error("The transaction failed to prepare.");
+	}
+	if (!m_isPreparing) {
+		Prepare();
+	}
+	if (m_preparation.valid()) {
+		// the future is used up either way, a failed preparation leaves states that must never be swapped in
+		try {
+			m_preparation.get();
+		}
+		catch (...) {
+			m_isFailed = true;
+			throw;
+		}
+	}
+
+	// derived executors restore the links they changed for the current schedule
+	m_executor.Invalidate();
+	std::vector<NodeBase*> nodes = m_executor.GetNodes();
+	std::vector<Relink> undoLinks;
+	size_t numSwapped = 0;
+	try {
+		for (auto node : m_removedNodes) {
+			m_executor.RemoveNode(node);
+		}
+		for (auto node : m_addedNodes) {
+			m_executor.AddNode(node);
+		}
+		for (auto& relink : m_relinks) {
+			OutputPortBase* previous = relink.destination->GetLink();
+			size_t position = previous ? size_t(std::find(previous->begin(), previous->end(), relink.destination) - previous->begin()) : 0;
+			undoLinks.push_back({ previous, relink.destination, position });
+			relink.destination->Unlink();
+			if (relink.source && !relink.source->Link(relink.destination)) {
+				throw std::logic_error("Failed to link ports.");
+			}
+		}
+		for (auto& reconfiguration : m_reconfigurations) {
+			reconfiguration.swap();
+			++numSwapped;
+		}
+		m_executor.Compile();
+	}
+	catch (...) {
+		Rollback(nodes, undoLinks, numSwapped);
+		throw;
+	}
+	m_isApplied = true;
+}
+
+
+void GraphTransaction::CheckStaging() const {
+	if (m_isPreparing) {
+		throw std::logic_error("Changes cannot be staged once the transaction is being prepared.");
+	}
+}
+
+
+void GraphTransaction::Stage(std::function<void()> prepare, std::function<void()> swap) {
+	CheckStaging();
+	m_reconfigurations.push_back({ std::move(prepare), std::move(swap) });
+}
+
+
+void GraphTransaction::Rollback(const std::vector<NodeBase*>& nodes, const std::vector<Relink>& undoLinks, size_t numSwapped) {
+	m_executor.Invalidate();
+	while (numSwapped > 0) {
+		m_reconfigurations[--numSwapped].swap();
+	}
+	for (auto it = undoLinks.rbegin(); it != undoLinks.rend(); ++it) {
+		it->destination->Unlink();
+		if (it->source) {
+			it->source->LinkAt(it->destination, it->position);
+		}
+	}
+	m_executor.Clear();
+	for (auto node : nodes) {
+		m_executor.AddNode(node);
+	}
+}
+
+
+} // namespace exc
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "GraphExecutor.hpp"
+#include "Node.hpp"
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+
+namespace exc {
+
+
+/// <summary>
+/// <para> A set of changes to a running graph, applied all at once between two ticks. </para>
+/// <para>
+/// Stage node additions and removals, links, and reconfigurations of nodes, then call Prepare() to
+/// start the expensive part of the reconfigurations on a background thread while the graph keeps
+/// running. Once IsPrepared(), Apply() on the thread that runs the executor, between two calls to
+/// Run(). Applying only relinks ports and swaps prepared state into the nodes, then recompiles the
+/// schedule, so it takes about as long as a tick that compiles.
+/// </para>
+/// <para>
+/// If the new schedule cannot be compiled, for example because the links form a cycle, Apply()
+/// puts everything back the way it was and rethrows. Nodes keep their state across a transaction,
+/// such as the history in their stream readers.
+/// </para>
+/// <code>
+/// GraphTransaction transaction(executor);
+/// transaction.Link(fft.GetOutput(1), visualizer.GetInput(1));
+/// transaction.Reconfigure([] { return FFT::PrepareSetup(8192, 16384); },
+///		[&amp;fft](FFT::Setup&amp; setup) { fft.SwapSetup(setup); });
+/// transaction.Prepare();
+/// ...
+/// if (transaction.IsPrepared()) { transaction.Apply(); }
+/// </code>
+/// </summary>
+class GraphTransaction {
+public:
+	explicit GraphTransaction(GraphExecutor& executor);
+	GraphTransaction(const GraphTransaction&) = delete;
+	GraphTransaction& operator=(const GraphTransaction&) = delete;
+	/// <summary> Waits for the background preparation, if any. </summary>
+	~GraphTransaction();
+
+	/// <summary> Add a node to the executor. </summary>
+	void AddNode(NodeBase* node);
+	/// <summary> Remove a node from the executor. Its links stay, unlink them too if needed. </summary>
+	void RemoveNode(NodeBase* node);
+	/// <summary> Link the ports, replacing the input's current link. </summary>
+	/// <exception cref="std::invalid_argument"> The port types are not compatible. </exception>
+	void Link(OutputPortBase* source, InputPortBase* destination);
+	/// <summary> Remove the link of the input port. </summary>
+	void Unlink(InputPortBase* destination);
+
+	/// <summary>
+	/// Stage a reconfiguration of a node. The prepare function is called on a background thread and
+	/// returns the new state, it must not touch the graph. The swap function gets that state when the
+	/// transaction is applied, and must exchange it with the node's state. Swapping again undoes it.
+	/// </summary>
+	template <class PrepareFunc, class SwapFunc>
+	void Reconfigure(PrepareFunc prepare, SwapFunc swap);
+
+	/// <summary> Start preparing the reconfigurations on a background thread. No more changes can be staged. </summary>
+	void Prepare();
+	/// <summary> True when the preparation is done, and Apply() won't have to wait. </summary>
+	bool IsPrepared() const;
+	/// <summary> Apply the changes and recompile the executor. Prepares first if Prepare() was not called,
+	///		and waits for the preparation to finish. Call it between ticks, on the thread that runs the executor. </summary>
+	/// <exception cref="std::logic_error"> The transaction was already applied, its preparation failed before, or the new
+	///		schedule does not compile. Exceptions from the preparation are rethrown as well, and the transaction can't be
+	///		applied anymore. Nothing is changed in any of these cases. </exception>
+	void Apply();
+private:
+	struct Relink {
+		OutputPortBase* source;
+		InputPortBase* destination;
+		// place of the destination among the source's links, so undoing keeps the order data is passed in
+		size_t position = 0;
+	};
+	struct Reconfiguration {
+		std::function<void()> prepare;
+		std::function<void()> swap;
+	};
+
+	void CheckStaging() const;
+	void Stage(std::function<void()> prepare, std::function<void()> swap);
+	void Rollback(const std::vector<NodeBase*>& nodes, const std::vector<Relink>& undoLinks, size_t numSwapped);
+private:
+	GraphExecutor& m_executor;
+	std::vector<NodeBase*> m_addedNodes;
+	std::vector<NodeBase*> m_removedNodes;
+	std::vector<Relink> m_relinks;
+	std::vector<Reconfiguration> m_reconfigurations;
+	std::future<void> m_preparation;
+	bool m_isPreparing = false;
+	bool m_isApplied = false;
+	bool m_isFailed = false;
+};
+
+
+template <class PrepareFunc, class SwapFunc>
+void GraphTransaction::Reconfigure(PrepareFunc prepare, SwapFunc swap) {
+	using State = std::decay_t<decltype(prepare())>;
+	auto state = std::make_shared<State>();
+	Stage([state, prepare]() mutable { *state = prepare(); },
+		[state, swap]() mutable { swap(*state); });
+}
+
+
+} // namespace exc
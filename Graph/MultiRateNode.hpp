@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+
+namespace exc {
+
+
+/// <summary> Number of output samples a node produces for a number of input samples, on its stream ports. </summary>
+struct RateRatio {
+	size_t numerator = 1;
+	size_t denominator = 1;
+};
+
+
+/// <summary>
+/// <para> Interface for nodes that process streams at a fixed ratio between their input and output sample rates. </para>
+/// <para>
+/// Under an <see cref="SdfExecutor"/>, every update of the node receives the same number of new
+/// samples on each of its stream inputs. The block size is a multiple of the ratio's denominator,
+/// so a decimator always starts its blocks on the same phase.
+/// Other executors keep passing whatever the upstream nodes produced.
+/// </para>
+/// </summary>
+class MultiRateNode {
+public:
+	virtual ~MultiRateNode() = default;
+
+	/// <summary> Output samples produced per input samples. Invalidate the executor when it changes. </summary>
+	virtual RateRatio GetRateRatio() const = 0;
+	/// <summary> Called with the number of samples each stream input will receive per update,
+	///		before the first update of a new schedule. Preallocate buffers here. </summary>
+	virtual void SetBlockSize(size_t numInputSamples) = 0;
+};
+
+
+} // namespace exc
@@ -2,6 +2,7 @@
 
 #include "Node.hpp"
 
+#include <new>
 #include <unordered_map>
 #include <functional>
 #include <type_traits>
@@ -25,6 +26,12 @@ public:
 		std::vector<std::type_index> outputTypes;
 		std::string name;
 		std::string group;
+		/// <summary> Size and alignment of the node object, to place it in memory of your own. </summary>
+		size_t size;
+		size_t alignment;
+		/// <summary> Construct the node at the given address, which must be suitably sized and aligned.
+		///		Destroy it by calling its virtual destructor. </summary>
+		NodeBase* (*construct)(void* place);
 	};
 private:
 	/// <summary> A helper struct to instantiate a specific node type. </summary>
@@ -101,6 +108,9 @@ bool NodeFactory::RegisterNodeClass(const std::string& group) {
 	creator.info.outputTypes = T::Info_GetOutputTypes();
 	creator.info.inputNames = T::Info_GetInputNames();
 	creator.info.outputNames = T::Info_GetOutputNames();
+	creator.info.size = sizeof(T);
+	creator.info.alignment = alignof(T);
+	creator.info.construct = [](void* place) -> NodeBase* {return new (place) T();};
 	creator.creator = []() -> NodeBase* {return new T();};
 
 	// insert class to registered classes' map
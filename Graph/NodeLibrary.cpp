@@ -2,12 +2,15 @@
 #include "Node_MathFunctions.hpp"
 #include "Node_Comparison.hpp"
 #include "Node_Logic.hpp"
+#include "Node_Stream.hpp"
 
 #include "NodeFactory.hpp"
 
 namespace exc {
 
 // Explicit instantiations, let them compile.
+// Instantiating through an alias is an MSVC extension, elsewhere registering the nodes instantiates them.
+#ifdef _MSC_VER
 
 // Basic arithmetic
 template FloatAdd;
@@ -88,6 +91,31 @@ template FloatCeil;
 template FloatFloor;
 template FloatRound;
 
+// Stream
+template StreamAdd;
+template StreamSubtract;
+template StreamMultiply;
+template StreamDivide;
+template StreamMin;
+template StreamMax;
+
+template StreamEqual;
+template StreamNotEqual;
+template StreamLess;
+template StreamLessEqual;
+template StreamGreater;
+template StreamGreaterEqual;
+
+template StreamAnd;
+template StreamOr;
+
+template StreamGain;
+template StreamOffset;
+template StreamThreshold;
+template StreamFloor;
+template StreamCeiling;
+#endif
+
 
 // Manual register functions
 
@@ -173,6 +201,67 @@ void RegisterLogicNodes(NodeFactory* factory, const char* group) {
 }
 
 
+void RegisterStreamNodes(NodeFactory* factory, const char* group) {
+	factory->RegisterNodeClass<StreamAdd>(group);
+	factory->RegisterNodeClass<StreamSubtract>(group);
+	factory->RegisterNodeClass<StreamMultiply>(group);
+	factory->RegisterNodeClass<StreamDivide>(group);
+	factory->RegisterNodeClass<StreamMin>(group);
+	factory->RegisterNodeClass<StreamMax>(group);
+
+	factory->RegisterNodeClass<StreamEqual>(group);
+	factory->RegisterNodeClass<StreamNotEqual>(group);
+	factory->RegisterNodeClass<StreamLess>(group);
+	factory->RegisterNodeClass<StreamLessEqual>(group);
+	factory->RegisterNodeClass<StreamGreater>(group);
+	factory->RegisterNodeClass<StreamGreaterEqual>(group);
+
+	factory->RegisterNodeClass<StreamAnd>(group);
+	factory->RegisterNodeClass<StreamOr>(group);
+
+	factory->RegisterNodeClass<StreamGain>(group);
+	factory->RegisterNodeClass<StreamOffset>(group);
+	factory->RegisterNodeClass<StreamThreshold>(group);
+	factory->RegisterNodeClass<StreamFloor>(group);
+	factory->RegisterNodeClass<StreamCeiling>(group);
+	factory->RegisterNodeClass<StreamClamp>(group);
+
+	factory->RegisterNodeClass<StreamAbs>(group);
+
+	factory->RegisterNodeClass<StreamExp>(group);
+	factory->RegisterNodeClass<StreamExp2>(group);
+	factory->RegisterNodeClass<StreamLog>(group);
+	factory->RegisterNodeClass<StreamLog10>(group);
+	factory->RegisterNodeClass<StreamLog2>(group);
+
+	factory->RegisterNodeClass<StreamSqrt>(group);
+	factory->RegisterNodeClass<StreamCbrt>(group);
+
+	factory->RegisterNodeClass<StreamSin>(group);
+	factory->RegisterNodeClass<StreamCos>(group);
+	factory->RegisterNodeClass<StreamTan>(group);
+	factory->RegisterNodeClass<StreamAsin>(group);
+	factory->RegisterNodeClass<StreamAcos>(group);
+	factory->RegisterNodeClass<StreamAtan>(group);
+
+	factory->RegisterNodeClass<StreamSinh>(group);
+	factory->RegisterNodeClass<StreamCosh>(group);
+	factory->RegisterNodeClass<StreamTanh>(group);
+	factory->RegisterNodeClass<StreamAsinh>(group);
+	factory->RegisterNodeClass<StreamAcosh>(group);
+	factory->RegisterNodeClass<StreamAtanh>(group);
+
+	factory->RegisterNodeClass<StreamErf>(group);
+	factory->RegisterNodeClass<StreamErfc>(group);
+	factory->RegisterNodeClass<StreamGamma>(group);
+	factory->RegisterNodeClass<StreamLgamma>(group);
+
+	factory->RegisterNodeClass<StreamRoundUp>(group);
+	factory->RegisterNodeClass<StreamRoundDown>(group);
+	factory->RegisterNodeClass<StreamRound>(group);
+}
+
+
 
 const char AddStrings::Name[] = "Add:Adds the two inputs";
 const char AddStrings::R[] = "R:A+B";
@@ -279,4 +368,68 @@ const char MathFunctionNames::Floor[] = "Floor:The nearest integer not greater t
 const char MathFunctionNames::Round[] = "Round:The nearest integer";
 
 
+
+// elementwise
+const char StreamNodeNames::Add[] = "StreamAdd:Adds the two signals sample by sample";
+const char StreamNodeNames::Subtract[] = "StreamSubtract:Subtracts the second signal from the first sample by sample";
+const char StreamNodeNames::Multiply[] = "StreamMultiply:Multiplies the two signals sample by sample";
+const char StreamNodeNames::Divide[] = "StreamDivide:Divides the first signal by the second sample by sample";
+const char StreamNodeNames::Min[] = "StreamMin:The smaller of the two signals at each sample";
+const char StreamNodeNames::Max[] = "StreamMax:The larger of the two signals at each sample";
+// comparison
+const char StreamNodeNames::Equal[] = "StreamEqual:1 where A==B, 0 elsewhere";
+const char StreamNodeNames::NotEqual[] = "StreamNotEqual:1 where A!=B, 0 elsewhere";
+const char StreamNodeNames::Less[] = "StreamLess:1 where A<B, 0 elsewhere";
+const char StreamNodeNames::LessEqual[] = "StreamLessEqual:1 where A<=B, 0 elsewhere";
+const char StreamNodeNames::Greater[] = "StreamGreater:1 where A>B, 0 elsewhere";
+const char StreamNodeNames::GreaterEqual[] = "StreamGreaterEqual:1 where A>=B, 0 elsewhere";
+// logic
+const char StreamNodeNames::And[] = "StreamAnd:1 where both signals are non-zero, 0 elsewhere";
+const char StreamNodeNames::Or[] = "StreamOr:1 where either signal is non-zero, 0 elsewhere";
+// with parameter
+const char StreamNodeNames::Gain[] = "StreamGain:Multiplies each sample by Gain";
+const char StreamNodeNames::Offset[] = "StreamOffset:Adds Offset to each sample";
+const char StreamNodeNames::Threshold[] = "StreamThreshold:1 where the signal reaches Threshold, 0 elsewhere";
+const char StreamNodeNames::Floor[] = "StreamFloor:Raises samples below Floor to Floor";
+const char StreamNodeNames::Ceiling[] = "StreamCeiling:Lowers samples above Ceiling to Ceiling";
+// math functions
+const char StreamNodeNames::Abs[] = "StreamAbs:Absolute value of each sample";
+const char StreamNodeNames::Exp[] = "StreamExp:Raises e to the power of each sample";
+const char StreamNodeNames::Exp2[] = "StreamExp2:Raises 2 to the power of each sample";
+const char StreamNodeNames::Log[] = "StreamLog:Natural logarithm of each sample";
+const char StreamNodeNames::Log10[] = "StreamLog10:Base 10 logarithm of each sample";
+const char StreamNodeNames::Log2[] = "StreamLog2:Base 2 logarithm of each sample";
+const char StreamNodeNames::Sqrt[] = "StreamSqrt:Square root of each sample";
+const char StreamNodeNames::Cbrt[] = "StreamCbrt:Cubic root of each sample";
+const char StreamNodeNames::Sin[] = "StreamSin:Sine of each sample";
+const char StreamNodeNames::Cos[] = "StreamCos:Cosine of each sample";
+const char StreamNodeNames::Tan[] = "StreamTan:Tangent of each sample";
+const char StreamNodeNames::Asin[] = "StreamAsin:Inverse sine of each sample";
+const char StreamNodeNames::Acos[] = "StreamAcos:Inverse cosine of each sample";
+const char StreamNodeNames::Atan[] = "StreamAtan:Inverse tangent of each sample";
+const char StreamNodeNames::Sinh[] = "StreamSinh:Hyperbolic sine of each sample";
+const char StreamNodeNames::Cosh[] = "StreamCosh:Hyperbolic cosine of each sample";
+const char StreamNodeNames::Tanh[] = "StreamTanh:Hyperbolic tangent of each sample";
+const char StreamNodeNames::Asinh[] = "StreamAsinh:Inverse hyperbolic sine of each sample";
+const char StreamNodeNames::Acosh[] = "StreamAcosh:Inverse hyperbolic cosine of each sample";
+const char StreamNodeNames::Atanh[] = "StreamAtanh:Inverse hyperbolic tangent of each sample";
+const char StreamNodeNames::Erf[] = "StreamErf:Error function of each sample";
+const char StreamNodeNames::Erfc[] = "StreamErfc:Complementary error function of each sample";
+const char StreamNodeNames::Gamma[] = "StreamGamma:Gamma function of each sample";
+const char StreamNodeNames::Lgamma[] = "StreamLgamma:Natural logarithm of the absolute gamma function of each sample";
+const char StreamNodeNames::RoundUp[] = "StreamRoundUp:Rounds each sample to the nearest integer not less than it";
+const char StreamNodeNames::RoundDown[] = "StreamRoundDown:Rounds each sample to the nearest integer not greater than it";
+const char StreamNodeNames::Round[] = "StreamRound:Rounds each sample to the nearest integer";
+// ports
+const char StreamNodeNames::A[] = "A";
+const char StreamNodeNames::B[] = "B";
+const char StreamNodeNames::R[] = "R";
+const char StreamNodeNames::Mask[] = "Mask";
+const char StreamNodeNames::GainParam[] = "Gain";
+const char StreamNodeNames::OffsetParam[] = "Offset";
+const char StreamNodeNames::ThresholdParam[] = "Threshold";
+const char StreamNodeNames::FloorParam[] = "Floor";
+const char StreamNodeNames::CeilingParam[] = "Ceiling";
+
+
 } // namespace exc
\ No newline at end of file
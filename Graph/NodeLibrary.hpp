@@ -10,6 +10,7 @@ void RegisterFloatArithmeticNodes(NodeFactory* factory, const char* group);
 void RegisterFloatComparisonNodes(NodeFactory* factory, const char* group);
 void RegisterFloatMathNodes(NodeFactory* factory, const char* group);
 void RegisterLogicNodes(NodeFactory* factory, const char* group);
+void RegisterStreamNodes(NodeFactory* factory, const char* group);
 
 
 } // namespace exc
\ No newline at end of file
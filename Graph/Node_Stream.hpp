@@ -0,0 +1,491 @@
+#pragma once
+
+#include "Node.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define EXC_STREAM_NODES_SSE
+#include <xmmintrin.h>
+#endif
+
+
+namespace exc {
+
+
+//------------------------------------------------------------------------------
+// Kernels
+//------------------------------------------------------------------------------
+
+namespace impl {
+
+// Operators of the stream kernels.
+// Each has a scalar and a vector overload, which must give bit-identical results,
+// as the kernels process the tail of the blocks with the scalar one.
+// Masks are 1.0f where the condition holds, 0.0f elsewhere.
+
+struct StreamAddOperator {
+	static float Apply(float a, float b) { return a + b; }
+#ifdef EXC_STREAM_NODES_SSE
+	static __m128 Apply(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+#endif
+};
+
+struct StreamSubtractOperator {
+	static float Apply(float a, float b) { return a - b; }
+#ifdef EXC_STREAM_NODES_SSE
+	static __m128 Apply(__m128 a, __m128 b) { return _mm_sub_ps(a, b); }
+#endif
+};
+
+struct StreamMultiplyOperator {
+	static float Apply(float a, float b) { return a * b; }
+#ifdef EXC_STREAM_NODES_SSE
+	static __m128 Apply(__m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+#endif
+};
+
+struct StreamDivideOperator {
+	static float Apply(float a, float b) { return a / b; }
+#ifdef EXC_STREAM_NODES_SSE
+	static __m128 Apply(__m128 a, __m128 b) { return _mm_div_ps(a, b); }
+#endif
+};
+
+// minps and maxps return the second operand if either is NaN, so do the scalar versions
+struct StreamMinOperator {
+	static float Apply(float a, float b) { return a < b ? a : b; }
+#ifdef EXC_STREAM_NODES_SSE
+	static __m128 Apply(__m128 a, __m128 b) { return _mm_min_ps(a, b); }
+#endif
+};
+
+struct StreamMaxOperator {
+	static float Apply(float a, float b) { return a > b ? a : b; }
+#ifdef EXC_STREAM_NODES_SSE
+	static __m128 Apply(__m128 a, __m128 b) { return _mm_max_ps(a, b); }
+#endif
+};
+
+struct StreamLessOperator {
+	static float Apply(float a, float b) { return a < b ? 1.0f : 0.0f; }
+#ifdef EXC_STREAM_NODES_SSE
+	static __m128 Apply(__m128 a, __m128 b) { return _mm_and_ps(_mm_cmplt_ps(a, b), _mm_set1_ps(1.0f)); }
+#endif
+};
+
+struct StreamLessEqualOperator {
+	static float Apply(float a, float b) { return a <= b ? 1.0f : 0.0f; }
+#ifdef EXC_STREAM_NODES_SSE
+	static __m128 Apply(__m128 a, __m128 b) { return _mm_and_ps(_mm_cmple_ps(a, b), _mm_set1_ps(1.0f)); }
+#endif
+};
+
+struct StreamGreaterOperator {
+	static float Apply(float a, float b) { return a > b ? 1.0f : 0.0f; }
+#ifdef EXC_STREAM_NODES_SSE
+	static __m128 Apply(__m128 a, __m128 b) { return _mm_and_ps(_mm_cmpgt_ps(a, b), _mm_set1_ps(1.0f)); }
+#endif
+};
+
+struct StreamGreaterEqualOperator {
+	static float Apply(float a, float b) { return a >= b ? 1.0f : 0.0f; }
+#ifdef EXC_STREAM_NODES_SSE
+	static __m128 Apply(__m128 a, __m128 b) { return _mm_and_ps(_mm_cmpge_ps(a, b), _mm_set1_ps(1.0f)); }
+#endif
+};
+
+struct StreamEqualOperator {
+	static float Apply(float a, float b) { return a == b ? 1.0f : 0.0f; }
+#ifdef EXC_STREAM_NODES_SSE
+	static __m128 Apply(__m128 a, __m128 b) { return _mm_and_ps(_mm_cmpeq_ps(a, b), _mm_set1_ps(1.0f)); }
+#endif
+};
+
+struct StreamNotEqualOperator {
+	static float Apply(float a, float b) { return a != b ? 1.0f : 0.0f; }
+#ifdef EXC_STREAM_NODES_SSE
+	static __m128 Apply(__m128 a, __m128 b) { return _mm_and_ps(_mm_cmpneq_ps(a, b), _mm_set1_ps(1.0f)); }
+#endif
+};
+
+// logic operators treat any non-zero sample as true
+struct StreamAndOperator {
+	static float Apply(float a, float b) { return a != 0.0f && b != 0.0f ? 1.0f : 0.0f; }
+#ifdef EXC_STREAM_NODES_SSE
+	static __m128 Apply(__m128 a, __m128 b) {
+		__m128 zero = _mm_setzero_ps();
+		return _mm_and_ps(_mm_and_ps(_mm_cmpneq_ps(a, zero), _mm_cmpneq_ps(b, zero)), _mm_set1_ps(1.0f));
+	}
+#endif
+};
+
+struct StreamOrOperator {
+	static float Apply(float a, float b) { return a != 0.0f || b != 0.0f ? 1.0f : 0.0f; }
+#ifdef EXC_STREAM_NODES_SSE
+	static __m128 Apply(__m128 a, __m128 b) {
+		__m128 zero = _mm_setzero_ps();
+		return _mm_and_ps(_mm_or_ps(_mm_cmpneq_ps(a, zero), _mm_cmpneq_ps(b, zero)), _mm_set1_ps(1.0f));
+	}
+#endif
+};
+
+// unary operators, only for functions that have an exact vector form
+struct StreamAbsOperator {
+	static float Apply(float a) { return std::abs(a); }
+#ifdef EXC_STREAM_NODES_SSE
+	static __m128 Apply(__m128 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+#endif
+};
+
+// sqrtps is correctly rounded like std::sqrt
+struct StreamSqrtOperator {
+	static float Apply(float a) { return std::sqrt(a); }
+#ifdef EXC_STREAM_NODES_SSE
+	static __m128 Apply(__m128 a) { return _mm_sqrt_ps(a); }
+#endif
+};
+
+
+/// <summary> Computes a[i] = Op(a[i]) for each sample. </summary>
+template <class Op>
+void StreamKernel(float* a, size_t count) {
+	size_t i = 0;
+#ifdef EXC_STREAM_NODES_SSE
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(a + i, Op::Apply(_mm_loadu_ps(a + i)));
+	}
+#endif
+	for (; i < count; ++i) {
+		a[i] = Op::Apply(a[i]);
+	}
+}
+
+/// <summary> Computes a[i] = Function(a[i]) for each sample. </summary>
+/// <remarks> For the functions SSE has no instruction for, it's a plain loop the compiler may vectorize. </remarks>
+template <float(*Function)(float)>
+void StreamFunctionKernel(float* a, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		a[i] = Function(a[i]);
+	}
+}
+
+/// <summary> Computes a[i] = Op(a[i], b[i]) for each sample. </summary>
+template <class Op>
+void StreamKernel(float* a, const float* b, size_t count) {
+	size_t i = 0;
+#ifdef EXC_STREAM_NODES_SSE
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(a + i, Op::Apply(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+	}
+#endif
+	for (; i < count; ++i) {
+		a[i] = Op::Apply(a[i], b[i]);
+	}
+}
+
+/// <summary> Computes a[i] = Op(a[i], b) for each sample. </summary>
+template <class Op>
+void StreamKernel(float* a, float b, size_t count) {
+	size_t i = 0;
+#ifdef EXC_STREAM_NODES_SSE
+	__m128 vb = _mm_set1_ps(b);
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(a + i, Op::Apply(_mm_loadu_ps(a + i), vb));
+	}
+#endif
+	for (; i < count; ++i) {
+		a[i] = Op::Apply(a[i], b);
+	}
+}
+
+} // namespace impl
+
+
+
+//------------------------------------------------------------------------------
+// Nodes
+//------------------------------------------------------------------------------
+
+/// <summary>
+/// <para> Applies an operator to two signals, sample by sample. </para>
+/// <para>
+/// Unlike the scalar nodes, stream nodes do not update when notified, they
+/// process a whole block each time the executor updates them. If the
+/// blocks differ in length, the result is as long as the shorter one.
+/// </para>
+/// </summary>
+template <class OperatorT, const char* name, const char* op1desc, const char* op2desc, const char* resdesc>
+class StreamBinaryNode
+	: public InputPortConfig<std::vector<float>, std::vector<float>>,
+	public OutputPortConfig<std::vector<float>>
+{
+public:
+	void Update() override {
+		// the first operand's buffer is reused for the result
+		std::vector<float> a = GetInput<0>().Take();
+		const std::vector<float>& b = GetInput<1>().Get();
+		a.resize(std::min(a.size(), b.size()));
+		impl::StreamKernel<OperatorT>(a.data(), b.data(), a.size());
+		GetOutput<0>().Set(std::move(a));
+	}
+
+	void Notify(InputPortBase* sender) override {}
+
+	static std::string Info_GetName() {
+		return name;
+	}
+
+	static const std::vector<std::string>& Info_GetInputNames() {
+		static std::vector<std::string> names = {
+			op1desc,
+			op2desc
+		};
+		return names;
+	}
+	static const std::vector<std::string>& Info_GetOutputNames() {
+		static std::vector<std::string> names = {
+			resdesc
+		};
+		return names;
+	}
+};
+
+
+/// <summary> Applies an operator to each sample of a signal and a constant parameter. </summary>
+template <class OperatorT, const char* name, const char* paramdesc, const char* resdesc>
+class StreamParameterNode
+	: public InputPortConfig<std::vector<float>, float>,
+	public OutputPortConfig<std::vector<float>>
+{
+public:
+	void Update() override {
+		std::vector<float> signal = GetInput<0>().Take();
+		impl::StreamKernel<OperatorT>(signal.data(), GetInput<1>().Get(), signal.size());
+		GetOutput<0>().Set(std::move(signal));
+	}
+
+	void Notify(InputPortBase* sender) override {}
+
+	static std::string Info_GetName() {
+		return name;
+	}
+
+	static const std::vector<std::string>& Info_GetInputNames() {
+		static std::vector<std::string> names = {
+			"Signal",
+			paramdesc
+		};
+		return names;
+	}
+	static const std::vector<std::string>& Info_GetOutputNames() {
+		static std::vector<std::string> names = {
+			resdesc
+		};
+		return names;
+	}
+};
+
+
+/// <summary> Applies a math function to each sample of a signal, the block version of MathFunctionNode. </summary>
+template <void(*Kernel)(float*, size_t), const char* name>
+class StreamFunctionNode
+	: public InputPortConfig<std::vector<float>>,
+	public OutputPortConfig<std::vector<float>>
+{
+public:
+	void Update() override {
+		std::vector<float> signal = GetInput<0>().Take();
+		Kernel(signal.data(), signal.size());
+		GetOutput<0>().Set(std::move(signal));
+	}
+
+	void Notify(InputPortBase* sender) override {}
+
+	static std::string Info_GetName() {
+		return name;
+	}
+
+	static const std::vector<std::string>& Info_GetInputNames() {
+		static std::vector<std::string> names = {
+			"Signal"
+		};
+		return names;
+	}
+	static const std::vector<std::string>& Info_GetOutputNames() {
+		static std::vector<std::string> names = {
+			"R"
+		};
+		return names;
+	}
+};
+
+
+/// <summary> Limits each sample of a signal to the [Min, Max] range. </summary>
+class StreamClamp
+	: public InputPortConfig<std::vector<float>, float, float>,
+	public OutputPortConfig<std::vector<float>>
+{
+public:
+	void Update() override {
+		std::vector<float> signal = GetInput<0>().Take();
+		impl::StreamKernel<impl::StreamMaxOperator>(signal.data(), GetInput<1>().Get(), signal.size());
+		impl::StreamKernel<impl::StreamMinOperator>(signal.data(), GetInput<2>().Get(), signal.size());
+		GetOutput<0>().Set(std::move(signal));
+	}
+
+	void Notify(InputPortBase* sender) override {}
+
+	static std::string Info_GetName() {
+		return "StreamClamp:Limits each sample of the signal between Min and Max";
+	}
+
+	static const std::vector<std::string>& Info_GetInputNames() {
+		static std::vector<std::string> names = {
+			"Signal",
+			"Min",
+			"Max"
+		};
+		return names;
+	}
+	static const std::vector<std::string>& Info_GetOutputNames() {
+		static std::vector<std::string> names = {
+			"R"
+		};
+		return names;
+	}
+};
+
+
+
+// Strings
+struct StreamNodeNames {
+	// elementwise
+	static const char Add[];
+	static const char Subtract[];
+	static const char Multiply[];
+	static const char Divide[];
+	static const char Min[];
+	static const char Max[];
+	// comparison
+	static const char Equal[];
+	static const char NotEqual[];
+	static const char Less[];
+	static const char LessEqual[];
+	static const char Greater[];
+	static const char GreaterEqual[];
+	// logic
+	static const char And[];
+	static const char Or[];
+	// with parameter
+	static const char Gain[];
+	static const char Offset[];
+	static const char Threshold[];
+	static const char Floor[];
+	static const char Ceiling[];
+	// math functions
+	static const char Abs[];
+	static const char Exp[];
+	static const char Exp2[];
+	static const char Log[];
+	static const char Log10[];
+	static const char Log2[];
+	static const char Sqrt[];
+	static const char Cbrt[];
+	static const char Sin[];
+	static const char Cos[];
+	static const char Tan[];
+	static const char Asin[];
+	static const char Acos[];
+	static const char Atan[];
+	static const char Sinh[];
+	static const char Cosh[];
+	static const char Tanh[];
+	static const char Asinh[];
+	static const char Acosh[];
+	static const char Atanh[];
+	static const char Erf[];
+	static const char Erfc[];
+	static const char Gamma[];
+	static const char Lgamma[];
+	static const char RoundUp[];
+	static const char RoundDown[];
+	static const char Round[];
+
+	// ports
+	static const char A[];
+	static const char B[];
+	static const char R[];
+	static const char Mask[];
+	static const char GainParam[];
+	static const char OffsetParam[];
+	static const char ThresholdParam[];
+	static const char FloorParam[];
+	static const char CeilingParam[];
+};
+
+
+// Actual nodes
+using StreamAdd = StreamBinaryNode<impl::StreamAddOperator, StreamNodeNames::Add, StreamNodeNames::A, StreamNodeNames::B, StreamNodeNames::R>;
+using StreamSubtract = StreamBinaryNode<impl::StreamSubtractOperator, StreamNodeNames::Subtract, StreamNodeNames::A, StreamNodeNames::B, StreamNodeNames::R>;
+using StreamMultiply = StreamBinaryNode<impl::StreamMultiplyOperator, StreamNodeNames::Multiply, StreamNodeNames::A, StreamNodeNames::B, StreamNodeNames::R>;
+using StreamDivide = StreamBinaryNode<impl::StreamDivideOperator, StreamNodeNames::Divide, StreamNodeNames::A, StreamNodeNames::B, StreamNodeNames::R>;
+using StreamMin = StreamBinaryNode<impl::StreamMinOperator, StreamNodeNames::Min, StreamNodeNames::A, StreamNodeNames::B, StreamNodeNames::R>;
+using StreamMax = StreamBinaryNode<impl::StreamMaxOperator, StreamNodeNames::Max, StreamNodeNames::A, StreamNodeNames::B, StreamNodeNames::R>;
+
+using StreamEqual = StreamBinaryNode<impl::StreamEqualOperator, StreamNodeNames::Equal, StreamNodeNames::A, StreamNodeNames::B, StreamNodeNames::Mask>;
+using StreamNotEqual = StreamBinaryNode<impl::StreamNotEqualOperator, StreamNodeNames::NotEqual, StreamNodeNames::A, StreamNodeNames::B, StreamNodeNames::Mask>;
+using StreamLess = StreamBinaryNode<impl::StreamLessOperator, StreamNodeNames::Less, StreamNodeNames::A, StreamNodeNames::B, StreamNodeNames::Mask>;
+using StreamLessEqual = StreamBinaryNode<impl::StreamLessEqualOperator, StreamNodeNames::LessEqual, StreamNodeNames::A, StreamNodeNames::B, StreamNodeNames::Mask>;
+using StreamGreater = StreamBinaryNode<impl::StreamGreaterOperator, StreamNodeNames::Greater, StreamNodeNames::A, StreamNodeNames::B, StreamNodeNames::Mask>;
+using StreamGreaterEqual = StreamBinaryNode<impl::StreamGreaterEqualOperator, StreamNodeNames::GreaterEqual, StreamNodeNames::A, StreamNodeNames::B, StreamNodeNames::Mask>;
+
+using StreamAnd = StreamBinaryNode<impl::StreamAndOperator, StreamNodeNames::And, StreamNodeNames::A, StreamNodeNames::B, StreamNodeNames::Mask>;
+using StreamOr = StreamBinaryNode<impl::StreamOrOperator, StreamNodeNames::Or, StreamNodeNames::A, StreamNodeNames::B, StreamNodeNames::Mask>;
+
+using StreamGain = StreamParameterNode<impl::StreamMultiplyOperator, StreamNodeNames::Gain, StreamNodeNames::GainParam, StreamNodeNames::R>;
+using StreamOffset = StreamParameterNode<impl::StreamAddOperator, StreamNodeNames::Offset, StreamNodeNames::OffsetParam, StreamNodeNames::R>;
+using StreamThreshold = StreamParameterNode<impl::StreamGreaterEqualOperator, StreamNodeNames::Threshold, StreamNodeNames::ThresholdParam, StreamNodeNames::Mask>;
+using StreamFloor = StreamParameterNode<impl::StreamMaxOperator, StreamNodeNames::Floor, StreamNodeNames::FloorParam, StreamNodeNames::R>;
+using StreamCeiling = StreamParameterNode<impl::StreamMinOperator, StreamNodeNames::Ceiling, StreamNodeNames::CeilingParam, StreamNodeNames::R>;
+
+// general
+using StreamAbs = StreamFunctionNode<impl::StreamKernel<impl::StreamAbsOperator>, StreamNodeNames::Abs>;
+// exponential
+using StreamExp = StreamFunctionNode<impl::StreamFunctionKernel<std::exp>, StreamNodeNames::Exp>;
+using StreamExp2 = StreamFunctionNode<impl::StreamFunctionKernel<std::exp2>, StreamNodeNames::Exp2>;
+using StreamLog = StreamFunctionNode<impl::StreamFunctionKernel<std::log>, StreamNodeNames::Log>;
+using StreamLog10 = StreamFunctionNode<impl::StreamFunctionKernel<std::log10>, StreamNodeNames::Log10>;
+using StreamLog2 = StreamFunctionNode<impl::StreamFunctionKernel<std::log2>, StreamNodeNames::Log2>;
+// power
+using StreamSqrt = StreamFunctionNode<impl::StreamKernel<impl::StreamSqrtOperator>, StreamNodeNames::Sqrt>;
+using StreamCbrt = StreamFunctionNode<impl::StreamFunctionKernel<std::cbrt>, StreamNodeNames::Cbrt>;
+// trigonometric
+using StreamSin = StreamFunctionNode<impl::StreamFunctionKernel<std::sin>, StreamNodeNames::Sin>;
+using StreamCos = StreamFunctionNode<impl::StreamFunctionKernel<std::cos>, StreamNodeNames::Cos>;
+using StreamTan = StreamFunctionNode<impl::StreamFunctionKernel<std::tan>, StreamNodeNames::Tan>;
+using StreamAsin = StreamFunctionNode<impl::StreamFunctionKernel<std::asin>, StreamNodeNames::Asin>;
+using StreamAcos = StreamFunctionNode<impl::StreamFunctionKernel<std::acos>, StreamNodeNames::Acos>;
+using StreamAtan = StreamFunctionNode<impl::StreamFunctionKernel<std::atan>, StreamNodeNames::Atan>;
+// hyperbolic
+using StreamSinh = StreamFunctionNode<impl::StreamFunctionKernel<std::sinh>, StreamNodeNames::Sinh>;
+using StreamCosh = StreamFunctionNode<impl::StreamFunctionKernel<std::cosh>, StreamNodeNames::Cosh>;
+using StreamTanh = StreamFunctionNode<impl::StreamFunctionKernel<std::tanh>, StreamNodeNames::Tanh>;
+using StreamAsinh = StreamFunctionNode<impl::StreamFunctionKernel<std::asinh>, StreamNodeNames::Asinh>;
+using StreamAcosh = StreamFunctionNode<impl::StreamFunctionKernel<std::acosh>, StreamNodeNames::Acosh>;
+using StreamAtanh = StreamFunctionNode<impl::StreamFunctionKernel<std::atanh>, StreamNodeNames::Atanh>;
+// statistical
+using StreamErf = StreamFunctionNode<impl::StreamFunctionKernel<std::erf>, StreamNodeNames::Erf>;
+using StreamErfc = StreamFunctionNode<impl::StreamFunctionKernel<std::erfc>, StreamNodeNames::Erfc>;
+using StreamGamma = StreamFunctionNode<impl::StreamFunctionKernel<std::tgamma>, StreamNodeNames::Gamma>;
+using StreamLgamma = StreamFunctionNode<impl::StreamFunctionKernel<std::lgamma>, StreamNodeNames::Lgamma>;
+// rounding
+using StreamRoundUp = StreamFunctionNode<impl::StreamFunctionKernel<std::ceil>, StreamNodeNames::RoundUp>;
+using StreamRoundDown = StreamFunctionNode<impl::StreamFunctionKernel<std::floor>, StreamNodeNames::RoundDown>;
+using StreamRound = StreamFunctionNode<impl::StreamFunctionKernel<std::round>, StreamNodeNames::Round>;
+
+
+} // namespace exc
@@ -0,0 +1,69 @@
+#include "ParallelGraphExecutor.hpp"
+
+#include <algorithm>
+
+
+namespace exc {
+
+
+ParallelGraphExecutor::ParallelGraphExecutor(size_t numThreads)
+	: m_pool(numThreads)
+{}
+
+
+ParallelGraphExecutor::ParallelGraphExecutor(std::initializer_list<NodeBase*> nodes, size_t numThreads)
+	: ParallelGraphExecutor(numThreads)
+{
+	for (auto node : nodes) {
+		AddNode(node);
+	}
+}
+
+
+void ParallelGraphExecutor::PinToCallingThread(NodeBase* node, bool pinned) {
+	auto it = std::find(m_pinnedNodes.begin(), m_pinnedNodes.end(), node);
+	if (pinned && it == m_pinnedNodes.end()) {
+		m_pinnedNodes.push_back(node);
+	}
+	else if (!pinned && it != m_pinnedNodes.end()) {
+		m_pinnedNodes.erase(it);
+	}
+	Invalidate();
+}
+
+
+size_t ParallelGraphExecutor::GetNumThreads() const {
+	return m_pool.GetNumThreads();
+}
+
+
+void ParallelGraphExecutor::OnCompiled() {
+	std::vector<size_t> indices(m_schedule.size());
+	std::vector<bool> isPinned(m_schedule.size());
+	for (size_t i = 0; i < m_schedule.size(); ++i) {
+		indices[i] = i;
+		isPinned[i] = std::find(m_pinnedNodes.begin(), m_pinnedNodes.end(), m_schedule[i].node) != m_pinnedNodes.end();
+	}
+	m_parallel.Compile(m_schedule, indices, isPinned);
+}
+
+
+void ParallelGraphExecutor::OnInvalidated() {
+	m_parallel.Clear();
+}
+
+
+void ParallelGraphExecutor::Run() {
+	if (!m_isCompiled) {
+		Compile();
+	}
+	m_parallel.Run(m_pool, [this](size_t index) {
+		if (ShouldUpdate(index)) {
+			GRAPH_PROFILE_UPDATE(m_schedule[index].node);
+			m_schedule[index].node->Update();
+		}
+	});
+}
+
+
+} // namespace exc
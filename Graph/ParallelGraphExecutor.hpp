@@ -0,0 +1,54 @@
+#pragma once
+
+#include "GraphExecutor.hpp"
+#include "ParallelSchedule.hpp"
+#include "ThreadPool.hpp"
+
+#include <vector>
+
+
+namespace exc {
+
+
+/// <summary>
+/// <para> Updates independent branches of a network in parallel. </para>
+/// <para>
+/// Uses the same schedule as <see cref="GraphExecutor"/>, but a node is started
+/// on a work-stealing thread pool as soon as all nodes it receives data from
+/// are done. Branches that share no data therefore run concurrently.
+/// </para>
+/// <para>
+/// Nodes that must run on the thread calling Run(), for example ones that own a window,
+/// can be pinned to it. Nodes must not touch each other's state in Notify(), as
+/// notifications may come from any worker.
+/// </para>
+/// </summary>
+class ParallelGraphExecutor : public GraphExecutor {
+public:
+	/// <summary> Create the executor with its own pool. Zero threads means one per hardware thread. </summary>
+	explicit ParallelGraphExecutor(size_t numThreads = 0);
+	ParallelGraphExecutor(std::initializer_list<NodeBase*> nodes, size_t numThreads = 0);
+
+	/// <summary> Make the node always update on the thread that calls Run(). </summary>
+	void PinToCallingThread(NodeBase* node, bool pinned = true);
+
+	/// <summary> Update each node once, running independent nodes in parallel.
+	/// Returns when all nodes are done. Exceptions from nodes are rethrown here,
+	/// nodes depending on a failed node are not updated. </summary>
+	void Run() override;
+
+	/// <summary> Get the number of worker threads. </summary>
+	size_t GetNumThreads() const;
+protected:
+	void OnCompiled() override;
+	void OnInvalidated() override;
+private:
+	std::vector<NodeBase*> m_pinnedNodes;
+	ParallelSchedule m_parallel;
+
+	// declared last so that its threads are joined before the members they use are destroyed
+	ThreadPool m_pool;
+};
+
+
+} // namespace exc
@@ -0,0 +1,133 @@
+#include "ParallelSchedule.hpp"
+
+#include <algorithm>
+
+
+namespace exc {
+
+
+ParallelSchedule::ParallelSchedule() {
+	m_numRemaining = 0;
+	m_failed = false;
+}
+
+
+void ParallelSchedule::Compile(const std::vector<GraphExecutor::ScheduledNode>& schedule, const std::vector<size_t>& indices, const std::vector<bool>& isPinned) {
+	// positions of the schedule entries in the part, successors outside the part are dropped
+	std::vector<size_t> positions(schedule.size(), size_t(-1));
+	for (size_t i = 0; i < indices.size(); ++i) {
+		positions[indices[i]] = i;
+	}
+
+	m_entries.clear();
+	for (auto index : indices) {
+		m_entries.push_back({ index, {}, 0, isPinned[index] });
+	}
+	for (auto& entry : m_entries) {
+		for (auto successor : schedule[entry.index].successors) {
+			if (positions[successor] != size_t(-1)) {
+				entry.successors.push_back(positions[successor]);
+				++m_entries[positions[successor]].numPredecessors;
+			}
+		}
+	}
+	m_numPending.reset(new std::atomic<size_t>[m_entries.size()]);
+}
+
+
+void ParallelSchedule::Clear() {
+	m_entries.clear();
+	m_numPending.reset();
+}
+
+
+void ParallelSchedule::Run(ThreadPool& pool, const UpdateFunction& update) {
+	if (m_entries.empty()) {
+		return;
+	}
+
+	// reset dependency counters, then start the nodes that don't depend on anything
+	for (size_t i = 0; i < m_entries.size(); ++i) {
+		m_numPending[i] = m_entries[i].numPredecessors;
+	}
+	m_numRemaining = m_entries.size();
+	m_failed = false;
+	m_exception = nullptr;
+	m_pool = &pool;
+	m_update = &update;
+
+	for (size_t i = 0; i < m_entries.size(); ++i) {
+		if (m_entries[i].numPredecessors == 0) {
+			Dispatch(i);
+		}
+	}
+
+	// run the pinned nodes here until all nodes are done
+	std::unique_lock<std::mutex> lk(m_mtx);
+	while (true) {
+		m_cv.wait(lk, [this] { return !m_pinnedReady.empty() || m_numRemaining == 0; });
+		if (!m_pinnedReady.empty()) {
+			size_t position = m_pinnedReady.front();
+			m_pinnedReady.pop_front();
+			lk.unlock();
+			Execute(position);
+			lk.lock();
+		}
+		else {
+			break;
+		}
+	}
+	lk.unlock();
+
+	if (m_exception) {
+		std::rethrow_exception(m_exception);
+	}
+}
+
+
+void ParallelSchedule::Dispatch(size_t position) {
+	if (m_entries[position].isPinned) {
+		{
+			std::lock_guard<std::mutex> lkg(m_mtx);
+			m_pinnedReady.push_back(position);
+		}
+		m_cv.notify_all();
+	}
+	else {
+		m_pool->Submit([this, position] { Execute(position); });
+	}
+}
+
+
+void ParallelSchedule::Execute(size_t position) {
+	const Entry& entry = m_entries[position];
+
+	if (!m_failed) {
+		try {
+			(*m_update)(entry.index);
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lkg(m_mtx);
+			if (!m_exception) {
+				m_exception = std::current_exception();
+			}
+			m_failed = true;
+		}
+	}
+
+	// successors still have to be released after a failure so that Run() can finish
+	for (auto successor : entry.successors) {
+		if (--m_numPending[successor] == 0) {
+			Dispatch(successor);
+		}
+	}
+
+	// the last count and the notify under one lock: once Run() sees 0 it may return and destroy the schedule
+	std::lock_guard<std::mutex> lkg(m_mtx);
+	if (--m_numRemaining == 0) {
+		m_cv.notify_all();
+	}
+}
+
+
+} // namespace exc
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "GraphExecutor.hpp"
+#include "ThreadPool.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace exc {
+
+
+/// <summary>
+/// <para> Updates a part of a compiled schedule on a thread pool. </para>
+/// <para>
+/// A node is started as soon as all nodes of the part it receives data from are done, so branches
+/// that share no data run concurrently. Nodes outside the part are assumed to be done already.
+/// Pinned nodes are updated on the thread that calls Run().
+/// </para>
+/// </summary>
+class ParallelSchedule {
+public:
+	/// <summary> Updates the node at the index of the executor's schedule. </summary>
+	using UpdateFunction = std::function<void(size_t index)>;
+public:
+	ParallelSchedule();
+
+	/// <summary> Set the nodes to update, as indices of the schedule in schedule order. </summary>
+	/// <param name="isPinned"> Tells for each schedule entry if it must update on the calling thread. </param>
+	void Compile(const std::vector<GraphExecutor::ScheduledNode>& schedule, const std::vector<size_t>& indices, const std::vector<bool>& isPinned);
+	/// <summary> Forget the nodes. </summary>
+	void Clear();
+
+	/// <summary> Update each node of the part once. Returns when all of them are done. Exceptions from nodes
+	///		are rethrown here, nodes depending on a failed node are not updated. </summary>
+	void Run(ThreadPool& pool, const UpdateFunction& update);
+private:
+	struct Entry {
+		size_t index;
+		// positions in the part, not schedule indices
+		std::vector<size_t> successors;
+		size_t numPredecessors;
+		bool isPinned;
+	};
+
+	void Dispatch(size_t position);
+	void Execute(size_t position);
+private:
+	std::vector<Entry> m_entries;
+	std::unique_ptr<std::atomic<size_t>[]> m_numPending;
+	std::atomic<size_t> m_numRemaining;
+	std::atomic_bool m_failed;
+	std::exception_ptr m_exception;
+	ThreadPool* m_pool = nullptr;
+	const UpdateFunction* m_update = nullptr;
+
+	std::mutex m_mtx;
+	std::condition_variable m_cv;
+	std::deque<size_t> m_pinnedReady;
+};
+
+
+} // namespace exc
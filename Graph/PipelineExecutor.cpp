@@ -0,0 +1,369 @@
+#include "PipelineExecutor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <unordered_map>
+
+
+namespace exc {
+
+
+static constexpr size_t NoProducer = size_t(-1);
+
+
+// Wait a little before polling a queue again. Spins briefly, then sleeps so idle stages don't burn a core.
+static void Backoff(unsigned& numSpins) {
+	if (numSpins < 64) {
+		++numSpins;
+		std::this_thread::yield();
+	}
+	else {
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+}
+
+
+PipelineExecutor::PipelineExecutor(size_t queueCapacity)
+	: m_queueCapacity(std::max(queueCapacity, size_t(1)))
+{
+	m_stop = false;
+}
+
+
+PipelineExecutor::PipelineExecutor(std::initializer_list<NodeBase*> nodes, size_t queueCapacity)
+	: PipelineExecutor(queueCapacity)
+{
+	for (auto node : nodes) {
+		AddNode(node);
+	}
+}
+
+
+PipelineExecutor::~PipelineExecutor() {
+	Stop();
+}
+
+
+void PipelineExecutor::SetNumStages(size_t numStages) {
+	m_numStagesRequested = numStages;
+	Invalidate();
+}
+
+
+void PipelineExecutor::PinToCallingThread(NodeBase* node, bool pinned) {
+	auto it = std::find(m_pinnedNodes.begin(), m_pinnedNodes.end(), node);
+	if (pinned && it == m_pinnedNodes.end()) {
+		m_pinnedNodes.push_back(node);
+	}
+	else if (!pinned && it != m_pinnedNodes.end()) {
+		m_pinnedNodes.erase(it);
+	}
+	Invalidate();
+}
+
+
+void PipelineExecutor::Stop() {
+	Invalidate();
+}
+
+
+size_t PipelineExecutor::GetNumStages() const {
+	return m_stages.size();
+}
+
+
+const std::vector<NodeBase*>& PipelineExecutor::GetStageNodes(size_t stage) const {
+	return m_stages[stage]->nodes;
+}
+
+
+size_t PipelineExecutor::GetQueueDepth(size_t stage) const {
+	size_t depth = 0;
+	for (auto boundary : m_stages[stage]->inputs) {
+		depth = std::max(depth, boundary->queue.Size());
+	}
+	return depth;
+}
+
+
+uint64_t PipelineExecutor::GetFramesProcessed(size_t stage) const {
+	return m_stages[stage]->numProcessed;
+}
+
+
+size_t PipelineExecutor::GetLatency() const {
+	return m_latency;
+}
+
+
+void PipelineExecutor::OnCompiled() {
+	try {
+		BuildStages();
+	}
+	catch (...) {
+		Invalidate(); // restores the links rerouted so far
+		throw;
+	}
+
+	m_stop = false;
+	size_t numWorkers = m_stages.size() - (m_hasPinnedStage ? 1 : 0);
+	for (size_t i = 0; i < numWorkers; ++i) {
+		m_stages[i]->thread = std::thread([this, i] { StageMain(i); });
+	}
+}
+
+
+void PipelineExecutor::OnInvalidated() {
+	m_stop = true;
+	for (auto& stage : m_stages) {
+		if (stage->thread.joinable()) {
+			stage->thread.join();
+		}
+	}
+
+	// put the original links back
+	for (auto& boundary : m_boundaries) {
+		for (auto& channel : boundary->channels) {
+			channel.capture->Unlink();
+			for (auto destination : channel.destinations) {
+				destination->Unlink();
+				channel.source->Link(destination);
+			}
+		}
+	}
+
+	m_stages.clear();
+	m_boundaries.clear();
+	m_ticks.clear();
+	m_hasPinnedStage = false;
+	m_latency = 0;
+	m_numInFlight = 0;
+	m_exception = nullptr;
+}
+
+
+void PipelineExecutor::BuildStages() {
+	const size_t numNodes = m_schedule.size();
+
+	// pinned nodes go to the last stage, the rest is cut into contiguous pieces of the schedule
+	std::vector<size_t> workerNodes;
+	std::vector<size_t> pinnedNodes;
+	for (size_t i = 0; i < numNodes; ++i) {
+		bool isPinned = std::find(m_pinnedNodes.begin(), m_pinnedNodes.end(), m_schedule[i].node) != m_pinnedNodes.end();
+		(isPinned ? pinnedNodes : workerNodes).push_back(i);
+	}
+	for (auto i : pinnedNodes) {
+		for (auto s : m_schedule[i].successors) {
+			if (std::find(pinnedNodes.begin(), pinnedNodes.end(), s) == pinnedNodes.end()) {
+				throw std::logic_error("Pinned nodes of a pipeline must not send data to nodes that are not pinned.");
+			}
+		}
+	}
+
+	size_t numWorkerStages = workerNodes.size();
+	if (m_numStagesRequested != 0) {
+		numWorkerStages = std::min(numWorkerStages, m_numStagesRequested);
+	}
+	std::vector<size_t> stageOf(numNodes);
+	for (size_t k = 0; k < workerNodes.size(); ++k) {
+		stageOf[workerNodes[k]] = k * numWorkerStages / workerNodes.size();
+	}
+	for (auto i : pinnedNodes) {
+		stageOf[i] = numWorkerStages;
+	}
+	m_hasPinnedStage = !pinnedNodes.empty();
+
+	size_t numStages = numWorkerStages + (m_hasPinnedStage ? 1 : 0);
+	for (size_t s = 0; s < numStages; ++s) {
+		m_stages.push_back(std::make_unique<Stage>());
+		m_stages.back()->numProcessed = 0;
+	}
+	for (size_t i = 0; i < numNodes; ++i) {
+		m_stages[stageOf[i]]->nodes.push_back(m_schedule[i].node);
+		m_stages[stageOf[i]]->scheduleIndices.push_back(i);
+	}
+
+	// reroute links that cross stages through a capture port, a queue, and a delivery port
+	std::unordered_map<const OutputPortBase*, size_t> outputStages;
+	for (size_t i = 0; i < numNodes; ++i) {
+		NodeBase* node = m_schedule[i].node;
+		for (size_t p = 0; p < node->GetNumOutputs(); ++p) {
+			outputStages[node->GetOutput(p)] = stageOf[i];
+		}
+	}
+	for (size_t s = 0; s < numStages; ++s) {
+		Stage& stage = *m_stages[s];
+		for (auto node : stage.nodes) {
+			for (size_t p = 0; p < node->GetNumInputs(); ++p) {
+				InputPortBase* destination = node->GetInput(p);
+				OutputPortBase* source = destination->GetLink();
+				auto it = outputStages.find(source);
+				if (it == outputStages.end() || it->second == s) {
+					continue;
+				}
+				if (source->GetType() == typeid(void)) {
+					throw std::logic_error("Void links cannot cross pipeline stages.");
+				}
+
+				size_t producer = it->second;
+				auto boundaryIt = std::find_if(stage.inputs.begin(), stage.inputs.end(), [producer](Boundary* b) { return b->producer == producer; });
+				if (boundaryIt == stage.inputs.end()) {
+					// a link skipping stages must buffer a frame for each stage it skips, or the producer stalls
+					m_boundaries.push_back(std::make_unique<Boundary>(producer, m_queueCapacity + (s - producer - 1)));
+					stage.inputs.push_back(m_boundaries.back().get());
+					m_stages[producer]->outputs.push_back(m_boundaries.back().get());
+					boundaryIt = stage.inputs.end() - 1;
+				}
+				auto& channels = (*boundaryIt)->channels;
+				auto channelIt = std::find_if(channels.begin(), channels.end(), [source](const Channel& c) { return c.source == source; });
+				if (channelIt == channels.end()) {
+					Channel channel;
+					channel.source = source;
+					channel.capture = std::make_unique<InputPort<Any>>();
+					channel.delivery = std::make_unique<OutputPort<Any>>();
+					source->Link(channel.capture.get());
+					channels.push_back(std::move(channel));
+					channelIt = channels.end() - 1;
+				}
+				destination->Unlink();
+				channelIt->delivery->Link(destination);
+				channelIt->destinations.push_back(destination);
+			}
+		}
+	}
+
+	// stages that receive nothing from other stages are started by Run()
+	for (auto& stage : m_stages) {
+		if (stage->inputs.empty()) {
+			m_boundaries.push_back(std::make_unique<Boundary>(NoProducer, m_queueCapacity));
+			stage->inputs.push_back(m_boundaries.back().get());
+			m_ticks.push_back(m_boundaries.back().get());
+		}
+		stage->frames.resize(stage->inputs.size());
+	}
+	for (auto& stage : m_stages) {
+		for (size_t i = 0; i < stage->inputs.size(); ++i) {
+			stage->frames[i].resize(stage->inputs[i]->channels.size());
+		}
+	}
+	for (auto& boundary : m_boundaries) {
+		boundary->frame.resize(boundary->channels.size());
+		boundary->queue.Fill(boundary->frame);
+	}
+
+	bool isPinnedStageFed = m_hasPinnedStage && m_stages.back()->inputs[0]->producer != NoProducer;
+	m_latency = isPinnedStageFed ? numWorkerStages : 0;
+}
+
+
+void PipelineExecutor::Run() {
+	if (!m_isCompiled) {
+		Compile();
+	}
+
+	for (auto tick : m_ticks) {
+		unsigned numSpins = 0;
+		while (!tick->queue.TryPushSwap(tick->frame)) {
+			Backoff(numSpins);
+		}
+	}
+
+	// once the pipeline is full, every tick started here completes an older one
+	if (m_hasPinnedStage) {
+		Stage& stage = *m_stages.back();
+		++m_numInFlight;
+		while (m_numInFlight > m_latency) {
+			PopFrames(stage);
+			Process(stage);
+			--m_numInFlight;
+		}
+	}
+
+	std::exception_ptr exception;
+	{
+		std::lock_guard<std::mutex> lkg(m_mtx);
+		std::swap(exception, m_exception);
+	}
+	if (exception) {
+		std::rethrow_exception(exception);
+	}
+}
+
+
+void PipelineExecutor::StageMain(size_t index) {
+	Stage& stage = *m_stages[index];
+	while (PopFrames(stage)) {
+		Process(stage);
+		if (!PushFrames(stage)) {
+			break;
+		}
+	}
+}
+
+
+bool PipelineExecutor::PopFrames(Stage& stage) {
+	for (size_t i = 0; i < stage.inputs.size(); ++i) {
+		unsigned numSpins = 0;
+		while (!stage.inputs[i]->queue.TryPopSwap(stage.frames[i])) {
+			if (m_stop) {
+				return false;
+			}
+			Backoff(numSpins);
+		}
+	}
+	return true;
+}
+
+
+void PipelineExecutor::Process(Stage& stage) {
+	// hand the frames to the inputs of this stage, ports not set by the producer keep their previous data
+	for (size_t i = 0; i < stage.inputs.size(); ++i) {
+		auto& channels = stage.inputs[i]->channels;
+		Frame& frame = stage.frames[i];
+		for (size_t k = 0; k < frame.size(); ++k) {
+			if (frame[k]) {
+				channels[k].delivery->Set(frame[k]);
+				frame[k].Reset();
+			}
+		}
+	}
+
+	try {
+		for (size_t i = 0; i < stage.nodes.size(); ++i) {
+			if (ShouldUpdate(stage.scheduleIndices[i])) {
+				GRAPH_PROFILE_UPDATE(stage.nodes[i]);
+				stage.nodes[i]->Update();
+			}
+		}
+	}
+	catch (...) {
+		std::lock_guard<std::mutex> lkg(m_mtx);
+		if (!m_exception) {
+			m_exception = std::current_exception();
+		}
+	}
+	++stage.numProcessed;
+}
+
+
+bool PipelineExecutor::PushFrames(Stage& stage) {
+	for (auto boundary : stage.outputs) {
+		Frame& frame = boundary->frame;
+		for (size_t k = 0; k < frame.size(); ++k) {
+			frame[k] = boundary->channels[k].capture->Take();
+		}
+
+		unsigned numSpins = 0;
+		while (!boundary->queue.TryPushSwap(frame)) {
+			if (m_stop) {
+				return false;
+			}
+			Backoff(numSpins);
+		}
+	}
+	return true;
+}
+
+
+} // namespace exc
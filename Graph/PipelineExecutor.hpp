@@ -0,0 +1,123 @@
+#pragma once
+
+#include "GraphExecutor.hpp"
+#include "Port.hpp"
+#include "SpscQueue.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace exc {
+
+
+/// <summary>
+/// <para> Runs a network as a pipeline, overlapping consecutive ticks. </para>
+/// <para>
+/// The schedule is cut into stages of consecutive nodes, and each stage gets its own
+/// worker thread. Data crossing from one stage to another is captured at the producer
+/// and passed through a bounded single-producer/single-consumer queue as one frame per tick,
+/// so while a later stage works on tick N, earlier stages already work on tick N+1.
+/// Each stage adds one tick of latency.
+/// </para>
+/// <para>
+/// Nodes pinned to the calling thread form the last stage, which is run by Run().
+/// They may only receive data, not send it to nodes that are not pinned.
+/// </para>
+/// <para>
+/// To pass data between stages, links that cross stages are rerouted through the executor
+/// while it's compiled. The original links are restored by Stop(), Invalidate(), or when the
+/// executor is destroyed. Don't change links while the pipeline is running.
+/// </para>
+/// </summary>
+class PipelineExecutor : public GraphExecutor {
+public:
+	/// <summary> Create the executor. Queue capacity is the number of frames that may
+	///		wait between two stages, at least one. </summary>
+	explicit PipelineExecutor(size_t queueCapacity = 1);
+	PipelineExecutor(std::initializer_list<NodeBase*> nodes, size_t queueCapacity = 1);
+	~PipelineExecutor();
+
+	/// <summary> Set how many worker stages to cut the schedule into. Zero means one stage per node. </summary>
+	void SetNumStages(size_t numStages);
+	/// <summary> Make the node always update on the thread that calls Run(). </summary>
+	void PinToCallingThread(NodeBase* node, bool pinned = true);
+
+	/// <summary> Start a new tick, and update the pinned nodes with the oldest finished tick.
+	///		Starts the workers if needed. Exceptions from nodes are rethrown here, possibly a few ticks late. </summary>
+	void Run() override;
+	/// <summary> Stop the workers and restore the original links. Frames in flight are discarded.
+	///		Run() starts the pipeline again. </summary>
+	void Stop();
+
+	/// <summary> Get the number of stages, including the one of pinned nodes. Zero until compiled. </summary>
+	size_t GetNumStages() const;
+	/// <summary> Get the nodes of a stage in update order. </summary>
+	const std::vector<NodeBase*>& GetStageNodes(size_t stage) const;
+	/// <summary> Get the number of frames waiting in front of a stage. </summary>
+	size_t GetQueueDepth(size_t stage) const;
+	/// <summary> Get how many ticks a stage has completed since it was started. </summary>
+	uint64_t GetFramesProcessed(size_t stage) const;
+	/// <summary> Get how many ticks it takes for a tick to reach the pinned nodes. </summary>
+	size_t GetLatency() const;
+protected:
+	void OnCompiled() override;
+	void OnInvalidated() override;
+private:
+	using Frame = std::vector<Any>;
+
+	/// <summary> An output port whose data is sent to another stage. </summary>
+	struct Channel {
+		OutputPortBase* source;
+		std::vector<InputPortBase*> destinations;
+		std::unique_ptr<InputPort<Any>> capture;
+		std::unique_ptr<OutputPort<Any>> delivery;
+	};
+	/// <summary> The queue between two stages. Producer is npos for ticks started by Run(). </summary>
+	struct Boundary {
+		Boundary(size_t producer, size_t capacity) : producer(producer), queue(capacity) {}
+		size_t producer;
+		std::vector<Channel> channels;
+		SpscQueue<Frame> queue;
+		// filled by the producer, then swapped with a slot of the queue, so frames are allocated once
+		Frame frame;
+	};
+	struct Stage {
+		std::vector<NodeBase*> nodes;
+		std::vector<size_t> scheduleIndices;
+		std::vector<Boundary*> inputs;
+		std::vector<Boundary*> outputs;
+		std::vector<Frame> frames;
+		std::atomic<uint64_t> numProcessed;
+		std::thread thread;
+	};
+
+	void BuildStages();
+	void StageMain(size_t stage);
+	bool PopFrames(Stage& stage);
+	void Process(Stage& stage);
+	bool PushFrames(Stage& stage);
+private:
+	size_t m_queueCapacity;
+	size_t m_numStagesRequested = 0;
+	std::vector<NodeBase*> m_pinnedNodes;
+
+	std::vector<std::unique_ptr<Stage>> m_stages;
+	std::vector<std::unique_ptr<Boundary>> m_boundaries;
+	std::vector<Boundary*> m_ticks;
+	bool m_hasPinnedStage = false;
+	size_t m_latency = 0;
+	size_t m_numInFlight = 0;
+
+	std::atomic_bool m_stop;
+	std::mutex m_mtx;
+	std::exception_ptr m_exception;
+};
+
+
+} // namespace exc
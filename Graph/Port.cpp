@@ -1,6 +1,7 @@
 #include "Port.hpp"
 #include "Node.hpp"
 
+#include <algorithm>
 #include <cassert>
 
 
@@ -14,6 +15,7 @@ namespace exc {
 
 InputPortBase::InputPortBase() {
 	link = nullptr;
+	version = 0;
 }
 
 
@@ -37,10 +39,22 @@ void InputPortBase::Unlink() {
 }
 
 
+PortTransfer InputPortBase::GetTransfer(std::type_index /*sourceType*/) {
+	PortTransfer transfer;
+	transfer.destination = this;
+	return transfer;
+}
+
+
 OutputPortBase* InputPortBase::GetLink() const {
 	return link;
 }
 
+
+uint64_t InputPortBase::GetVersion() const {
+	return version;
+}
+
 void InputPortBase::SetLinkState(OutputPortBase* link) {
 	this->link = link;
 }
@@ -49,16 +63,23 @@ void InputPortBase::SetLinkState(OutputPortBase* link) {
 /// Add observer node.
 /// Observers are notified when new input is set.
 void InputPortBase::AddObserver(NodeBase* observer) {
-	observers.insert(observer);
+	if (std::find(observers.begin(), observers.end(), observer) == observers.end()) {
+		observers.push_back(observer);
+	}
 }
 
 /// Remove observer.
 void InputPortBase::RemoveObserver(NodeBase* observer) {
-	observers.erase(observer);
+	auto it = std::find(observers.begin(), observers.end(), observer);
+	if (it != observers.end()) {
+		observers.erase(it);
+	}
 }
 
 
 void InputPortBase::NotifyAll() {
+	// every way of setting data ends up here
+	++version;
 	for (auto v : observers) {
 		v->Notify(this);
 	}
@@ -88,8 +109,9 @@ bool OutputPortBase::Link(InputPortBase* destination) {
 	}
 
 	if (destination->IsCompatible(GetType()) || GetType() == typeid(Any)) {
-		links.insert(destination);
+		links.push_back(destination);
 		destination->SetLinkState(this);
+		transfers.push_back(ResolveTransfer(destination));
 		return true;
 	}
 
@@ -97,13 +119,28 @@ bool OutputPortBase::Link(InputPortBase* destination) {
 }
 
 
-void OutputPortBase::Unlink(InputPortBase* other) {
-	std::set<InputPortBase*>::iterator it;
+bool OutputPortBase::LinkAt(InputPortBase* destination, size_t position) {
+	if (!Link(destination)) {
+		return false;
+	}
+	position = std::min(position, links.size() - 1);
+	std::rotate(links.begin() + position, links.end() - 1, links.end());
+	std::rotate(transfers.begin() + position, transfers.end() - 1, transfers.end());
+	return true;
+}
+
 
-	it = links.find(other);
+void OutputPortBase::Unlink(InputPortBase* other) {
+	auto it = std::find(links.begin(), links.end(), other);
 	if (it != links.end()) {
 		links.erase(it);
 		other->SetLinkState(nullptr);
+		// every link has a transfer, Link() adds them together
+		auto transfer = std::find_if(transfers.begin(), transfers.end(), [other](const PortTransfer& t) { return t.destination == other; });
+		assert(transfer != transfers.end());
+		if (transfer != transfers.end()) {
+			transfers.erase(transfer);
+		}
 		return;
 	}
 }
@@ -114,6 +151,18 @@ void OutputPortBase::UnlinkAll() {
 		v->SetLinkState(nullptr);
 	}
 	links.clear();
+	transfers.clear();
+}
+
+void OutputPortBase::SetLinkState(InputPortBase* destination, OutputPortBase* source) {
+	destination->SetLinkState(source);
+}
+
+
+PortTransfer OutputPortBase::ResolveTransfer(InputPortBase* destination) {
+	PortTransfer transfer;
+	transfer.destination = destination;
+	return transfer;
 }
 
 OutputPortBase::LinkIterator OutputPortBase::begin() {
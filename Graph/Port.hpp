@@ -1,6 +1,7 @@
 #pragma once
 
-#include <set>
+#include <algorithm>
+#include <cstdint>
 #include <typeinfo>
 #include <typeindex>
 #include <type_traits>
@@ -8,7 +9,10 @@
 #include <iterator>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 #include "../Any.hpp"
+#include "SharedFrame.hpp"
+#include "Profiler.hpp"
 
 
 namespace exc {
@@ -34,16 +38,45 @@ class InputPort;
 ///		to the destination type (defined by the specialization). </para>
 /// <para> If the conversion is not possible or not implemented, the operator[]
 ///		method should throw an std::out_of_range. </para>
+/// <para> By default, any type can be unwrapped from a <see cref="SharedFrame"/> of that type. </para>
 /// </summary>
 template <class T>
 class PortConverter {
 public:
 	using Functor = void(*)(const void*, void*);
 	Functor operator[](std::type_index type) const {
+		if (type == typeid(SharedFrame<T>)) {
+			return &FromFrame;
+		}
 		throw std::out_of_range("Cannot find a converter for this type.");
 	}
 	bool CanConvert(std::type_index type) const {
-		return false;
+		return type == typeid(SharedFrame<T>);
+	}
+private:
+	static void FromFrame(const void* src, void* dst) {
+		*reinterpret_cast<T*>(dst) = reinterpret_cast<const SharedFrame<T>*>(src)->Get();
+	}
+};
+
+
+/// <summary> Frame ports accept their plain payload type, and wrap it into a new frame. </summary>
+template <class T>
+class PortConverter<SharedFrame<T>> {
+public:
+	using Functor = void(*)(const void*, void*);
+	Functor operator[](std::type_index type) const {
+		if (type == typeid(T)) {
+			return &ToFrame;
+		}
+		throw std::out_of_range("Cannot find a converter for this type.");
+	}
+	bool CanConvert(std::type_index type) const {
+		return type == typeid(T);
+	}
+private:
+	static void ToFrame(const void* src, void* dst) {
+		*reinterpret_cast<SharedFrame<T>*>(dst) = SharedFrame<T>(*reinterpret_cast<const T*>(src));
 	}
 };
 
@@ -56,12 +89,21 @@ public:
 template <class T>
 class PortConverterCollection {
 public:
+	/// <summary> A registered conversion function, and the plain function that calls it with the right types. </summary>
+	struct Conversion {
+		void(*call)(void(*function)(), const void* src, void* dst);
+		void(*function)();
+		void operator()(const void* src, void* dst) const {
+			call(function, src, dst);
+		}
+	};
+
 	template <class... Functions>
 	explicit PortConverterCollection(Functions... functions) {
 		RegisterFunctions(functions...);
 	}
 
-	auto operator[](std::type_index sourceType) const -> const std::function<void(const void*, void*)>& {
+	Conversion operator[](std::type_index sourceType) const {
 		auto it = m_converters.find(sourceType);
 		if (it != m_converters.end()) {
 			return it->second;
@@ -84,17 +126,35 @@ private:
 
 	template <class SourceT>
 	void RegisterFunction(T(*function)(SourceT)) {
-		auto convfunc = [function](const void* src, void* dst)
-		{
-			*reinterpret_cast<T*>(dst) = function(*reinterpret_cast<const SourceT*>(src));
-		};
 		m_converters.insert({
-			typeid(SourceT),
-			convfunc
+			typeid(std::decay_t<SourceT>),
+			Conversion{ &Call<SourceT>, reinterpret_cast<void(*)()>(function) }
 		});
 	}
+
+	template <class SourceT>
+	static void Call(void(*function)(), const void* src, void* dst) {
+		*reinterpret_cast<T*>(dst) = reinterpret_cast<T(*)(SourceT)>(function)(*reinterpret_cast<const std::decay_t<SourceT>*>(src));
+	}
 private:
-	std::unordered_map<std::type_index, std::function<void(const void*, void*)>> m_converters;
+	std::unordered_map<std::type_index, Conversion> m_converters;
+};
+
+
+
+/// <summary>
+/// <para> A way to pass data of a certain type to an input port, resolved when linking. </para>
+/// <para> Copy and move are called with a pointer to the source object. Move is null if the
+///		destination cannot take over the source object. Both are null if the data has to
+///		be passed dynamically, by <see cref="InputPortBase::SetConvert"/>. </para>
+/// </summary>
+struct PortTransfer {
+	using CopyFunction = void(*)(InputPortBase* destination, const void* object);
+	using MoveFunction = void(*)(InputPortBase* destination, void* object);
+
+	InputPortBase* destination = nullptr;
+	CopyFunction copy = nullptr;
+	MoveFunction move = nullptr;
 };
 
 
@@ -124,6 +184,10 @@ public:
 	/// <summary> Get if can convert from certain type. </summary>
 	virtual bool IsCompatible(std::type_index type) const = 0;
 
+	/// <summary> Resolve how data of the source type is passed to this port, including the conversion.
+	///		Called by output ports when linked. The default is to pass data dynamically. </summary>
+	virtual PortTransfer GetTransfer(std::type_index sourceType);
+
 	/// <summary> Link this port to an output port. </summary>
 	/// <returns> True if succesfully linked. Make sures types are compatible. </returns>
 	bool Link(OutputPortBase* source);
@@ -141,6 +205,10 @@ public:
 	/// <returns> The other end. Null if not linked. </returns>
 	OutputPortBase* GetLink() const;
 
+	/// <summary> Get the number of times data has been set on this port.
+	///		Compare it to an earlier value to tell if new data has arrived since. </summary>
+	uint64_t GetVersion() const;
+
 	/// <summary> Set type that is to be converted automatically. </summary>
 	template <class U>
 	void SetConvert(const U& u);
@@ -153,7 +221,9 @@ private:
 	// this function only sets internal state of the inputport to represent the link set up by outputport
 	void SetLinkState(OutputPortBase* link);
 
-	std::set<NodeBase*> observers;
+	// few observers and links per port, flat arrays are faster to walk than trees
+	std::vector<NodeBase*> observers;
+	uint64_t version;
 };
 
 
@@ -168,8 +238,8 @@ private:
 /// </para>
 class OutputPortBase {
 public:
-	using LinkIterator = std::set<InputPortBase*>::iterator;
-	using ConstLinkIterator = std::set<InputPortBase*>::const_iterator;
+	using LinkIterator = std::vector<InputPortBase*>::iterator;
+	using ConstLinkIterator = std::vector<InputPortBase*>::const_iterator;
 public:
 	OutputPortBase();
 	~OutputPortBase();
@@ -181,6 +251,10 @@ public:
 	/// <returns> True if succesfully linked. Make sures types are compatible. </returns>
 	virtual bool Link(InputPortBase* destination);
 
+	/// <summary> Link to an input port at the given place among the links, to restore the order data is passed in. </summary>
+	/// <returns> True if succesfully linked. A position past the end links as the last port. </returns>
+	bool LinkAt(InputPortBase* destination, size_t position);
+
 	/// <summary> Remove link between this and the other end. </summary>
 	/// <param param="other"> The port to unlink from this. </param>
 	virtual void Unlink(InputPortBase* other);
@@ -196,7 +270,16 @@ public:
 	ConstLinkIterator cbegin() const;
 	ConstLinkIterator cend() const;
 protected:
-	std::set<InputPortBase*> links;
+	/// <summary> Lets derived ports keep their own list of links. </summary>
+	static void SetLinkState(InputPortBase* destination, OutputPortBase* source);
+
+	/// <summary> Resolve how to pass data to a newly linked input port. The default is to pass data dynamically. </summary>
+	virtual PortTransfer ResolveTransfer(InputPortBase* destination);
+
+	/// <summary> Linked ports, in the order they were linked. </summary>
+	std::vector<InputPortBase*> links;
+	/// <summary> Transfers of the linked ports, in the order they were linked. </summary>
+	std::vector<PortTransfer> transfers;
 };
 
 
@@ -230,6 +313,27 @@ public:
 		NotifyAll();
 	}
 
+	/// <summary> 
+	/// Set an object as input to this port by moving it in.
+	/// </summary>
+	void Set(T&& data) {
+		this->data = std::move(data);
+		isSet = true;
+		NotifyAll();
+	}
+
+	/// <summary>
+	/// Move the data out of the port. The port is cleared afterwards.
+	/// Use this instead of copying when the node consumes its input,
+	/// and use <see cref="Get"/> to borrow it without a copy.
+	/// </summary>
+	T Take() {
+		T taken = std::move(data);
+		data = T();
+		isSet = false;
+		return taken;
+	}
+
 	/// <summary> 
 	/// Get the data that was previously set.
 	/// If no data is set, the behaviour is undefined.
@@ -265,16 +369,27 @@ public:
 	}
 
 	virtual bool IsCompatible(std::type_index type) const override;
+
+	/// <summary> Data of type T is set directly, other types go through the converter looked up here, once. </summary>
+	PortTransfer GetTransfer(std::type_index sourceType) override;
 protected:
 	virtual void SetConvert(const void* object, std::type_index type) override;
+private:
+	static void CopyTransfer(InputPortBase* port, const void* object);
+	static void MoveTransfer(InputPortBase* port, void* object);
+	static void ConvertTransfer(InputPortBase* port, const void* object);
+
+	// a plain function pointer, or a small struct of them, not a type-erased functor
+	using ResolvedConverter = std::decay_t<decltype(std::declval<const ConverterT&>()[std::declval<std::type_index>()])>;
 private:
 	bool isSet;
 	T data;
 	ConverterT converter;
+	ResolvedConverter resolvedConverter = {};
 };
 
 
-template <class T, class ConverterT = PortConverter<T>>
+template <class T, class ConverterT>
 void InputPort<T, ConverterT>::SetConvert(const void* object, std::type_index type) {
 	if (type == typeid(T)) {
 		data = *reinterpret_cast<const T*>(object);
@@ -282,10 +397,49 @@ void InputPort<T, ConverterT>::SetConvert(const void* object, std::type_index ty
 	else {
 		converter[type](object, &data);
 	}
+	isSet = true;
+	NotifyAll();
 }
 
 
-template <class T, class ConverterT = PortConverter<T>>
+template <class T, class ConverterT>
+PortTransfer InputPort<T, ConverterT>::GetTransfer(std::type_index sourceType) {
+	PortTransfer transfer;
+	transfer.destination = this;
+	if (sourceType == typeid(T)) {
+		transfer.copy = &CopyTransfer;
+		transfer.move = &MoveTransfer;
+	}
+	else if (converter.CanConvert(sourceType)) {
+		resolvedConverter = converter[sourceType];
+		transfer.copy = &ConvertTransfer;
+	}
+	return transfer;
+}
+
+
+template <class T, class ConverterT>
+void InputPort<T, ConverterT>::CopyTransfer(InputPortBase* port, const void* object) {
+	static_cast<InputPort*>(port)->Set(*static_cast<const T*>(object));
+}
+
+
+template <class T, class ConverterT>
+void InputPort<T, ConverterT>::MoveTransfer(InputPortBase* port, void* object) {
+	static_cast<InputPort*>(port)->Set(std::move(*static_cast<T*>(object)));
+}
+
+
+template <class T, class ConverterT>
+void InputPort<T, ConverterT>::ConvertTransfer(InputPortBase* port, const void* object) {
+	auto self = static_cast<InputPort*>(port);
+	self->resolvedConverter(object, &self->data);
+	self->isSet = true;
+	self->NotifyAll();
+}
+
+
+template <class T, class ConverterT>
 bool InputPort<T, ConverterT>::IsCompatible(std::type_index type) const {
 	if (type == typeid(T)) {
 		return true;
@@ -313,16 +467,63 @@ public:
 	OutputPort(OutputPort&&) = default;
 	OutputPort& operator=(const OutputPort&) = default;
 	OutputPort& operator=(OutputPort&&) = default;
-
+	~OutputPort() {
+		UnlinkAll();
+	}
 
 	/// <summary> Set data on this port.
 	/// This data is forwarded to each input port linked to this one. </summary>
 	void Set(const T& data);
 
+	/// <summary> Set data on this port by moving it.
+	/// One linked input port of the same type takes over the data, the rest get copies.
+	/// If there's only one such input, the data is forwarded without copying. </summary>
+	void Set(T&& data);
+
+	/// <summary> Link to an input port of exactly the same type, checked at compile time.
+	/// Data is passed to such ports by a direct call, without type checks or conversion.
+	/// Direct links are not listed by the link iterators. </summary>
+	/// <returns> False if the input port is already linked. </returns>
+	bool LinkDirect(InputPort<T, PortConverter<T>>* destination) {
+		if (destination->GetLink() != nullptr) {
+			return false;
+		}
+		directLinks.push_back(destination);
+		SetLinkState(destination, this);
+		return true;
+	}
+
+	void Unlink(InputPortBase* other) override {
+		auto it = std::find(directLinks.begin(), directLinks.end(), other);
+		if (it != directLinks.end()) {
+			directLinks.erase(it);
+			SetLinkState(other, nullptr);
+		}
+		else {
+			OutputPortBase::Unlink(other);
+		}
+	}
+
+	void UnlinkAll() override {
+		for (auto v : directLinks) {
+			SetLinkState(v, nullptr);
+		}
+		directLinks.clear();
+		OutputPortBase::UnlinkAll();
+	}
+
 	/// <summary> Get type of underlying data. </summary>
 	std::type_index GetType() const override {
 		return typeid(T);
 	}
+protected:
+	PortTransfer ResolveTransfer(InputPortBase* destination) override;
+private:
+	void Forward(const PortTransfer& transfer, const T& data);
+	static void CopyToAny(InputPortBase* destination, const void* object);
+	static void MoveToAny(InputPortBase* destination, void* object);
+
+	std::vector<InputPort<T, PortConverter<T>>*> directLinks;
 };
 
 
@@ -431,6 +632,11 @@ public:
 		NotifyAll();
 	}
 
+	void Set(Any&& in) {
+		this->data = std::move(in);
+		NotifyAll();
+	}
+
 	/// Set void data.
 	/// May be called by void type ports.
 	bool Set() {
@@ -443,6 +649,11 @@ public:
 		return data;
 	}
 
+	/// Move the data out of the port. The port is cleared afterwards.
+	Any Take() {
+		return std::move(data);
+	}
+
 	void Clear() override {
 		data = {};
 	}
@@ -491,6 +702,31 @@ public:
 		}
 	}
 
+	/// Set data on this output port by moving it.
+	/// One linked any-type input port takes over the data, the rest get copies.
+	void Set(Any&& data) {
+		InputPortBase* target = nullptr;
+		for (auto& v : links) {
+			if (v->GetType() == typeid(Any)) {
+				target = v;
+			}
+		}
+		for (auto& v : links) {
+			if (v == target) {
+				continue;
+			}
+			if (v->GetType() != typeid(Any)) {
+				v->SetConvert(data.Raw(), data.Type());
+			}
+			else {
+				static_cast<InputPort<Any>*>(v)->Set(static_cast<const Any&>(data));
+			}
+		}
+		if (target != nullptr) {
+			static_cast<InputPort<Any>*>(target)->Set(std::move(data));
+		}
+	}
+
 	/// Get type of this port.
 	/// \return Always typeid(Any).
 	std::type_index GetType() const override {
@@ -508,17 +744,87 @@ private:
 
 template <class T>
 void OutputPort<T>::Set(const T& data) {
-	for (auto v : links) {
-		if (v->GetType() == GetType()) {
-			static_cast<InputPort<T>*>(v)->Set(data);
+	GRAPH_PROFILE_TRANSFER(this, data, transfers.size() + directLinks.size());
+
+	for (auto v : directLinks) {
+		v->Set(data);
+	}
+	for (auto& transfer : transfers) {
+		Forward(transfer, data);
+	}
+}
+
+
+template <class T>
+void OutputPort<T>::Set(T&& data) {
+	GRAPH_PROFILE_TRANSFER(this, data, transfers.size() + directLinks.size());
+
+	if (transfers.empty()) {
+		if (!directLinks.empty()) {
+			for (size_t i = 0; i + 1 < directLinks.size(); ++i) {
+				directLinks[i]->Set(data);
+			}
+			directLinks.back()->Set(std::move(data));
 		}
-		else if (v->GetType() == typeid(Any)) {
-			static_cast<InputPort<Any>*>(v)->Set(data);
+		return;
+	}
+	for (auto v : directLinks) {
+		v->Set(data);
+	}
+
+	// find the input to move into, preferably one of the same type, else an any-type one
+	const PortTransfer* target = nullptr;
+	for (auto& transfer : transfers) {
+		if (transfer.move != nullptr && (transfer.move != &MoveToAny || target == nullptr)) {
+			target = &transfer;
 		}
-		else {
-			v->SetConvert(data);
+	}
+
+	for (auto& transfer : transfers) {
+		if (&transfer != target) {
+			Forward(transfer, data);
 		}
 	}
+	if (target != nullptr) {
+		target->move(target->destination, &data);
+	}
+}
+
+
+template <class T>
+PortTransfer OutputPort<T>::ResolveTransfer(InputPortBase* destination) {
+	// any-type ports cannot know the source type themselves
+	if (destination->GetType() == typeid(Any)) {
+		PortTransfer transfer;
+		transfer.destination = destination;
+		transfer.copy = &CopyToAny;
+		transfer.move = &MoveToAny;
+		return transfer;
+	}
+	return destination->GetTransfer(typeid(T));
+}
+
+
+template <class T>
+void OutputPort<T>::Forward(const PortTransfer& transfer, const T& data) {
+	if (transfer.copy != nullptr) {
+		transfer.copy(transfer.destination, &data);
+	}
+	else {
+		transfer.destination->SetConvert(data);
+	}
+}
+
+
+template <class T>
+void OutputPort<T>::CopyToAny(InputPortBase* destination, const void* object) {
+	static_cast<InputPort<Any>*>(destination)->Set(*static_cast<const T*>(object));
+}
+
+
+template <class T>
+void OutputPort<T>::MoveToAny(InputPortBase* destination, void* object) {
+	static_cast<InputPort<Any>*>(destination)->Set(std::move(*static_cast<T*>(object)));
 }
 
 
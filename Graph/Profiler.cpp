@@ -0,0 +1,403 @@
+#include "Profiler.hpp"
+
+#ifdef ENABLE_GRAPH_PROFILER
+
+#include "Node.hpp"
+#include "AllocationCounter.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <typeinfo>
+#include <unordered_map>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+
+namespace exc {
+
+
+namespace {
+
+constexpr size_t MaxEventsPerThread = 1 << 16;
+
+struct NodeStats {
+	std::string name;
+	uint64_t numUpdates = 0;
+	int64_t wallTime = 0;
+	int64_t maxWallTime = 0;
+	int64_t cpuTime = 0;
+	uint64_t numAllocations = 0;
+	uint64_t numBytesOut = 0;
+};
+
+struct PortStats {
+	std::string name;
+	uint64_t numSets = 0;
+	uint64_t numBytesPerLink = 0;
+	uint64_t numBytes = 0;
+	size_t numLinks = 0;
+};
+
+struct Event {
+	const NodeBase* node;
+	int64_t start;
+	int64_t duration;
+	int64_t cpuTime;
+	uint64_t numAllocations;
+	uint64_t numBytesOut;
+};
+
+// Everything a thread recorded. Owned by the registry, so it outlives the thread.
+struct ThreadState {
+	std::mutex mtx;
+	size_t id;
+	std::unordered_map<const NodeBase*, NodeStats> nodes;
+	std::unordered_map<const OutputPortBase*, PortStats> ports;
+	std::vector<Event> events; // ring buffer of the last updates
+	size_t nextEvent = 0;
+};
+
+struct Registry {
+	std::mutex mtx;
+	std::vector<std::unique_ptr<ThreadState>> threads;
+	std::unordered_map<const NodeBase*, std::string> names;
+	const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+Registry& GetRegistry() {
+	static Registry registry;
+	return registry;
+}
+
+std::atomic_bool isEnabled(true);
+
+thread_local ThreadState* currentThread = nullptr;
+thread_local const NodeBase* currentNode = nullptr;
+thread_local uint64_t numBytesOut = 0;
+
+
+ThreadState& GetThreadState() {
+	if (!currentThread) {
+		Registry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lkg(registry.mtx);
+		registry.threads.push_back(std::make_unique<ThreadState>());
+		currentThread = registry.threads.back().get();
+		currentThread->id = registry.threads.size();
+		currentThread->events.reserve(MaxEventsPerThread);
+	}
+	return *currentThread;
+}
+
+
+int64_t WallTime() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - GetRegistry().epoch).count();
+}
+
+
+int64_t ThreadCpuTime() {
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+	auto toInt = [](FILETIME t) { return (int64_t(t.dwHighDateTime) << 32) | t.dwLowDateTime; };
+	return (toInt(kernel) + toInt(user)) * 100;
+#else
+	timespec time;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+	return int64_t(time.tv_sec) * 1000000000 + time.tv_nsec;
+#endif
+}
+
+
+// Must be called with the registry locked. Lock order is the registry first, then a thread.
+std::string GetNodeName(const Registry& registry, const NodeBase* node) {
+	if (node == nullptr) {
+		return "(outside nodes)";
+	}
+	auto it = registry.names.find(node);
+	return it != registry.names.end() ? it->second : typeid(*node).name();
+}
+
+
+std::string EscapeJson(const std::string& str) {
+	std::string escaped;
+	for (char c : str) {
+		if (c == '"' || c == '\\') {
+			escaped += '\\';
+		}
+		escaped += c;
+	}
+	return escaped;
+}
+
+} // namespace
+
+
+
+Profiler::UpdateScope::UpdateScope(const NodeBase* node) {
+	m_isActive = isEnabled.load(std::memory_order_relaxed);
+	m_node = node;
+	m_previousNode = currentNode;
+	currentNode = node;
+	if (m_isActive) {
+		m_numAllocationsStart = AllocationCounter::GetNumThreadAllocations();
+		m_numBytesStart = numBytesOut;
+		m_cpuStart = ThreadCpuTime();
+		m_wallStart = WallTime();
+	}
+}
+
+
+Profiler::UpdateScope::~UpdateScope() {
+	currentNode = m_previousNode;
+	if (!m_isActive) {
+		return;
+	}
+
+	Event event;
+	event.duration = WallTime() - m_wallStart;
+	event.cpuTime = ThreadCpuTime() - m_cpuStart;
+	event.node = m_node;
+	event.start = m_wallStart;
+	event.numAllocations = AllocationCounter::GetNumThreadAllocations() - m_numAllocationsStart;
+	event.numBytesOut = numBytesOut - m_numBytesStart;
+
+	// bookkeeping allocates the first time a node is seen, that's not the node's fault
+	uint64_t numAllocationsBefore = AllocationCounter::GetNumThreadAllocations();
+
+	ThreadState& thread = GetThreadState();
+	std::unique_lock<std::mutex> lk(thread.mtx);
+	auto it = thread.nodes.find(m_node);
+	if (it == thread.nodes.end()) {
+		lk.unlock();
+		std::string name;
+		{
+			Registry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lkg(registry.mtx);
+			name = GetNodeName(registry, m_node);
+		}
+		lk.lock();
+		it = thread.nodes.insert({ m_node, NodeStats{} }).first;
+		it->second.name = std::move(name);
+	}
+	NodeStats& stats = it->second;
+	++stats.numUpdates;
+	stats.wallTime += event.duration;
+	stats.maxWallTime = std::max(stats.maxWallTime, event.duration);
+	stats.cpuTime += event.cpuTime;
+	stats.numAllocations += event.numAllocations;
+	stats.numBytesOut += event.numBytesOut;
+
+	if (thread.events.size() < MaxEventsPerThread) {
+		thread.events.push_back(event);
+	}
+	else {
+		thread.events[thread.nextEvent] = event;
+	}
+	thread.nextEvent = (thread.nextEvent + 1) % MaxEventsPerThread;
+
+	AllocationCounter::RestoreNumThreadAllocations(numAllocationsBefore);
+}
+
+
+void Profiler::RecordTransfer(const OutputPortBase* port, size_t numBytes, size_t numLinks) {
+	if (!isEnabled.load(std::memory_order_relaxed)) {
+		return;
+	}
+	uint64_t numAllocationsBefore = AllocationCounter::GetNumThreadAllocations();
+
+	numBytesOut += numBytes * numLinks;
+
+	ThreadState& thread = GetThreadState();
+	std::unique_lock<std::mutex> lk(thread.mtx);
+	auto it = thread.ports.find(port);
+	if (it == thread.ports.end()) {
+		// name the port after the node that sets it, while the node is surely alive
+		lk.unlock();
+		std::string name;
+		{
+			Registry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lkg(registry.mtx);
+			name = GetNodeName(registry, currentNode);
+		}
+		if (currentNode != nullptr) {
+			auto node = const_cast<NodeBase*>(currentNode);
+			for (size_t i = 0; i < node->GetNumOutputs(); ++i) {
+				if (node->GetOutput(i) == port) {
+					name += ".out" + std::to_string(i);
+				}
+			}
+		}
+		lk.lock();
+		it = thread.ports.insert({ port, PortStats{} }).first;
+		it->second.name = std::move(name);
+	}
+	PortStats& stats = it->second;
+	++stats.numSets;
+	stats.numBytesPerLink += numBytes;
+	stats.numBytes += numBytes * numLinks;
+	stats.numLinks = numLinks;
+
+	AllocationCounter::RestoreNumThreadAllocations(numAllocationsBefore);
+}
+
+
+void Profiler::SetEnabled(bool enabled) {
+	isEnabled = enabled;
+}
+
+
+bool Profiler::IsEnabled() {
+	return isEnabled;
+}
+
+
+void Profiler::SetNodeName(const NodeBase* node, const std::string& name) {
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lkg(registry.mtx);
+	registry.names[node] = name;
+}
+
+
+void Profiler::WriteChromeTrace(std::ostream& out) {
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lkg(registry.mtx);
+
+	const std::string unknownName = "(unknown)";
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool isFirst = true;
+	for (auto& thread : registry.threads) {
+		std::lock_guard<std::mutex> lkgThread(thread->mtx);
+		out << (isFirst ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->id
+			<< ",\"args\":{\"name\":\"Thread " << thread->id << "\"}}";
+		isFirst = false;
+
+		// oldest first
+		size_t numEvents = thread->events.size();
+		size_t first = numEvents < MaxEventsPerThread ? 0 : thread->nextEvent;
+		for (size_t i = 0; i < numEvents; ++i) {
+			const Event& event = thread->events[(first + i) % numEvents];
+			auto nodeIt = thread->nodes.find(event.node);
+			const std::string& name = nodeIt != thread->nodes.end() ? nodeIt->second.name : unknownName;
+			out << std::fixed << std::setprecision(3)
+				<< ",\n{\"name\":\"" << EscapeJson(name) << "\",\"cat\":\"node\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->id
+				<< ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << event.duration / 1000.0
+				<< ",\"args\":{\"cpu_us\":" << event.cpuTime / 1000.0
+				<< ",\"allocations\":" << event.numAllocations
+				<< ",\"bytes_out\":" << event.numBytesOut << "}}";
+		}
+	}
+	out << "\n]}\n";
+}
+
+
+void Profiler::WriteSummary(std::ostream& out) {
+	// merge the threads' statistics
+	std::unordered_map<const NodeBase*, NodeStats> nodes;
+	std::unordered_map<const OutputPortBase*, PortStats> ports;
+	{
+		Registry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lkg(registry.mtx);
+		for (auto& thread : registry.threads) {
+			std::lock_guard<std::mutex> lkgThread(thread->mtx);
+			for (auto& entry : thread->nodes) {
+				NodeStats& total = nodes[entry.first];
+				total.name = entry.second.name;
+				total.numUpdates += entry.second.numUpdates;
+				total.wallTime += entry.second.wallTime;
+				total.maxWallTime = std::max(total.maxWallTime, entry.second.maxWallTime);
+				total.cpuTime += entry.second.cpuTime;
+				total.numAllocations += entry.second.numAllocations;
+				total.numBytesOut += entry.second.numBytesOut;
+			}
+			for (auto& entry : thread->ports) {
+				PortStats& total = ports[entry.first];
+				total.name = entry.second.name;
+				total.numSets += entry.second.numSets;
+				total.numBytesPerLink += entry.second.numBytesPerLink;
+				total.numBytes += entry.second.numBytes;
+				total.numLinks = entry.second.numLinks;
+			}
+		}
+	}
+
+	// most expensive first
+	std::vector<const NodeStats*> sortedNodes;
+	for (auto& entry : nodes) {
+		sortedNodes.push_back(&entry.second);
+	}
+	std::sort(sortedNodes.begin(), sortedNodes.end(), [](const NodeStats* a, const NodeStats* b) { return a->wallTime > b->wallTime; });
+	std::vector<const PortStats*> sortedPorts;
+	for (auto& entry : ports) {
+		sortedPorts.push_back(&entry.second);
+	}
+	std::sort(sortedPorts.begin(), sortedPorts.end(), [](const PortStats* a, const PortStats* b) { return a->numBytes > b->numBytes; });
+
+	out << std::fixed << std::setprecision(3);
+	out << "Node                                      updates   total ms    avg us    max us     cpu ms    allocs/update  bytes out/update\n";
+	for (auto stats : sortedNodes) {
+		double numUpdates = double(std::max(stats->numUpdates, uint64_t(1)));
+		out << std::left << std::setw(40) << stats->name.substr(0, 40) << std::right
+			<< std::setw(10) << stats->numUpdates
+			<< std::setw(11) << stats->wallTime / 1e6
+			<< std::setw(10) << stats->wallTime / 1e3 / numUpdates
+			<< std::setw(10) << stats->maxWallTime / 1e3
+			<< std::setw(11) << stats->cpuTime / 1e6
+			<< std::setw(17) << stats->numAllocations / numUpdates
+			<< std::setw(18) << stats->numBytesOut / numUpdates << "\n";
+	}
+	out << "\nOutput port                                  sets  links  bytes/set/link      total MB\n";
+	for (auto stats : sortedPorts) {
+		double numSets = double(std::max(stats->numSets, uint64_t(1)));
+		out << std::left << std::setw(40) << stats->name.substr(0, 40) << std::right
+			<< std::setw(10) << stats->numSets
+			<< std::setw(7) << stats->numLinks
+			<< std::setw(16) << stats->numBytesPerLink / numSets
+			<< std::setw(14) << stats->numBytes / 1e6 << "\n";
+	}
+}
+
+
+uint64_t Profiler::GetNumAllocations() {
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lkg(registry.mtx);
+	uint64_t total = 0;
+	for (auto& thread : registry.threads) {
+		std::lock_guard<std::mutex> lkgThread(thread->mtx);
+		for (auto& entry : thread->nodes) {
+			total += entry.second.numAllocations;
+		}
+	}
+	return total;
+}
+
+
+void Profiler::Reset() {
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lkg(registry.mtx);
+	for (auto& thread : registry.threads) {
+		std::lock_guard<std::mutex> lkgThread(thread->mtx);
+		thread->nodes.clear();
+		thread->ports.clear();
+		thread->events.clear();
+		thread->nextEvent = 0;
+	}
+}
+
+
+} // namespace exc
+
+
+
+#endif // ENABLE_GRAPH_PROFILER
@@ -0,0 +1,147 @@
+#pragma once
+
+// The profiler is compiled in only if ENABLE_GRAPH_PROFILER is defined for the whole project.
+// Otherwise the instrumentation macros below expand to nothing.
+
+#include "SampleStream.hpp"
+#include "SharedFrame.hpp"
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+namespace exc {
+
+class NodeBase;
+class OutputPortBase;
+
+
+/// <summary>
+/// Estimates the number of bytes an object carries, including what it owns on the heap.
+/// Specialize it for containers of your own. A frame counts the payload it refers to.
+/// </summary>
+template <class T>
+struct PayloadSize {
+	static size_t Get(const T&) {
+		return sizeof(T);
+	}
+};
+
+template <class T, class Alloc>
+struct PayloadSize<std::vector<T, Alloc>> {
+	static size_t Get(const std::vector<T, Alloc>& object) {
+		size_t size = sizeof(object);
+		for (auto& element : object) {
+			size += PayloadSize<T>::Get(element);
+		}
+		return size;
+	}
+};
+
+template <class Alloc>
+struct PayloadSize<std::vector<float, Alloc>> {
+	static size_t Get(const std::vector<float, Alloc>& object) {
+		return sizeof(object) + object.size() * sizeof(float);
+	}
+};
+
+template <class T, class Alloc>
+struct PayloadSize<std::vector<std::complex<T>, Alloc>> {
+	static size_t Get(const std::vector<std::complex<T>, Alloc>& object) {
+		return sizeof(object) + object.size() * sizeof(std::complex<T>);
+	}
+};
+
+template <class Char, class Traits, class Alloc>
+struct PayloadSize<std::basic_string<Char, Traits, Alloc>> {
+	static size_t Get(const std::basic_string<Char, Traits, Alloc>& object) {
+		return sizeof(object) + object.size() * sizeof(Char);
+	}
+};
+
+template <class T>
+struct PayloadSize<SharedFrame<T>> {
+	static size_t Get(const SharedFrame<T>& frame) {
+		return sizeof(frame) + (frame ? PayloadSize<T>::Get(*frame) : 0);
+	}
+};
+
+template <>
+struct PayloadSize<StreamChunk> {
+	static size_t Get(const StreamChunk& chunk) {
+		return sizeof(chunk) + chunk.GetNumSamples() * chunk.GetNumChannels() * sizeof(float);
+	}
+};
+
+
+#ifdef ENABLE_GRAPH_PROFILER
+
+/// <summary>
+/// <para> Collects timing, allocation and data transfer statistics of nodes. </para>
+/// <para>
+/// The executors measure each node update: wall time, CPU time of the thread, and the
+/// number of heap allocations made during it. Output ports count the number of bytes they
+/// pass to each link. Each thread records into its own buffers, the last updates of each
+/// thread are kept for the trace.
+/// </para>
+/// <para>
+/// Statistics can be exported as a Chrome trace (chrome://tracing or ui.perfetto.dev),
+/// or as a text summary aggregated per node and per output port.
+/// </para>
+/// </summary>
+class Profiler {
+public:
+	/// <summary> Measures the update of a node during its lifetime. </summary>
+	class UpdateScope {
+	public:
+		explicit UpdateScope(const NodeBase* node);
+		UpdateScope(const UpdateScope&) = delete;
+		UpdateScope& operator=(const UpdateScope&) = delete;
+		~UpdateScope();
+	private:
+		const NodeBase* m_node;
+		const NodeBase* m_previousNode;
+		int64_t m_wallStart;
+		int64_t m_cpuStart;
+		uint64_t m_numAllocationsStart;
+		uint64_t m_numBytesStart;
+		bool m_isActive;
+	};
+
+	/// <summary> Record that an output port passed an object of numBytes to numLinks input ports. </summary>
+	static void RecordTransfer(const OutputPortBase* port, size_t numBytes, size_t numLinks);
+
+	/// <summary> Turn recording on or off at runtime. It is on by default. </summary>
+	static void SetEnabled(bool enabled);
+	static bool IsEnabled();
+	/// <summary> Set the name that appears in the reports. Defaults to the node's type name. </summary>
+	static void SetNodeName(const NodeBase* node, const std::string& name);
+
+	/// <summary> Write the recorded updates in the Chrome trace event format. </summary>
+	static void WriteChromeTrace(std::ostream& out);
+	/// <summary> Write statistics aggregated per node and per output port. </summary>
+	static void WriteSummary(std::ostream& out);
+	/// <summary> Number of heap allocations made by node updates on all threads since the last Reset(). </summary>
+	static uint64_t GetNumAllocations();
+	/// <summary> Discard all recorded data. </summary>
+	static void Reset();
+};
+
+#define GRAPH_PROFILE_UPDATE(node) ::exc::Profiler::UpdateScope graphProfilerUpdateScope_(node)
+#define GRAPH_PROFILE_TRANSFER(port, object, numLinks) \
+	::exc::Profiler::RecordTransfer(port, ::exc::PayloadSize<std::decay_t<decltype(object)>>::Get(object), numLinks)
+
+#else
+
+#define GRAPH_PROFILE_UPDATE(node) ((void)0)
+#define GRAPH_PROFILE_TRANSFER(port, object, numLinks) ((void)0)
+
+#endif
+
+
+} // namespace exc
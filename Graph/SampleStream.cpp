@@ -0,0 +1,250 @@
+#include "SampleStream.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+
+namespace exc {
+
+
+SampleStream::SampleStream(size_t numChannels, size_t capacity)
+	: m_numChannels(numChannels),
+	m_capacity(capacity),
+	m_samples(numChannels * 2 * capacity, 0.0f),
+	m_writePosition(0),
+	m_firstValidPosition(0),
+	m_declaredHistory(0)
+{
+	if (capacity == 0) {
+		throw std::invalid_argument("Stream capacity must be at least 1.");
+	}
+}
+
+
+void SampleStream::DeclareHistory(size_t history) const {
+	size_t current = m_declaredHistory.load(std::memory_order_relaxed);
+	while (current < history && !m_declaredHistory.compare_exchange_weak(current, history, std::memory_order_relaxed)) {}
+}
+
+
+void SampleStream::Store(size_t channel, int64_t position, const float* samples, size_t count) {
+	float* storage = m_samples.data() + channel * 2 * m_capacity;
+	size_t index = Wrap(position);
+	// both halves get the samples up to the end of the half, and the rest at their start
+	size_t numFirst = std::min(count, m_capacity - index);
+	memcpy(storage + index, samples, numFirst * sizeof(float));
+	memcpy(storage + index + m_capacity, samples, numFirst * sizeof(float));
+	memcpy(storage, samples + numFirst, (count - numFirst) * sizeof(float));
+	memcpy(storage + m_capacity, samples + numFirst, (count - numFirst) * sizeof(float));
+}
+
+
+void SampleStream::Mirror(size_t channel, int64_t position, size_t count) {
+	float* storage = m_samples.data() + channel * 2 * m_capacity;
+	size_t index = Wrap(position);
+	// the part in the first half goes to the second, the part that ran over into the second half goes to the first
+	size_t numFirst = std::min(count, m_capacity - index);
+	memcpy(storage + index + m_capacity, storage + index, numFirst * sizeof(float));
+	memcpy(storage, storage + m_capacity, (count - numFirst) * sizeof(float));
+}
+
+
+
+StreamTimestamp StreamTimestamp::Captured(int64_t sourcePosition, int sourceRate, Clock::time_point captureTime) {
+	StreamTimestamp timestamp;
+	timestamp.sourcePosition = sourcePosition;
+	timestamp.sourceRate = sourceRate;
+	if (sourceRate > 0) {
+		timestamp.sourceOrigin = captureTime - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(double(sourcePosition) / sourceRate));
+	}
+	return timestamp;
+}
+
+
+auto StreamTimestamp::GetCaptureTime() const -> Clock::time_point {
+	return sourceOrigin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(double(sourcePosition) / sourceRate));
+}
+
+
+
+StreamWriter::StreamWriter(size_t numChannels, size_t minCapacity)
+	: m_numChannels(numChannels), m_minCapacity(minCapacity)
+{}
+
+
+void StreamWriter::SetNumChannels(size_t numChannels) {
+	if (numChannels == m_numChannels) {
+		return;
+	}
+	m_numChannels = numChannels;
+	if (m_stream) {
+		Replace(numChannels, m_stream->GetCapacity(), false);
+	}
+}
+
+
+void StreamWriter::Reserve(size_t capacity) {
+	m_minCapacity = capacity;
+	if (m_stream && m_stream->GetCapacity() < capacity) {
+		Replace(m_numChannels, capacity, true);
+	}
+}
+
+
+void StreamWriter::BeginBlock(size_t count) {
+	size_t history = m_stream ? m_stream->GetDeclaredHistory() : 0;
+	size_t required = std::max(history + count, m_minCapacity);
+	if (!m_stream || m_stream->GetCapacity() < required) {
+		// blocks vary in size from tick to tick, leave room so the ring doesn't have to grow again right away
+		size_t capacity = 1;
+		while (capacity < 2 * (history + count)) {
+			capacity *= 2;
+		}
+		Replace(m_numChannels, std::max(capacity, m_minCapacity), true);
+	}
+	m_blockSize = count;
+}
+
+
+void StreamWriter::Write(size_t channel, const float* samples) {
+	m_stream->Store(channel, m_position, samples, m_blockSize);
+}
+
+
+StreamChunk StreamWriter::EndBlock() {
+	StreamChunk chunk;
+	chunk.stream = m_stream;
+	chunk.begin = m_position;
+	chunk.end = m_position + (int64_t)m_blockSize;
+	chunk.timestamp = m_timestamp;
+
+	if (m_isFilledInPlace) {
+		for (size_t channel = 0; channel < m_numChannels; ++channel) {
+			m_stream->Mirror(channel, m_position, m_blockSize);
+		}
+		m_isFilledInPlace = false;
+	}
+	m_position = chunk.end;
+	m_timestamp = m_timestamp.Advanced((int64_t)m_blockSize);
+	m_blockSize = 0;
+	m_stream->m_writePosition.store(m_position, std::memory_order_release);
+	return chunk;
+}
+
+
+StreamChunk StreamWriter::Write(const float* samples, size_t count) {
+	BeginBlock(count);
+	Write(0, samples);
+	return EndBlock();
+}
+
+
+void StreamWriter::Replace(size_t numChannels, size_t capacity, bool carryOver) {
+	auto stream = std::make_shared<SampleStream>(numChannels, capacity);
+	stream->m_writePosition.store(m_position, std::memory_order_relaxed);
+	stream->m_firstValidPosition = m_position;
+
+	if (m_stream) {
+		stream->DeclareHistory(m_stream->GetDeclaredHistory());
+	}
+	if (m_stream && carryOver) {
+		const SampleStream& old = *m_stream;
+		int64_t oldest = m_position - (int64_t)std::min(old.GetCapacity(), capacity);
+		for (size_t channel = 0; channel < numChannels; ++channel) {
+			for (int64_t position = oldest; position < m_position; ++position) {
+				stream->Store(channel, position, *old.GetSamples(channel, position));
+			}
+		}
+		stream->m_firstValidPosition = std::max(old.GetFirstValidPosition(), oldest);
+	}
+
+	m_stream = std::move(stream);
+}
+
+
+
+StreamReader::StreamReader(size_t history)
+	: m_history(history)
+{}
+
+
+void StreamReader::SetHistory(size_t history) {
+	m_history = history;
+}
+
+
+StreamWindow StreamReader::Read(const StreamChunk& chunk) {
+	if (chunk.IsEmpty()) {
+		return Fail();
+	}
+	const SampleStream& stream = *chunk.stream;
+	stream.DeclareHistory(m_history);
+
+	if (!m_isStarted) {
+		m_cursor = chunk.begin;
+		m_isStarted = true;
+	}
+
+	// chunks the reader missed are still read as long as the ring holds them
+	int64_t oldest = stream.GetWritePosition() - (int64_t)stream.GetCapacity();
+	int64_t resume = std::max(oldest, stream.GetFirstValidPosition());
+	if (m_cursor < resume) {
+		++m_numOverflows;
+		m_numDroppedSamples += uint64_t(resume - m_cursor);
+		m_cursor = resume;
+	}
+	if (chunk.end <= m_cursor) {
+		return Fail();
+	}
+
+	int64_t start = m_cursor - (int64_t)m_history;
+	int64_t end = chunk.end;
+	size_t numChannels = stream.GetNumChannels();
+
+	// history that was overwritten or dropped reads as zeros, silence before the stream began does not count
+	int64_t firstValid = std::max(stream.GetFirstValidPosition(), start < oldest ? oldest : std::numeric_limits<int64_t>::min());
+	if (std::max<int64_t>(start, 0) < std::min(firstValid, m_cursor)) {
+		++m_numUnderruns;
+	}
+
+	m_channels.resize(numChannels);
+	if (start >= oldest) {
+		for (size_t channel = 0; channel < numChannels; ++channel) {
+			m_channels[channel] = stream.GetSamples(channel, start);
+		}
+	}
+	else {
+		// the ring is shorter than the history, the writer grows it on the next block
+		size_t length = size_t(end - start);
+		size_t numMissing = size_t(oldest - start);
+		m_copy.resize(numChannels * length);
+		for (size_t channel = 0; channel < numChannels; ++channel) {
+			float* copy = m_copy.data() + channel * length;
+			std::fill(copy, copy + numMissing, 0.0f);
+			std::memcpy(copy + numMissing, stream.GetSamples(channel, oldest), (length - numMissing) * sizeof(float));
+			m_channels[channel] = copy;
+		}
+	}
+
+	StreamWindow window(m_channels.data(), numChannels, m_history, size_t(end - m_cursor), m_cursor, chunk.GetTimestamp(m_cursor));
+	m_stream = chunk.stream;
+	m_cursor = end;
+	return window;
+}
+
+
+void StreamReader::Reset() {
+	m_isStarted = false;
+	m_stream.reset();
+}
+
+
+StreamWindow StreamReader::Fail() {
+	++m_numUnderruns;
+	return StreamWindow(nullptr, 0, m_history, 0, m_cursor);
+}
+
+
+} // namespace exc
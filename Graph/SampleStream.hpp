@@ -0,0 +1,296 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+namespace exc {
+
+
+/// <summary>
+/// <para> Ring buffer of planar float samples, shared by the output that writes it and the inputs that read it. </para>
+/// <para>
+/// Samples are addressed by their absolute position in the stream. The ring holds the last
+/// GetCapacity() samples of each channel twice, once in each half of the channel's storage, so that any
+/// window of at most GetCapacity() samples can be read as a contiguous array. Positions before 0
+/// read as silence, so readers can look back from the very first sample.
+/// </para>
+/// <para> Streams are created and written by a <see cref="StreamWriter"/>, and read through a <see cref="StreamReader"/>. </para>
+/// </summary>
+class SampleStream {
+	friend class StreamWriter;
+public:
+	SampleStream(size_t numChannels, size_t capacity);
+
+	size_t GetNumChannels() const { return m_numChannels; }
+	size_t GetCapacity() const { return m_capacity; }
+
+	/// <summary> Position one past the last sample written. </summary>
+	int64_t GetWritePosition() const { return m_writePosition.load(std::memory_order_acquire); }
+	/// <summary> Samples between 0 and this position were dropped when the ring was replaced, they read as zeros. </summary>
+	int64_t GetFirstValidPosition() const { return m_firstValidPosition; }
+
+	/// <summary> Pointer to the sample at position. The following samples up to the write position are contiguous. </summary>
+	/// <remarks> The position must be within the last GetCapacity() samples. </remarks>
+	const float* GetSamples(size_t channel, int64_t position) const {
+		return m_samples.data() + channel * 2 * m_capacity + Wrap(position);
+	}
+
+	/// <summary> Readers tell the writer how many samples they look back, so it can size the ring accordingly. </summary>
+	void DeclareHistory(size_t history) const;
+	/// <summary> The longest history declared by any reader. </summary>
+	size_t GetDeclaredHistory() const { return m_declaredHistory.load(std::memory_order_relaxed); }
+private:
+	size_t Wrap(int64_t position) const {
+		int64_t index = position % (int64_t)m_capacity;
+		return size_t(index < 0 ? index + (int64_t)m_capacity : index);
+	}
+	void Store(size_t channel, int64_t position, float sample) {
+		float* storage = m_samples.data() + channel * 2 * m_capacity;
+		size_t index = Wrap(position);
+		storage[index] = sample;
+		storage[index + m_capacity] = sample;
+	}
+	void Store(size_t channel, int64_t position, const float* samples, size_t count);
+	/// <summary> Pointer to the sample at position, followed by room for GetCapacity() samples. </summary>
+	float* GetStorage(size_t channel, int64_t position) {
+		return m_samples.data() + channel * 2 * m_capacity + Wrap(position);
+	}
+	/// <summary> Copy samples written through GetStorage() into the other half of the ring. </summary>
+	void Mirror(size_t channel, int64_t position, size_t count);
+private:
+	size_t m_numChannels;
+	size_t m_capacity;
+	std::vector<float> m_samples;
+	std::atomic<int64_t> m_writePosition;
+	int64_t m_firstValidPosition;
+	mutable std::atomic<size_t> m_declaredHistory;
+};
+
+
+/// <summary>
+/// <para> Where a sample of a stream came from: its index in the source that captured it, and when it was captured. </para>
+/// <para>
+/// Nodes that delay or decimate their input derive the timestamps of their output from those of the input,
+/// so that a sample anywhere downstream traces back to the source sample it is centred on. Comparing
+/// the capture time with the clock gives the latency of a sample, including the delay of the filters.
+/// </para>
+/// </summary>
+struct StreamTimestamp {
+	using Clock = std::chrono::steady_clock;
+
+	/// <summary> Index of the sample in its source, negative for samples centred before the first one. </summary>
+	int64_t sourcePosition = 0;
+	/// <summary> Number of source samples from one sample of the stream to the next. </summary>
+	int64_t sourceStep = 1;
+	/// <summary> Sample rate of the source, 0 if not known. </summary>
+	int sourceRate = 0;
+	/// <summary> When sample 0 of the source was captured, as estimated from recent samples. Zero if not known. </summary>
+	Clock::time_point sourceOrigin;
+
+	/// <summary> The timestamp of a source sample captured at a known time. </summary>
+	static StreamTimestamp Captured(int64_t sourcePosition, int sourceRate, Clock::time_point captureTime);
+
+	bool HasCaptureTime() const { return sourceRate > 0 && sourceOrigin != Clock::time_point(); }
+	/// <summary> When the sample was captured. Valid if HasCaptureTime(). </summary>
+	Clock::time_point GetCaptureTime() const;
+	/// <summary> Seconds from the first source sample, 0 if the sample rate is not known. </summary>
+	double GetSourceTime() const { return sourceRate > 0 ? double(sourcePosition) / sourceRate : 0.0; }
+
+	/// <summary> The timestamp of the sample count samples later in the same stream, earlier if negative. </summary>
+	StreamTimestamp Advanced(int64_t count) const {
+		StreamTimestamp timestamp = *this;
+		timestamp.sourcePosition += count * sourceStep;
+		return timestamp;
+	}
+	/// <summary> The timestamp of a stream that keeps this sample and every factor-th one after it. </summary>
+	StreamTimestamp Decimated(int64_t factor) const {
+		StreamTimestamp timestamp = *this;
+		timestamp.sourceStep *= factor;
+		return timestamp;
+	}
+};
+
+
+/// <summary>
+/// <para> Port payload that announces new samples in a <see cref="SampleStream"/>. </para>
+/// <para> The samples themselves stay in the ring: copying a chunk to many inputs only copies a pointer. </para>
+/// </summary>
+struct StreamChunk {
+	/// <summary> The stream the samples are in, null for an empty chunk. </summary>
+	std::shared_ptr<const SampleStream> stream;
+	/// <summary> Position of the first new sample. </summary>
+	int64_t begin = 0;
+	/// <summary> Position one past the last new sample. </summary>
+	int64_t end = 0;
+	/// <summary> Timestamp of the first new sample. </summary>
+	StreamTimestamp timestamp;
+
+	/// <summary> Timestamp of the sample at a position of the stream. </summary>
+	StreamTimestamp GetTimestamp(int64_t position) const { return timestamp.Advanced(position - begin); }
+	size_t GetNumSamples() const { return size_t(end - begin); }
+	size_t GetNumChannels() const { return stream ? stream->GetNumChannels() : 0; }
+	bool IsEmpty() const { return !stream || end <= begin; }
+};
+
+
+/// <summary>
+/// <para> Appends blocks of samples to a <see cref="SampleStream"/>, and makes the chunks to put on an output port. </para>
+/// <para>
+/// Every block is stamped with the <see cref="StreamTimestamp"/> of its first sample. Sources and nodes that delay
+/// or decimate set it with SetTimestamp() before the block ends, otherwise it continues from the previous block.
+/// </para>
+/// <para>
+/// The ring grows when the readers declare a longer history than it can hold together with the block being
+/// written. A grown ring is a new stream that carries over the samples of the old one, positions continue
+/// across it. Chunks still in flight keep the old stream alive. Reserve() extra capacity when chunks are
+/// read by later stages of a pipeline, while the writer is already writing the next blocks.
+/// </para>
+/// <code>
+/// writer.BeginBlock(count);
+/// writer.Write(0, leftSamples);
+/// writer.Write(1, rightSamples);
+/// GetOutput&lt;0&gt;().Set(writer.EndBlock());
+/// </code>
+/// </summary>
+class StreamWriter {
+public:
+	explicit StreamWriter(size_t numChannels = 1, size_t minCapacity = 0);
+
+	/// <summary> Change the number of channels. The history is not carried over, readers see it as dropped samples. </summary>
+	void SetNumChannels(size_t numChannels);
+	size_t GetNumChannels() const { return m_numChannels; }
+	/// <summary> Keep at least capacity samples in the ring, in addition to what the readers declare. </summary>
+	void Reserve(size_t capacity);
+	/// <summary> Current capacity of the ring, 0 until the first block. </summary>
+	size_t GetCapacity() const { return m_stream ? m_stream->GetCapacity() : 0; }
+	/// <summary> Position of the next sample written. </summary>
+	int64_t GetPosition() const { return m_position; }
+
+	/// <summary> Timestamp of the first sample of the current block, or of the next one if no block is in progress. </summary>
+	void SetTimestamp(const StreamTimestamp& timestamp) { m_timestamp = timestamp; }
+	const StreamTimestamp& GetTimestamp() const { return m_timestamp; }
+
+	/// <summary> Start a block of count samples on every channel. </summary>
+	void BeginBlock(size_t count);
+	/// <summary> Write the whole block of a channel. </summary>
+	void Write(size_t channel, const float* samples);
+	/// <summary> Write a single sample of the block. </summary>
+	void Write(size_t channel, size_t index, float sample) {
+		m_stream->Store(channel, m_position + (int64_t)index, sample);
+	}
+	/// <summary> Write count samples of the block, starting at index. </summary>
+	void Write(size_t channel, size_t index, const float* samples, size_t count) {
+		m_stream->Store(channel, m_position + (int64_t)index, samples, count);
+	}
+	/// <summary> The block of a channel, to fill in place instead of writing it. Valid until EndBlock(). </summary>
+	float* GetBlock(size_t channel) {
+		m_isFilledInPlace = true;
+		return m_stream->GetStorage(channel, m_position);
+	}
+	/// <summary> Publish the block to the readers. </summary>
+	/// <returns> The chunk to pass to the output port. </returns>
+	StreamChunk EndBlock();
+
+	/// <summary> Write a block of a single-channel stream. </summary>
+	StreamChunk Write(const float* samples, size_t count);
+private:
+	void Replace(size_t numChannels, size_t capacity, bool carryOver);
+private:
+	std::shared_ptr<SampleStream> m_stream;
+	size_t m_numChannels;
+	size_t m_minCapacity;
+	size_t m_blockSize = 0;
+	int64_t m_position = 0;
+	StreamTimestamp m_timestamp;
+	bool m_isFilledInPlace = false;
+};
+
+
+/// <summary>
+/// A block of new samples read from a stream, preceded by the history the reader asked for.
+/// Channel pointers are valid until the next read.
+/// </summary>
+class StreamWindow {
+public:
+	StreamWindow() = default;
+	StreamWindow(const float* const* channels, size_t numChannels, size_t historySize, size_t numSamples, int64_t position, const StreamTimestamp& timestamp = {})
+		: m_channels(channels), m_numChannels(numChannels), m_historySize(historySize), m_numSamples(numSamples), m_position(position), m_timestamp(timestamp) {}
+
+	size_t GetNumChannels() const { return m_channels ? m_numChannels : 0; }
+	size_t GetHistorySize() const { return m_historySize; }
+	size_t GetNumSamples() const { return m_numSamples; }
+	/// <summary> Stream position of the first new sample. </summary>
+	int64_t GetPosition() const { return m_position; }
+	/// <summary> Timestamp of the first new sample, the history samples are before it. </summary>
+	const StreamTimestamp& GetTimestamp() const { return m_timestamp; }
+	bool IsEmpty() const { return m_numSamples == 0; }
+
+	/// <summary> The oldest history sample of a channel, followed by the rest of the history and the new samples. </summary>
+	const float* GetChannel(size_t channel) const { return m_channels[channel]; }
+	/// <summary> The first new sample of a channel. </summary>
+	const float* GetSamples(size_t channel) const { return m_channels[channel] + m_historySize; }
+	/// <summary> The GetChannel() pointers of all channels. </summary>
+	const float* const* GetChannels() const { return m_channels; }
+private:
+	const float* const* m_channels = nullptr;
+	size_t m_numChannels = 0;
+	size_t m_historySize = 0;
+	size_t m_numSamples = 0;
+	int64_t m_position = 0;
+	StreamTimestamp m_timestamp;
+};
+
+
+/// <summary>
+/// <para> Read cursor of one input into the stream of the output it is linked to. </para>
+/// <para>
+/// Each read returns the samples since the previous read, together with the declared number of history
+/// samples right before them, pointing directly into the ring. The reader keeps the stream alive until
+/// the next read. Reads catch up on chunks the input missed, as long as the ring still holds them.
+/// </para>
+/// <para>
+/// Overflow: samples after the cursor were lost before they could be read, because the ring was
+/// overwritten or replaced. The reader skips to the oldest sample still there.
+/// Underrun: a read found no new samples, or part of the history was not available and reads as zeros.
+/// </para>
+/// </summary>
+class StreamReader {
+public:
+	explicit StreamReader(size_t history = 0);
+
+	/// <summary> Number of samples before the new ones every read should include. </summary>
+	void SetHistory(size_t history);
+	size_t GetHistory() const { return m_history; }
+
+	/// <summary> Read the samples from the cursor up to the end of the chunk. </summary>
+	StreamWindow Read(const StreamChunk& chunk);
+	/// <summary> Forget the cursor, the next read starts at the beginning of its chunk. </summary>
+	void Reset();
+
+	/// <summary> Number of reads that lost samples after the cursor. </summary>
+	uint64_t GetNumOverflows() const { return m_numOverflows; }
+	/// <summary> Number of samples lost by overflows. </summary>
+	uint64_t GetNumDroppedSamples() const { return m_numDroppedSamples; }
+	/// <summary> Number of reads that had no new samples, or an incomplete history. </summary>
+	uint64_t GetNumUnderruns() const { return m_numUnderruns; }
+private:
+	StreamWindow Fail();
+private:
+	size_t m_history;
+	int64_t m_cursor = 0;
+	bool m_isStarted = false;
+	std::shared_ptr<const SampleStream> m_stream;
+	std::vector<const float*> m_channels;
+	std::vector<float> m_copy;
+	uint64_t m_numOverflows = 0;
+	uint64_t m_numDroppedSamples = 0;
+	uint64_t m_numUnderruns = 0;
+};
+
+
+} // namespace exc
@@ -0,0 +1,693 @@
+#include "SdfExecutor.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+
+
+namespace exc {
+
+
+namespace {
+
+// not part of a fused stage, or no next node in the stage
+constexpr size_t NoStage = std::numeric_limits<size_t>::max();
+
+size_t Gcd(size_t a, size_t b) {
+	while (b != 0) {
+		size_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+size_t Lcm(size_t a, size_t b) {
+	return a / Gcd(a, b) * b;
+}
+
+// Sample rate of a stream relative to the entry streams.
+struct Rate {
+	size_t numerator;
+	size_t denominator;
+
+	Rate(size_t numerator, size_t denominator) {
+		size_t d = Gcd(numerator, denominator);
+		this->numerator = numerator / d;
+		this->denominator = denominator / d;
+	}
+	bool operator!=(const Rate& rhs) const {
+		return numerator != rhs.numerator || denominator != rhs.denominator;
+	}
+};
+
+std::string NodeName(const NodeBase* node) {
+	return typeid(*node).name();
+}
+
+} // namespace
+
+
+SdfExecutor::SdfExecutor(std::initializer_list<NodeBase*> nodes)
+	: GraphExecutor(nodes)
+{}
+
+
+void SdfExecutor::SetBlockSize(size_t numSamples) {
+	m_requestedBlockSize = std::max(numSamples, size_t(1));
+	Invalidate();
+}
+
+
+size_t SdfExecutor::GetBlockSize() const {
+	return m_blockSize;
+}
+
+
+size_t SdfExecutor::GetBlockSize(NodeBase* node) const {
+	for (auto& rated : m_rated) {
+		if (m_schedule[rated.index].node == node) {
+			return rated.blockSize;
+		}
+	}
+	throw std::invalid_argument("Node is not a scheduled multi-rate node.");
+}
+
+
+uint64_t SdfExecutor::GetNumIterations() const {
+	return m_numIterations;
+}
+
+
+void SdfExecutor::SetFusionEnabled(bool enabled) {
+	m_isFusionEnabled = enabled;
+	Invalidate();
+}
+
+
+bool SdfExecutor::IsFusionEnabled() const {
+	return m_isFusionEnabled;
+}
+
+
+void SdfExecutor::SetTileSize(size_t numSamples) {
+	m_tileSize = numSamples;
+}
+
+
+std::vector<size_t> SdfExecutor::GetFusedStages() const {
+	std::vector<size_t> sizes;
+	for (auto& stage : m_stages) {
+		sizes.push_back(stage.nodes.size());
+	}
+	return sizes;
+}
+
+
+void SdfExecutor::SetNumThreads(size_t numThreads) {
+	m_pool.reset(numThreads == 1 ? nullptr : new ThreadPool(numThreads));
+}
+
+
+size_t SdfExecutor::GetNumThreads() const {
+	return m_pool ? m_pool->GetNumThreads() : 1;
+}
+
+
+void SdfExecutor::PinToCallingThread(NodeBase* node, bool pinned) {
+	auto it = std::find(m_pinnedNodes.begin(), m_pinnedNodes.end(), node);
+	if (pinned && it == m_pinnedNodes.end()) {
+		m_pinnedNodes.push_back(node);
+	}
+	else if (!pinned && it != m_pinnedNodes.end()) {
+		m_pinnedNodes.erase(it);
+	}
+	Invalidate();
+}
+
+
+void SdfExecutor::Run() {
+	if (!m_isCompiled) {
+		Compile();
+	}
+
+	RunPart(m_before, m_parallelBefore);
+
+	// one firing of each node per iteration, in schedule order, so at most a block is in flight on a link
+	bool hasFired;
+	do {
+		hasFired = false;
+		for (auto& rated : m_rated) {
+			if (rated.stage != NoStage && !rated.isStageInput) {
+				continue;
+			}
+			if (Fire(rated)) {
+				if (rated.stage != NoStage) {
+					for (auto& fused : m_stages[rated.stage].nodes) {
+						Collect(m_rated[fused.rated]);
+					}
+				}
+				else {
+					Collect(rated);
+				}
+				hasFired = true;
+			}
+		}
+		m_numIterations += hasFired ? 1 : 0;
+	} while (hasFired);
+
+	for (auto& rated : m_rated) {
+		for (auto& drain : rated.drains) {
+			if (!drain.pending.IsEmpty()) {
+				drain.delivered = drain.pending.end;
+				drain.port->Set(std::move(drain.pending));
+				drain.pending = StreamChunk();
+			}
+		}
+	}
+
+	RunPart(m_after, m_parallelAfter);
+}
+
+
+void SdfExecutor::RunPart(const std::vector<size_t>& indices, ParallelSchedule& parallel) {
+	if (m_pool) {
+		parallel.Run(*m_pool, [this](size_t index) { UpdateNode(index); });
+		return;
+	}
+	for (auto index : indices) {
+		UpdateNode(index);
+	}
+}
+
+
+void SdfExecutor::UpdateNode(size_t index) {
+	if (ShouldUpdate(index)) {
+		GRAPH_PROFILE_UPDATE(m_schedule[index].node);
+		m_schedule[index].node->Update();
+	}
+}
+
+
+void SdfExecutor::OnCompiled() {
+	try {
+		Analyze();
+	}
+	catch (...) {
+		Invalidate();
+		throw;
+	}
+
+	std::vector<bool> isPinned(m_schedule.size());
+	for (size_t i = 0; i < m_schedule.size(); ++i) {
+		isPinned[i] = std::find(m_pinnedNodes.begin(), m_pinnedNodes.end(), m_schedule[i].node) != m_pinnedNodes.end();
+	}
+	m_parallelBefore.Compile(m_schedule, m_before, isPinned);
+	m_parallelAfter.Compile(m_schedule, m_after, isPinned);
+}
+
+
+void SdfExecutor::OnInvalidated() {
+	for (auto& rated : m_rated) {
+		for (auto& input : rated.inputs) {
+			// inside a stage, the input is not read block by block, its position is meaningless
+			if (rated.stage == NoStage || rated.isStageInput) {
+				m_resumeInputs[input.port] = input;
+			}
+			else {
+				m_resumeInputs.erase(input.port);
+			}
+		}
+	}
+	for (auto& stage : m_stages) {
+		for (size_t i = 1; i < stage.nodes.size(); ++i) {
+			NodeBase* node = m_schedule[m_rated[stage.nodes[i].rated].index].node;
+			InputPortBase* port = node->GetInput(stage.nodes[i].node->GetKernelInput());
+			FusedNode& previous = stage.nodes[i - 1];
+			m_resumeTiles[port] = { port->GetLink(), std::move(previous.outputs[previous.next]) };
+		}
+	}
+	m_before.clear();
+	m_rated.clear();
+	m_stages.clear();
+	m_after.clear();
+	m_parallelBefore.Clear();
+	m_parallelAfter.Clear();
+	m_blockSize = 0;
+	m_numIterations = 0;
+}
+
+
+void SdfExecutor::Analyze() {
+	const size_t numNodes = m_schedule.size();
+
+	// split the schedule into what comes before, in, and after the multi-rate part
+	std::vector<MultiRateNode*> multiRate(numNodes);
+	std::vector<bool> isDownstream(numNodes, false);
+	for (size_t i = 0; i < numNodes; ++i) {
+		multiRate[i] = dynamic_cast<MultiRateNode*>(m_schedule[i].node);
+		if (multiRate[i] || isDownstream[i]) {
+			for (auto s : m_schedule[i].successors) {
+				isDownstream[s] = true;
+			}
+		}
+	}
+	for (size_t i = 0; i < numNodes; ++i) {
+		if (multiRate[i]) {
+			continue;
+		}
+		if (!isDownstream[i]) {
+			m_before.push_back(i);
+			continue;
+		}
+		for (auto s : m_schedule[i].successors) {
+			if (multiRate[s]) {
+				throw std::logic_error("Multi-rate node " + NodeName(m_schedule[s].node) + " receives data from "
+					+ NodeName(m_schedule[i].node) + ", which is downstream of other multi-rate nodes.");
+			}
+		}
+		m_after.push_back(i);
+	}
+
+	// propagate rates along the stream links, the streams coming from other nodes have rate 1
+	std::unordered_map<const OutputPortBase*, Rate> outputRates;
+	std::unordered_map<const OutputPortBase*, size_t> outputOwners;
+	std::vector<Rate> inputRates;
+	size_t granularity = 1;
+	for (size_t i = 0; i < numNodes; ++i) {
+		if (!multiRate[i]) {
+			continue;
+		}
+		NodeBase* node = m_schedule[i].node;
+		RatedNode rated;
+		rated.index = i;
+		rated.node = multiRate[i];
+		rated.blockSize = 0;
+		rated.stage = NoStage;
+		rated.isStageInput = false;
+
+		Rate rate(1, 1);
+		for (size_t p = 0; p < node->GetNumInputs(); ++p) {
+			InputPortBase* port = node->GetInput(p);
+			if (port->GetType() != typeid(StreamChunk) || port->GetLink() == nullptr) {
+				continue;
+			}
+			auto it = outputRates.find(port->GetLink());
+			Rate linkRate = it != outputRates.end() ? it->second : Rate(1, 1);
+			if (!rated.inputs.empty() && linkRate != rate) {
+				throw std::logic_error("Streams of different rates meet at " + NodeName(node) + ".");
+			}
+			rate = linkRate;
+			rated.inputs.push_back({ static_cast<InputPort<StreamChunk>*>(port), port->GetLink(), nullptr, 0, 0, false, StreamTimestamp{} });
+
+			// continue where the previous schedule stopped if the input still reads the same output
+			auto resume = m_resumeInputs.find(port);
+			if (resume != m_resumeInputs.end() && resume->second.link == port->GetLink()) {
+				rated.inputs.back() = resume->second;
+			}
+		}
+		if (rated.inputs.empty()) {
+			throw std::logic_error("Multi-rate node " + NodeName(node) + " has no linked stream input.");
+		}
+
+		RateRatio ratio = rated.node->GetRateRatio();
+		if (ratio.numerator == 0 || ratio.denominator == 0) {
+			throw std::logic_error("Multi-rate node " + NodeName(node) + " has a zero rate ratio.");
+		}
+		Rate outputRate(rate.numerator * ratio.numerator, rate.denominator * ratio.denominator);
+		for (size_t p = 0; p < node->GetNumOutputs(); ++p) {
+			outputRates.insert({ node->GetOutput(p), outputRate });
+			outputOwners.insert({ node->GetOutput(p), m_rated.size() });
+		}
+
+		// input blocks must be whole, and a multiple of the ratio's denominator
+		size_t period = rate.denominator * ratio.denominator;
+		granularity = Lcm(granularity, period / Gcd(period, rate.numerator));
+
+		inputRates.push_back(rate);
+		m_rated.push_back(std::move(rated));
+	}
+
+	for (auto i : m_after) {
+		NodeBase* node = m_schedule[i].node;
+		for (size_t p = 0; p < node->GetNumInputs(); ++p) {
+			InputPortBase* port = node->GetInput(p);
+			auto it = outputOwners.find(port->GetLink());
+			if (port->GetType() == typeid(StreamChunk) && it != outputOwners.end()) {
+				m_rated[it->second].drains.push_back({ static_cast<InputPort<StreamChunk>*>(port), StreamChunk(), std::numeric_limits<int64_t>::min() });
+			}
+		}
+	}
+
+	m_blockSize = (m_requestedBlockSize + granularity - 1) / granularity * granularity;
+	for (size_t r = 0; r < m_rated.size(); ++r) {
+		m_rated[r].blockSize = m_blockSize / inputRates[r].denominator * inputRates[r].numerator;
+		m_rated[r].node->SetBlockSize(m_rated[r].blockSize);
+	}
+
+	if (m_isFusionEnabled) {
+		Fuse(outputOwners);
+	}
+	m_resumeTiles.clear();
+}
+
+
+void SdfExecutor::Fuse(const std::unordered_map<const OutputPortBase*, size_t>& outputOwners) {
+	std::unordered_map<const InputPortBase*, size_t> kernelInputs;
+	for (size_t r = 0; r < m_rated.size(); ++r) {
+		if (auto fusable = dynamic_cast<FusableNode*>(m_rated[r].node)) {
+			kernelInputs.insert({ m_schedule[m_rated[r].index].node->GetInput(fusable->GetKernelInput()), r });
+		}
+	}
+
+	// a node joins the stage of the node whose kernel output it reads, if that is all it reads from the multi-rate part
+	auto isFusable = [&](size_t r, size_t stage) {
+		if (m_rated[r].stage != NoStage || m_rated[r].inputs.size() != 1) {
+			return false;
+		}
+		NodeBase* node = m_schedule[m_rated[r].index].node;
+		for (size_t p = 0; p < node->GetNumInputs(); ++p) {
+			auto it = outputOwners.find(node->GetInput(p)->GetLink());
+			if (it != outputOwners.end() && m_rated[it->second].stage != stage) {
+				return false;
+			}
+		}
+		return true;
+	};
+
+	for (size_t r = 0; r < m_rated.size(); ++r) {
+		auto fusable = dynamic_cast<FusableNode*>(m_rated[r].node);
+		if (!fusable || m_rated[r].stage != NoStage) {
+			continue;
+		}
+		const size_t stageIndex = m_stages.size();
+		FusedStage stage;
+		stage.granularity = 1;
+		Rate inputRate(1, 1);
+		size_t current = r;
+		while (current != NoStage) {
+			m_rated[current].stage = stageIndex;
+			FusedNode fused;
+			fused.rated = current;
+			fused.node = dynamic_cast<FusableNode*>(m_rated[current].node);
+			fused.outputs.resize(fused.node->GetNumKernelOutputs());
+			fused.next = NoStage;
+
+			RateRatio ratio = fused.node->GetRateRatio();
+			Rate outputRate(inputRate.numerator * ratio.numerator, inputRate.denominator * ratio.denominator);
+			fused.inputNumerator = inputRate.numerator;
+			fused.inputDenominator = inputRate.denominator;
+			fused.outputNumerator = outputRate.numerator;
+			fused.outputDenominator = outputRate.denominator;
+			fused.blockOutputs = m_rated[current].blockSize / ratio.denominator * ratio.numerator;
+			stage.granularity = Lcm(stage.granularity, Lcm(inputRate.denominator, outputRate.denominator));
+			inputRate = outputRate;
+
+			// continue with the first node that reads a kernel output
+			NodeBase* node = m_schedule[m_rated[current].index].node;
+			size_t next = NoStage;
+			for (size_t j = 0; j < fused.outputs.size() && next == NoStage; ++j) {
+				OutputPortBase* port = node->GetOutput(fused.node->GetKernelOutput(j).port);
+				for (auto destination : *port) {
+					auto it = kernelInputs.find(destination);
+					if (it != kernelInputs.end() && isFusable(it->second, stageIndex)) {
+						next = it->second;
+						fused.next = j;
+						break;
+					}
+				}
+			}
+			if (next != NoStage) {
+				// the tile history survives recompiling as long as the link stays
+				InputPortBase* destination = m_schedule[m_rated[next].index].node->GetInput(dynamic_cast<FusableNode*>(m_rated[next].node)->GetKernelInput());
+				auto resume = m_resumeTiles.find(destination);
+				if (resume != m_resumeTiles.end() && resume->second.first == destination->GetLink()) {
+					fused.outputs[fused.next] = std::move(resume->second.second);
+				}
+			}
+			stage.nodes.push_back(std::move(fused));
+			current = next;
+		}
+
+		if (stage.nodes.size() < 2) {
+			m_rated[r].stage = NoStage;
+			continue;
+		}
+		m_rated[r].isStageInput = true;
+		for (size_t i = 1; i < stage.nodes.size(); ++i) {
+			for (auto& input : m_rated[stage.nodes[i].rated].inputs) {
+				m_resumeInputs.erase(input.port);
+			}
+		}
+		m_stages.push_back(std::move(stage));
+	}
+}
+
+
+bool SdfExecutor::Fire(RatedNode& rated) {
+	const int64_t blockSize = (int64_t)rated.blockSize;
+
+	for (auto& input : rated.inputs) {
+		// the port holds either the last block given to the node, or a newer chunk from upstream
+		const StreamChunk& chunk = input.port->Get();
+		if (!chunk.IsEmpty() && (!input.isStarted || chunk.end > input.available)) {
+			if (!input.isStarted) {
+				input.consumed = chunk.begin;
+				input.isStarted = true;
+			}
+			input.stream = chunk.stream;
+			input.available = chunk.end;
+			input.timestamp = chunk.GetTimestamp(chunk.end);
+			// samples short of a block stay in the ring until the next chunk completes it
+			input.stream->DeclareHistory(rated.blockSize);
+		}
+		if (!input.isStarted) {
+			return false;
+		}
+
+		// whole blocks are skipped if the writer overwrote them, so the phase stays aligned
+		int64_t oldest = std::max(input.stream->GetWritePosition() - (int64_t)input.stream->GetCapacity(), input.stream->GetFirstValidPosition());
+		if (input.consumed < oldest) {
+			input.consumed += (oldest - input.consumed + blockSize - 1) / blockSize * blockSize;
+		}
+		if (input.available - input.consumed < blockSize) {
+			return false;
+		}
+	}
+
+	for (auto& input : rated.inputs) {
+		StreamChunk block;
+		block.stream = input.stream;
+		block.begin = input.consumed;
+		block.end = input.consumed + blockSize;
+		block.timestamp = input.timestamp.Advanced(block.begin - input.available);
+		input.consumed = block.end;
+		input.port->Set(std::move(block));
+	}
+
+	NodeBase* node = m_schedule[rated.index].node;
+	// a fused stage is profiled as an update of its first node
+	GRAPH_PROFILE_UPDATE(node);
+	if (rated.stage != NoStage) {
+		RunStage(m_stages[rated.stage]);
+	}
+	else {
+		node->Update();
+	}
+	return true;
+}
+
+
+void SdfExecutor::Collect(RatedNode& rated) {
+	for (auto& drain : rated.drains) {
+		const StreamChunk& chunk = drain.port->Get();
+		int64_t seen = drain.pending.IsEmpty() ? drain.delivered : drain.pending.end;
+		if (chunk.IsEmpty() || chunk.end <= seen) {
+			continue;
+		}
+		if (drain.pending.IsEmpty()) {
+			drain.pending = chunk;
+		}
+		else {
+			drain.pending.stream = chunk.stream;
+			drain.pending.end = chunk.end;
+		}
+		// the writer must keep all blocks of this run until the drain reads them
+		drain.pending.stream->DeclareHistory(drain.pending.GetNumSamples());
+	}
+}
+
+
+void SdfExecutor::RunStage(FusedStage& stage) {
+	FusedNode& first = stage.nodes.front();
+	NodeBase* firstNode = m_schedule[m_rated[first.rated].index].node;
+	auto inputPort = static_cast<InputPort<StreamChunk>*>(firstNode->GetInput(first.node->GetKernelInput()));
+
+	size_t numChannels = inputPort->Get().GetNumChannels();
+	for (auto& fused : stage.nodes) {
+		fused.node->BeginKernel(numChannels);
+		numChannels = fused.next != NoStage ? fused.node->GetKernelOutput(fused.next).numChannels : 0;
+	}
+	StreamWindow window = first.node->ReadKernelInput();
+	if (window.IsEmpty()) {
+		return;
+	}
+	const size_t numSamples = window.GetNumSamples();
+	const size_t tileSize = GetTileSize(stage, numSamples);
+
+	// each kernel stamps its outputs from the first sample it gets, before running changes its state
+	StreamTimestamp timestamp = window.GetTimestamp();
+	for (size_t i = 0; i < stage.nodes.size(); ++i) {
+		FusedNode& fused = stage.nodes[i];
+		NodeBase* node = m_schedule[m_rated[fused.rated].index].node;
+		timestamp = fused.node->GetKernelTimestamp(timestamp);
+		InputPortBase* nextInput = nullptr;
+		if (fused.next != NoStage) {
+			FusedNode& next = stage.nodes[i + 1];
+			nextInput = m_schedule[m_rated[next.rated].index].node->GetInput(next.node->GetKernelInput());
+		}
+
+		// decimators may carry a partial phase into a tile, leave room for one more sample
+		size_t capacity = (tileSize * fused.outputNumerator + fused.outputDenominator - 1) / fused.outputDenominator + 1;
+		fused.outputChannels.clear();
+		for (size_t j = 0; j < fused.outputs.size(); ++j) {
+			KernelOutput output = fused.node->GetKernelOutput(j);
+			TileBuffer& buffer = fused.outputs[j];
+			size_t history = j == fused.next ? stage.nodes[i + 1].node->GetKernelHistory() : 0;
+			Reshape(buffer, output.numChannels, history, capacity);
+			for (size_t channel = 0; channel < buffer.numChannels; ++channel) {
+				fused.outputChannels.push_back(buffer.samples.data() + channel * buffer.stride + buffer.history);
+			}
+
+			// the stream is only written if a node outside the stage reads it
+			OutputPortBase* port = node->GetOutput(output.port);
+			buffer.isWritten = std::any_of(port->begin(), port->end(), [&](InputPortBase* destination) { return destination != nextInput || j != fused.next; });
+			buffer.numWritten = 0;
+			if (buffer.isWritten) {
+				fused.node->GetKernelWriter(j).BeginBlock(fused.blockOutputs);
+				fused.node->GetKernelWriter(j).SetTimestamp(timestamp);
+			}
+			if (j == fused.next) {
+				FusedNode& next = stage.nodes[i + 1];
+				next.inputChannels.clear();
+				for (size_t channel = 0; channel < buffer.numChannels; ++channel) {
+					next.inputChannels.push_back(buffer.samples.data() + channel * buffer.stride);
+				}
+			}
+		}
+	}
+
+	first.inputChannels.resize(window.GetNumChannels());
+	for (size_t offset = 0; offset < numSamples; offset += tileSize) {
+		size_t count = std::min(tileSize, numSamples - offset);
+		for (size_t channel = 0; channel < first.inputChannels.size(); ++channel) {
+			first.inputChannels[channel] = window.GetChannel(channel) + offset;
+		}
+
+		for (size_t i = 0; i < stage.nodes.size(); ++i) {
+			FusedNode& fused = stage.nodes[i];
+			size_t numInputs = count;
+			count = fused.node->RunKernel(fused.inputChannels.data(), numInputs, fused.outputChannels.data());
+
+			// the tile is consumed, keep its end as the history of the next one
+			if (i > 0) {
+				TileBuffer& input = stage.nodes[i - 1].outputs[stage.nodes[i - 1].next];
+				for (size_t channel = 0; channel < input.numChannels; ++channel) {
+					float* samples = input.samples.data() + channel * input.stride;
+					memmove(samples, samples + numInputs, sizeof(float) * input.history);
+				}
+			}
+
+			for (size_t j = 0; j < fused.outputs.size(); ++j) {
+				TileBuffer& buffer = fused.outputs[j];
+				if (!buffer.isWritten) {
+					continue;
+				}
+				if (buffer.numWritten + count > fused.blockOutputs) {
+					throw std::logic_error("Fused node " + NodeName(m_schedule[m_rated[fused.rated].index].node) + " produced more samples than its rate ratio.");
+				}
+				StreamWriter& writer = fused.node->GetKernelWriter(j);
+				for (size_t channel = 0; channel < buffer.numChannels; ++channel) {
+					writer.Write(channel, buffer.numWritten, buffer.samples.data() + channel * buffer.stride + buffer.history, count);
+				}
+				buffer.numWritten += count;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < stage.nodes.size(); ++i) {
+		FusedNode& fused = stage.nodes[i];
+		NodeBase* node = m_schedule[m_rated[fused.rated].index].node;
+		for (size_t j = 0; j < fused.outputs.size(); ++j) {
+			if (!fused.outputs[j].isWritten) {
+				continue;
+			}
+			if (fused.outputs[j].numWritten != fused.blockOutputs) {
+				throw std::logic_error("Fused node " + NodeName(node) + " produced fewer samples than its rate ratio.");
+			}
+			auto port = static_cast<OutputPort<StreamChunk>*>(node->GetOutput(fused.node->GetKernelOutput(j).port));
+			port->Set(fused.node->GetKernelWriter(j).EndBlock());
+		}
+	}
+
+	// inputs that also received the stream move their read cursor past it
+	for (size_t i = 1; i < stage.nodes.size(); ++i) {
+		FusedNode& previous = stage.nodes[i - 1];
+		if (previous.outputs[previous.next].isWritten) {
+			stage.nodes[i].node->ReadKernelInput();
+		}
+	}
+}
+
+
+size_t SdfExecutor::GetTileSize(const FusedStage& stage, size_t numSamples) const {
+	size_t tileSize = m_tileSize;
+	if (tileSize == 0) {
+		// the output tiles of all nodes and the history kept for the next node fill the cache
+		constexpr size_t cacheSize = 32768 / sizeof(float);
+		size_t fixed = 0;
+		double perSample = 0.0;
+		for (size_t i = 0; i < stage.nodes.size(); ++i) {
+			const FusedNode& fused = stage.nodes[i];
+			for (size_t j = 0; j < fused.outputs.size(); ++j) {
+				size_t numChannels = fused.node->GetKernelOutput(j).numChannels;
+				size_t history = j == fused.next ? stage.nodes[i + 1].node->GetKernelHistory() : 0;
+				fixed += numChannels * (history + 1);
+				perSample += double(numChannels * fused.outputNumerator) / double(fused.outputDenominator);
+			}
+		}
+		tileSize = fixed < cacheSize && perSample > 0.0 ? size_t((cacheSize - fixed) / perSample) : 0;
+		tileSize = tileSize / stage.granularity * stage.granularity;
+	}
+	else {
+		tileSize = (tileSize + stage.granularity - 1) / stage.granularity * stage.granularity;
+	}
+	return std::min(std::max(tileSize, stage.granularity), numSamples);
+}
+
+
+void SdfExecutor::Reshape(TileBuffer& buffer, size_t numChannels, size_t history, size_t capacity) {
+	if (buffer.numChannels == numChannels && buffer.history == history && buffer.stride >= history + capacity) {
+		return;
+	}
+
+	// keep as much of the history as both shapes have, older samples read as silence
+	TileBuffer reshaped;
+	reshaped.numChannels = numChannels;
+	reshaped.history = history;
+	reshaped.stride = history + capacity;
+	reshaped.samples.assign(numChannels * reshaped.stride, 0.0f);
+	size_t kept = std::min(history, buffer.history);
+	for (size_t channel = 0; channel < std::min(numChannels, buffer.numChannels); ++channel) {
+		const float* source = buffer.samples.data() + channel * buffer.stride + buffer.history - kept;
+		std::copy(source, source + kept, reshaped.samples.data() + channel * reshaped.stride + history - kept);
+	}
+	buffer = std::move(reshaped);
+}
+
+
+} // namespace exc
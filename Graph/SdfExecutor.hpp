@@ -0,0 +1,176 @@
+#pragma once
+
+#include "GraphExecutor.hpp"
+#include "FusableNode.hpp"
+#include "MultiRateNode.hpp"
+#include "ParallelSchedule.hpp"
+#include "SampleStream.hpp"
+#include "ThreadPool.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+
+namespace exc {
+
+
+/// <summary>
+/// <para> Updates multi-rate stream processing with a static schedule and fixed block sizes. </para>
+/// <para>
+/// Nodes that implement <see cref="MultiRateNode"/> are fired block by block. The rate ratios
+/// along the stream links fix the block size of every such node relative to the block taken
+/// from the streams entering them. That entry block is the smallest multiple of SetBlockSize()
+/// that gives every node a whole block, as a multiple of its ratio's denominator.
+/// </para>
+/// <para>
+/// On each Run(), the other nodes that feed the multi-rate nodes are updated first, the same way as
+/// in <see cref="GraphExecutor"/>. Then the multi-rate nodes are fired in schedule order, once per
+/// iteration, for as many iterations as there are complete entry blocks. Samples left over wait
+/// for the next Run(). Finally the nodes that receive data from the multi-rate nodes are updated.
+/// Their stream inputs receive everything produced during the Run() as a single chunk, which spans
+/// any number of blocks.
+/// </para>
+/// <para> Evaluation modes apply to the nodes around the multi-rate nodes. The multi-rate nodes
+///		are fired whenever a block is available. </para>
+/// <para> Recompiling keeps the read positions of stream inputs that stay linked to the same output,
+///		so a schedule can be changed between ticks without skipping or repeating blocks. </para>
+/// <para>
+/// Chains of <see cref="FusableNode"/>s are fused into stages: the first node of a chain is fired as
+/// usual, and the whole chain processes the block in one pass, tile by tile. Each further node of a
+/// chain reads only the stream of the previous one, which stays in a tile-sized buffer, and is written
+/// to its stream only if other nodes read it too. The output is the same as without fusion.
+/// </para>
+/// <para>
+/// With SetNumThreads(), the nodes before and after the multi-rate part are updated on a thread pool
+/// like in <see cref="ParallelGraphExecutor"/>, so independent branches behind the multi-rate nodes,
+/// such as a spectrum and a beat detector, run concurrently. The multi-rate nodes are fired on the
+/// calling thread.
+/// </para>
+/// </summary>
+class SdfExecutor : public GraphExecutor {
+public:
+	SdfExecutor() = default;
+	SdfExecutor(std::initializer_list<NodeBase*> nodes);
+
+	/// <summary> The minimum number of samples taken from the entry streams per iteration. </summary>
+	void SetBlockSize(size_t numSamples);
+	/// <summary> The number of samples taken from the entry streams per iteration. Valid once compiled. </summary>
+	size_t GetBlockSize() const;
+	/// <summary> The number of samples the node receives on its stream inputs per update. </summary>
+	/// <exception cref="std::invalid_argument"> The node is not a scheduled multi-rate node. </exception>
+	size_t GetBlockSize(NodeBase* node) const;
+	/// <summary> Number of iterations of the multi-rate nodes since the schedule was compiled. </summary>
+	uint64_t GetNumIterations() const;
+	/// <summary> Fuse chains of fusable nodes, on by default. Links inside a stage are not written to their streams,
+	///		so switching while running restarts the history the next node sees on those links. </summary>
+	void SetFusionEnabled(bool enabled);
+	bool IsFusionEnabled() const;
+	/// <summary> Samples taken from the input of a fused stage per tile, rounded up to a whole number of output
+	///		samples. 0 picks the largest tile whose buffers fit in the L1 cache. </summary>
+	void SetTileSize(size_t numSamples);
+	/// <summary> Number of nodes in each fused stage, in schedule order. Valid once compiled. </summary>
+	std::vector<size_t> GetFusedStages() const;
+	/// <summary> Update the nodes around the multi-rate part on a pool of this many threads. 1, the default,
+	///		updates everything on the calling thread, 0 means one thread per hardware thread. </summary>
+	void SetNumThreads(size_t numThreads);
+	/// <summary> Get the number of threads the nodes around the multi-rate part are updated on. </summary>
+	size_t GetNumThreads() const;
+	/// <summary> Make the node always update on the thread that calls Run(). </summary>
+	void PinToCallingThread(NodeBase* node, bool pinned = true);
+
+	/// <summary> Update the nodes feeding the multi-rate nodes, fire all complete blocks, then update the rest. </summary>
+	/// <exception cref="std::logic_error"> The stream rates are inconsistent, see Compile(). </exception>
+	void Run() override;
+protected:
+	/// <exception cref="std::logic_error"> Rates along different paths don't match, a multi-rate node has
+	///		no stream input, or a multi-rate node depends on an ordinary node that depends on a multi-rate node. </exception>
+	void OnCompiled() override;
+	void OnInvalidated() override;
+private:
+	struct StreamInput {
+		InputPort<StreamChunk>* port;
+		const OutputPortBase* link;
+		std::shared_ptr<const SampleStream> stream;
+		int64_t consumed;
+		int64_t available;
+		bool isStarted;
+		// timestamp of the sample at available, blocks are stamped relative to it
+		StreamTimestamp timestamp;
+	};
+	// Input of a node after the multi-rate part, which gets all blocks of a Run() as one chunk.
+	struct StreamDrain {
+		InputPort<StreamChunk>* port;
+		StreamChunk pending;
+		int64_t delivered;
+	};
+	struct RatedNode {
+		size_t index;
+		MultiRateNode* node;
+		size_t blockSize;
+		std::vector<StreamInput> inputs;
+		std::vector<StreamDrain> drains;
+		size_t stage;
+		bool isStageInput;
+	};
+	// Planar samples of a kernel output for one tile, preceded by the history the next kernel needs.
+	struct TileBuffer {
+		size_t numChannels = 0;
+		size_t history = 0;
+		size_t stride = 0;
+		std::vector<float> samples;
+		bool isWritten = false;
+		size_t numWritten = 0;
+	};
+	struct FusedNode {
+		size_t rated;
+		FusableNode* node;
+		std::vector<TileBuffer> outputs;
+		// the output the next node of the stage reads, none for the last node
+		size_t next;
+		// input and output samples per sample taken from the stage's input
+		size_t inputNumerator, inputDenominator;
+		size_t outputNumerator, outputDenominator;
+		size_t blockOutputs;
+		std::vector<const float*> inputChannels;
+		std::vector<float*> outputChannels;
+	};
+	struct FusedStage {
+		std::vector<FusedNode> nodes;
+		size_t granularity;
+	};
+
+	void Analyze();
+	void RunPart(const std::vector<size_t>& indices, ParallelSchedule& parallel);
+	void UpdateNode(size_t index);
+	void Fuse(const std::unordered_map<const OutputPortBase*, size_t>& outputOwners);
+	bool Fire(RatedNode& rated);
+	void Collect(RatedNode& rated);
+	void RunStage(FusedStage& stage);
+	size_t GetTileSize(const FusedStage& stage, size_t numSamples) const;
+	static void Reshape(TileBuffer& buffer, size_t numChannels, size_t history, size_t capacity);
+private:
+	size_t m_requestedBlockSize = 1;
+	size_t m_blockSize = 0;
+	std::vector<size_t> m_before;
+	std::vector<RatedNode> m_rated;
+	std::vector<size_t> m_after;
+	uint64_t m_numIterations = 0;
+	bool m_isFusionEnabled = true;
+	size_t m_tileSize = 0;
+	std::vector<FusedStage> m_stages;
+	// read positions of the previous schedule, so recompiling doesn't process blocks twice
+	std::unordered_map<const InputPortBase*, StreamInput> m_resumeInputs;
+	// history of the tiles passed between fused nodes, by the input that reads them
+	std::unordered_map<const InputPortBase*, std::pair<const OutputPortBase*, TileBuffer>> m_resumeTiles;
+
+	std::vector<NodeBase*> m_pinnedNodes;
+	ParallelSchedule m_parallelBefore;
+	ParallelSchedule m_parallelAfter;
+	// declared last so that its threads are joined before the members they use are destroyed, none when serial
+	std::unique_ptr<ThreadPool> m_pool;
+};
+
+
+} // namespace exc
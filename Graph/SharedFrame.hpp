@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+#include <utility>
+
+
+namespace exc {
+
+
+/// <summary>
+/// <para> Reference-counted, immutable payload for ports. </para>
+/// <para>
+/// Output ports copy their data into every linked input port. For large
+/// buffers, such as blocks of audio samples, wrap the buffer into a SharedFrame:
+/// copying a frame only copies a pointer, so fanning out to many inputs
+/// does not duplicate the underlying buffer.
+/// </para>
+/// <para>
+/// The payload cannot be modified once the frame is created. Use
+/// <see cref="Extract"/> to get a mutable copy, which is free if the frame
+/// is not shared with anyone else.
+/// </para>
+/// </summary>
+template <class T>
+class SharedFrame {
+public:
+	/// <summary> Creates an empty frame. </summary>
+	SharedFrame() = default;
+	/// <summary> Creates a frame by taking over the object. </summary>
+	explicit SharedFrame(T&& obj) : m_data(std::make_shared<T>(std::move(obj))) {}
+	/// <summary> Creates a frame holding a copy of the object. </summary>
+	explicit SharedFrame(const T& obj) : m_data(std::make_shared<T>(obj)) {}
+
+	/// <summary> Constructs the payload of a new frame in place. </summary>
+	template <class... Args>
+	static SharedFrame Make(Args&&... args) {
+		SharedFrame frame;
+		frame.m_data = std::make_shared<T>(std::forward<Args>(args)...);
+		return frame;
+	}
+
+	/// <summary> Get the payload. Empty frames return a default constructed object. </summary>
+	const T& Get() const {
+		return m_data ? *m_data : Empty();
+	}
+	const T& operator*() const { return Get(); }
+	const T* operator->() const { return &Get(); }
+
+	/// <summary>
+	/// Moves the payload out if this is the only reference to it, copies it otherwise.
+	/// The frame is empty afterwards.
+	/// </summary>
+	T Extract() {
+		if (!m_data) {
+			return T();
+		}
+		std::shared_ptr<T> data = std::move(m_data);
+		if (data.use_count() == 1) {
+			return std::move(*data);
+		}
+		return *data;
+	}
+
+	/// <summary> True if the frame holds a payload. </summary>
+	explicit operator bool() const { return (bool)m_data; }
+	/// <summary> True if no other frame references the same payload. </summary>
+	bool IsUnique() const { return m_data.use_count() == 1; }
+private:
+	static const T& Empty() {
+		static const T empty{};
+		return empty;
+	}
+
+	// Non-const internally so that a sole owner can move the payload out.
+	std::shared_ptr<T> m_data;
+};
+
+
+} // namespace exc
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+namespace exc {
+
+
+/// <summary>
+/// <para> Bounded, lock-free queue for exactly one producer and one consumer thread. </para>
+/// <para>
+/// Storage is allocated once on construction. Push and pop never block and never
+/// allocate by themselves, they fail instead when the queue is full or empty.
+/// </para>
+/// </summary>
+template <class T>
+class SpscQueue {
+public:
+	explicit SpscQueue(size_t capacity)
+		: m_slots(capacity + 1), m_head(0), m_tail(0) {}
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	/// <summary> Add an element to the back. Producer only. </summary>
+	/// <returns> False if the queue is full, the element is not moved from in that case. </returns>
+	bool TryPush(T&& element) {
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+		size_t next = Next(tail);
+		if (next == m_head.load(std::memory_order_acquire)) {
+			return false;
+		}
+		m_slots[tail] = std::move(element);
+		m_tail.store(next, std::memory_order_release);
+		return true;
+	}
+
+	/// <summary> Remove the front element. Consumer only. </summary>
+	/// <returns> False if the queue is empty. </returns>
+	bool TryPop(T& element) {
+		size_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		element = std::move(m_slots[head]);
+		m_head.store(Next(head), std::memory_order_release);
+		return true;
+	}
+
+	/// <summary> Like TryPush(), but the element gets the object that was in the slot.
+	///		Containers sized once by Fill() keep passing their storage around instead of reallocating it. </summary>
+	bool TryPushSwap(T& element) {
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+		size_t next = Next(tail);
+		if (next == m_head.load(std::memory_order_acquire)) {
+			return false;
+		}
+		std::swap(m_slots[tail], element);
+		m_tail.store(next, std::memory_order_release);
+		return true;
+	}
+
+	/// <summary> Like TryPop(), but the slot keeps the element's previous object for the producer to reuse. </summary>
+	bool TryPopSwap(T& element) {
+		size_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		std::swap(m_slots[head], element);
+		m_head.store(Next(head), std::memory_order_release);
+		return true;
+	}
+
+	/// <summary> Set every slot to a copy of the value. Not thread safe, call it before the queue is used. </summary>
+	void Fill(const T& value) {
+		for (auto& slot : m_slots) {
+			slot = value;
+		}
+	}
+
+	/// <summary> Get the number of elements in the queue.
+	/// Exact when called from the producer or the consumer, a snapshot otherwise. </summary>
+	size_t Size() const {
+		size_t head = m_head.load(std::memory_order_acquire);
+		size_t tail = m_tail.load(std::memory_order_acquire);
+		return tail >= head ? tail - head : tail + m_slots.size() - head;
+	}
+
+	/// <summary> Get the maximum number of elements the queue can hold. </summary>
+	size_t Capacity() const {
+		return m_slots.size() - 1;
+	}
+private:
+	size_t Next(size_t index) const {
+		return index + 1 == m_slots.size() ? 0 : index + 1;
+	}
+private:
+	std::vector<T> m_slots;
+	// keep the indices on separate cache lines so producer and consumer don't contend
+	alignas(64) std::atomic<size_t> m_head;
+	alignas(64) std::atomic<size_t> m_tail;
+};
+
+
+} // namespace exc
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "Deinterleave.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace exc {
+
+
+/// <summary>
+/// <para> Bounded, lock-free ring of planar float samples for exactly one producer and one consumer thread. </para>
+/// <para>
+/// Storage is allocated by Reset(), writing and reading never block and never allocate. The producer
+/// is wait-free: frames that don't fit are dropped and counted as an overrun instead of waiting for the
+/// consumer. Like <see cref="SampleStream"/>, each channel is stored twice in a row, so the consumer
+/// reads everything available as one contiguous array per channel, in place.
+/// </para>
+/// </summary>
+class SpscSampleRing {
+public:
+	SpscSampleRing() : m_numChannels(0), m_capacity(0), m_writePosition(0), m_numOverruns(0), m_numDroppedFrames(0), m_readPosition(0) {}
+	SpscSampleRing(const SpscSampleRing&) = delete;
+	SpscSampleRing& operator=(const SpscSampleRing&) = delete;
+
+	/// <summary> Allocate storage for capacity frames and discard the contents and counters.
+	///		Neither the producer nor the consumer may use the ring meanwhile. </summary>
+	void Reset(size_t numChannels, size_t capacity) {
+		m_numChannels = numChannels;
+		m_capacity = capacity;
+		m_samples.assign(numChannels * 2 * capacity, 0.0f);
+		m_channels.assign(numChannels, nullptr);
+		m_writePosition.store(0, std::memory_order_relaxed);
+		m_readPosition.store(0, std::memory_order_relaxed);
+		m_numOverruns.store(0, std::memory_order_relaxed);
+		m_numDroppedFrames.store(0, std::memory_order_relaxed);
+	}
+
+	size_t GetNumChannels() const { return m_numChannels; }
+	size_t GetCapacity() const { return m_capacity; }
+
+	/// <summary> Append interleaved frames, one sample per channel each. Producer only. </summary>
+	/// <returns> The number of frames written. The rest did not fit, they are dropped and counted as an overrun. </returns>
+	size_t WriteInterleaved(const float* frames, size_t numFrames) {
+		return WriteInterleaved(frames, SampleFormat::Float32, numFrames);
+	}
+
+	/// <summary> Append interleaved frames in any sample format, they are converted straight into the ring. Producer only. </summary>
+	/// <returns> The number of frames written. The rest did not fit, they are dropped and counted as an overrun. </returns>
+	size_t WriteInterleaved(const void* frames, SampleFormat format, size_t numFrames) {
+		uint64_t write = m_writePosition.load(std::memory_order_relaxed);
+		uint64_t read = m_readPosition.load(std::memory_order_acquire);
+		size_t numFree = m_capacity - size_t(write - read);
+		size_t numWritten = numFrames < numFree ? numFrames : numFree;
+
+		if (numWritten > 0) {
+			// up to the end of the ring, then the rest from its start
+			size_t index = size_t(write % m_capacity);
+			size_t numFirst = numWritten < m_capacity - index ? numWritten : m_capacity - index;
+			size_t frameSize = m_numChannels * GetSampleSize(format);
+			WriteRun(static_cast<const uint8_t*>(frames), format, index, numFirst);
+			WriteRun(static_cast<const uint8_t*>(frames) + numFirst * frameSize, format, 0, numWritten - numFirst);
+			m_writePosition.store(write + numWritten, std::memory_order_release);
+		}
+		if (numWritten < numFrames) {
+			m_numOverruns.fetch_add(1, std::memory_order_relaxed);
+			m_numDroppedFrames.fetch_add(numFrames - numWritten, std::memory_order_relaxed);
+		}
+		return numWritten;
+	}
+
+	/// <summary> Number of frames the producer can write without dropping any.
+	///		Called from the producer, there may be more room by the time it writes, but never less. </summary>
+	size_t GetNumWritable() const {
+		uint64_t write = m_writePosition.load(std::memory_order_relaxed);
+		uint64_t read = m_readPosition.load(std::memory_order_acquire);
+		return m_capacity - size_t(write - read);
+	}
+
+	/// <summary> Number of frames the consumer can read.
+	///		Exact when called from the consumer, a snapshot otherwise. </summary>
+	size_t GetNumReadable() const {
+		uint64_t write = m_writePosition.load(std::memory_order_acquire);
+		uint64_t read = m_readPosition.load(std::memory_order_relaxed);
+		return size_t(write - read);
+	}
+
+	/// <summary> The oldest unread sample of a channel, followed by the other GetNumReadable() samples. Consumer only. </summary>
+	const float* GetSamples(size_t channel) const {
+		uint64_t read = m_readPosition.load(std::memory_order_relaxed);
+		return m_samples.data() + channel * 2 * m_capacity + size_t(read % m_capacity);
+	}
+
+	/// <summary> Release frames that have been read, so the producer can overwrite them. Consumer only. </summary>
+	void Consume(size_t numFrames) {
+		uint64_t read = m_readPosition.load(std::memory_order_relaxed);
+		m_readPosition.store(read + numFrames, std::memory_order_release);
+	}
+
+	/// <summary> Number of writes that dropped frames because the ring was full. </summary>
+	uint64_t GetNumOverruns() const { return m_numOverruns.load(std::memory_order_relaxed); }
+	/// <summary> Number of frames dropped by overruns. </summary>
+	uint64_t GetNumDroppedFrames() const { return m_numDroppedFrames.load(std::memory_order_relaxed); }
+private:
+	void WriteRun(const uint8_t* frames, SampleFormat format, size_t index, size_t numFrames) {
+		if (numFrames == 0) {
+			return;
+		}
+		for (size_t channel = 0; channel < m_numChannels; ++channel) {
+			m_channels[channel] = m_samples.data() + channel * 2 * m_capacity + index;
+		}
+		Deinterleave(frames, format, m_numChannels, numFrames, m_channels.data());
+		for (size_t channel = 0; channel < m_numChannels; ++channel) {
+			std::copy(m_channels[channel], m_channels[channel] + numFrames, m_channels[channel] + m_capacity);
+		}
+	}
+private:
+	size_t m_numChannels;
+	size_t m_capacity;
+	std::vector<float> m_samples;
+	std::vector<float*> m_channels; // producer only
+	// keep what the producer and the consumer write on separate cache lines so they don't contend
+	alignas(64) std::atomic<uint64_t> m_writePosition;
+	std::atomic<uint64_t> m_numOverruns;
+	std::atomic<uint64_t> m_numDroppedFrames;
+	alignas(64) std::atomic<uint64_t> m_readPosition;
+};
+
+
+} // namespace exc
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "Node.hpp"
+
+#include <cstddef>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+
+namespace exc {
+
+
+/// <summary> Links output port SourcePort of node SourceNode to input port DestinationPort of
+///		node DestinationNode in a <see cref="StaticGraph"/>. Nodes are referred to by their index. </summary>
+template <size_t SourceNode, size_t SourcePort, size_t DestinationNode, size_t DestinationPort>
+struct StaticLink {};
+
+/// <summary> The list of node types of a <see cref="StaticGraph"/>, in update order. </summary>
+template <class... Nodes>
+struct StaticNodes {};
+
+/// <summary> The list of <see cref="StaticLink"/>s of a <see cref="StaticGraph"/>. </summary>
+template <class... Links>
+struct StaticLinks {};
+
+
+namespace impl {
+
+template <class Port>
+struct PortDataType;
+
+template <class T>
+struct PortDataType<OutputPort<T>> {
+	using type = T;
+};
+
+template <class T, class ConverterT>
+struct PortDataType<InputPort<T, ConverterT>> {
+	using type = T;
+};
+
+} // namespace impl
+
+
+template <class NodeList, class LinkList>
+class StaticGraph;
+
+
+/// <summary>
+/// <para> A network of nodes that is fixed at compile time. </para>
+/// <para>
+/// The graph owns one node of each listed type, and links them as listed when constructed.
+/// Links are checked at compile time: the port types must be the same, and links must point
+/// from a node to a later one in the list. Run() then updates the nodes in the listed order.
+/// </para>
+/// <para>
+/// Updates are called without virtual dispatch, and data is passed through direct links
+/// (<see cref="OutputPort::LinkDirect"/>), so transfers are plain, inlinable calls without
+/// type checks. The nodes themselves are ordinary nodes: they can be configured through
+/// GetNode(), and be linked to nodes outside the graph.
+/// </para>
+/// <example>
+/// StaticGraph&lt;StaticNodes&lt;Source, Filter, Sink&gt;, StaticLinks&lt;StaticLink&lt;0, 0, 1, 0&gt;, StaticLink&lt;1, 0, 2, 0&gt;&gt;&gt; graph;
+/// </example>
+/// </summary>
+template <class... Nodes, class... Links>
+class StaticGraph<StaticNodes<Nodes...>, StaticLinks<Links...>> {
+	using NodeTuple = std::tuple<Nodes...>;
+public:
+	StaticGraph() {
+		int expand[] = { 0, (MakeLink(Links{}), 0)... };
+		(void)expand;
+	}
+	StaticGraph(const StaticGraph&) = delete;
+	StaticGraph& operator=(const StaticGraph&) = delete;
+
+	/// <summary> Get a node by its index in the node list. </summary>
+	template <size_t Index>
+	auto& GetNode() {
+		return std::get<Index>(m_nodes);
+	}
+
+	/// <summary> Get a node by its index in the node list. </summary>
+	template <size_t Index>
+	const auto& GetNode() const {
+		return std::get<Index>(m_nodes);
+	}
+
+	/// <summary> Returns the number of nodes. </summary>
+	static constexpr size_t GetNumNodes() {
+		return sizeof...(Nodes);
+	}
+
+	/// <summary> Update each node once, in the listed order. </summary>
+	void Run() {
+		UpdateNodes(std::index_sequence_for<Nodes...>{});
+	}
+private:
+	template <size_t... Indices>
+	void UpdateNodes(std::index_sequence<Indices...>) {
+		// braced initializer lists are evaluated left to right
+		int expand[] = { 0, (UpdateNode<Indices>(), 0)... };
+		(void)expand;
+	}
+
+	template <size_t Index>
+	void UpdateNode() {
+		using NodeT = std::tuple_element_t<Index, NodeTuple>;
+		GRAPH_PROFILE_UPDATE(&std::get<Index>(m_nodes));
+		// qualified call, so it's not dispatched virtually
+		std::get<Index>(m_nodes).NodeT::Update();
+	}
+
+	template <size_t SourceNode, size_t SourcePort, size_t DestinationNode, size_t DestinationPort>
+	void MakeLink(StaticLink<SourceNode, SourcePort, DestinationNode, DestinationPort>) {
+		static_assert(SourceNode < sizeof...(Nodes) && DestinationNode < sizeof...(Nodes), "Link refers to a node that is not in the graph.");
+		static_assert(SourceNode < DestinationNode, "Links must point to a later node, nodes are updated in the listed order.");
+
+		auto& source = std::get<SourceNode>(m_nodes).template GetOutput<SourcePort>();
+		auto& destination = std::get<DestinationNode>(m_nodes).template GetInput<DestinationPort>();
+		using SourceT = typename impl::PortDataType<std::decay_t<decltype(source)>>::type;
+		using DestinationT = typename impl::PortDataType<std::decay_t<decltype(destination)>>::type;
+		static_assert(std::is_same<SourceT, DestinationT>::value, "Linked ports must have the same type.");
+
+		if (!source.LinkDirect(&destination)) {
+			throw std::logic_error("Input port is linked more than once.");
+		}
+	}
+private:
+	NodeTuple m_nodes;
+};
+
+
+} // namespace exc
@@ -0,0 +1,112 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+
+namespace exc {
+
+
+// The pool and worker index the current thread belongs to, if any.
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local size_t currentWorker = 0;
+
+
+ThreadPool::ThreadPool(size_t numThreads) {
+	if (numThreads == 0) {
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	m_numQueued = 0;
+	m_nextWorker = 0;
+	m_stop = false;
+
+	for (size_t i = 0; i < numThreads; ++i) {
+		m_workers.push_back(std::make_unique<Worker>());
+	}
+	for (size_t i = 0; i < numThreads; ++i) {
+		m_threads.emplace_back([this, i] { WorkerMain(i); });
+	}
+}
+
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lkg(m_sleepMtx);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (auto& thread : m_threads) {
+		thread.join();
+	}
+}
+
+
+void ThreadPool::Submit(Task task) {
+	size_t index = currentPool == this ? currentWorker : m_nextWorker++ % m_workers.size();
+	{
+		// counted before it's published, a worker that takes it right away must not count below zero,
+		// and taking the lock makes sure a worker going to sleep sees the new task
+		std::lock_guard<std::mutex> lkg(m_sleepMtx);
+		++m_numQueued;
+	}
+	{
+		std::lock_guard<std::mutex> lkg(m_workers[index]->mtx);
+		m_workers[index]->tasks.push_back(std::move(task));
+	}
+	m_wake.notify_one();
+}
+
+
+size_t ThreadPool::GetNumThreads() const {
+	return m_threads.size();
+}
+
+
+void ThreadPool::WorkerMain(size_t index) {
+	currentPool = this;
+	currentWorker = index;
+
+	Task task;
+	while (true) {
+		if (TryPop(index, task) || TrySteal(index, task)) {
+			--m_numQueued;
+			task();
+			task = nullptr;
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lk(m_sleepMtx);
+		m_wake.wait(lk, [this] { return m_stop || m_numQueued > 0; });
+		if (m_stop) {
+			return;
+		}
+	}
+}
+
+
+bool ThreadPool::TryPop(size_t index, Task& task) {
+	Worker& worker = *m_workers[index];
+	std::lock_guard<std::mutex> lkg(worker.mtx);
+	if (worker.tasks.empty()) {
+		return false;
+	}
+	task = std::move(worker.tasks.back());
+	worker.tasks.pop_back();
+	return true;
+}
+
+
+bool ThreadPool::TrySteal(size_t index, Task& task) {
+	for (size_t offset = 1; offset < m_workers.size(); ++offset) {
+		Worker& victim = *m_workers[(index + offset) % m_workers.size()];
+		std::lock_guard<std::mutex> lkg(victim.mtx);
+		if (!victim.tasks.empty()) {
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+
+} // namespace exc
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace exc {
+
+
+/// <summary>
+/// <para> A fixed set of worker threads that share work by stealing. </para>
+/// <para>
+/// Each worker has its own task queue. Tasks submitted from inside a worker go to
+/// that worker's queue and are picked up last-in-first-out, so dependent work stays
+/// on the same core while it's cache-hot. Idle workers steal the oldest tasks of
+/// the other workers. Tasks submitted from outside the pool are spread round-robin.
+/// </para>
+/// </summary>
+class ThreadPool {
+public:
+	using Task = std::function<void()>;
+
+	/// <summary> Start the worker threads. Zero means one per hardware thread. </summary>
+	explicit ThreadPool(size_t numThreads = 0);
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	/// <summary> Stops the workers. Tasks that have not started yet are discarded. </summary>
+	~ThreadPool();
+
+	/// <summary> Schedule a task for execution on one of the workers. </summary>
+	void Submit(Task task);
+
+	/// <summary> Get the number of worker threads. </summary>
+	size_t GetNumThreads() const;
+private:
+	struct Worker {
+		std::mutex mtx;
+		std::deque<Task> tasks;
+	};
+
+	void WorkerMain(size_t index);
+	bool TryPop(size_t index, Task& task);
+	bool TrySteal(size_t index, Task& task);
+private:
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	std::vector<std::thread> m_threads;
+	std::atomic<size_t> m_numQueued;
+	std::atomic<size_t> m_nextWorker;
+	std::atomic_bool m_stop;
+	std::mutex m_sleepMtx;
+	std::condition_variable m_wake;
+};
+
+
+} // namespace exc
@@ -1,9 +1,24 @@
 #include "Graph/Node.hpp"
+#include "Graph/SampleStream.hpp"
+#include "Graph/Deinterleave.hpp"
+#include "Graph/MultiRateNode.hpp"
+#include "Graph/FusableNode.hpp"
 
 #include "Graph/Node_Arithmetic.hpp"
 #include "Graph/Node_Comparison.hpp"
 #include "Graph/Node_Logic.hpp"
 #include "Graph/Node_MathFunctions.hpp"
+#include "Graph/Node_Stream.hpp"
+
+#include "Graph/GraphExecutor.hpp"
+#include "Graph/ParallelGraphExecutor.hpp"
+#include "Graph/PipelineExecutor.hpp"
+#include "Graph/SdfExecutor.hpp"
+#include "Graph/GraphTransaction.hpp"
+#include "Graph/StaticGraph.hpp"
+#include "Graph/GraphLoader.hpp"
+#include "Graph/Profiler.hpp"
+#include "Graph/AllocationCounter.hpp"
 
 #include "Graph/Node.hpp"
 #include "Graph/Node.hpp"
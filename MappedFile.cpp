@@ -0,0 +1,146 @@
+#include "MappedFile.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path) {
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Failed to open " + path + ": error " + std::to_string(GetLastError()));
+	}
+	m_file = file;
+	m_isOpen = true;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)) {
+		DWORD error = GetLastError();
+		Close();
+		throw std::runtime_error("Failed to get the size of " + path + ": error " + std::to_string(error));
+	}
+	m_size = size_t(size.QuadPart);
+	// empty files can't be mapped, but there is nothing to read anyway
+	if (m_size == 0) {
+		return;
+	}
+
+	m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping == nullptr) {
+		DWORD error = GetLastError();
+		Close();
+		throw std::runtime_error("Failed to map " + path + ": error " + std::to_string(error));
+	}
+	m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_data == nullptr) {
+		DWORD error = GetLastError();
+		Close();
+		throw std::runtime_error("Failed to map " + path + ": error " + std::to_string(error));
+	}
+}
+
+
+void MappedFile::Close() {
+	if (m_data) {
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping) {
+		CloseHandle(m_mapping);
+	}
+	if (m_file) {
+		CloseHandle(m_file);
+	}
+	m_data = nullptr;
+	m_mapping = nullptr;
+	m_file = nullptr;
+	m_size = 0;
+	m_isOpen = false;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path) {
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0) {
+		throw std::runtime_error("Failed to open " + path + ": " + strerror(errno));
+	}
+
+	struct stat status;
+	if (fstat(file, &status) != 0) {
+		int error = errno;
+		close(file);
+		throw std::runtime_error("Failed to get the size of " + path + ": " + strerror(error));
+	}
+	m_size = size_t(status.st_size);
+	m_isOpen = true;
+	// empty files can't be mapped, but there is nothing to read anyway
+	if (m_size == 0) {
+		close(file);
+		return;
+	}
+
+	void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+	int error = errno;
+	close(file);
+	if (data == MAP_FAILED) {
+		m_size = 0;
+		m_isOpen = false;
+		throw std::runtime_error("Failed to map " + path + ": " + strerror(error));
+	}
+	// audio is read front to back, let the kernel read ahead aggressively
+	madvise(data, m_size, MADV_SEQUENTIAL);
+	m_data = static_cast<const uint8_t*>(data);
+}
+
+
+void MappedFile::Close() {
+	if (m_data) {
+		munmap(const_cast<uint8_t*>(m_data), m_size);
+	}
+	m_data = nullptr;
+	m_size = 0;
+	m_isOpen = false;
+}
+
+#endif
+
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+	Swap(other);
+}
+
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	MappedFile moved(std::move(other));
+	Swap(moved);
+	return *this;
+}
+
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+
+void MappedFile::Swap(MappedFile& other) noexcept {
+	std::swap(m_data, other.m_data);
+	std::swap(m_size, other.m_size);
+	std::swap(m_isOpen, other.m_isOpen);
+#ifdef _WIN32
+	std::swap(m_file, other.m_file);
+	std::swap(m_mapping, other.m_mapping);
+#endif
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+/// <summary>
+/// A file mapped read-only into memory. The pages are loaded by the OS as they are touched,
+/// so reading the file doesn't need buffers of its own.
+/// </summary>
+class MappedFile {
+public:
+	MappedFile() = default;
+	/// <exception cref="std::runtime_error"> The file could not be opened or mapped. </exception>
+	explicit MappedFile(const std::string& path);
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	/// <summary> Unmap the file. </summary>
+	void Close();
+
+	bool IsOpen() const { return m_isOpen; }
+	const uint8_t* GetData() const { return m_data; }
+	size_t GetSize() const { return m_size; }
+private:
+	void Swap(MappedFile& other) noexcept;
+private:
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+	bool m_isOpen = false;
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#endif
+};
@@ -11,7 +11,7 @@
 
 class BarDisplay
 	// sample rate, channel samples
-	: public exc::InputPortConfig<int, std::vector<std::vector<float>>>,
+	: public exc::InputPortConfig<int, exc::StreamChunk>,
 	public exc::OutputPortConfig<>
 {
 public:
@@ -30,15 +30,18 @@ public:
 	void Notify(exc::InputPortBase* sender) override {}
 	void Update() override {
 		int inputSampleRate = GetInput<0>().Get();
-		std::vector<std::vector<float>> samples = GetInput<1>().Get();
+		exc::StreamWindow samples = m_reader.Read(GetInput<1>().Get());
+		if (samples.IsEmpty()) {
+			return;
+		}
 
 
 		// show volume indicators
 		DWORD written;
-		FillConsoleOutputCharacterA(hConsole, ' ', width * samples.size(), { 0, 1 }, &written);
+		FillConsoleOutputCharacterA(hConsole, ' ', width * samples.GetNumChannels(), { 0, 1 }, &written);
 		SetConsoleCursorPosition(hConsole, { 0, 1 });
-		for (int ch = 0; ch < samples.size(); ++ch) {
-			float value = !samples[ch].empty() ? samples[ch][0] : 0.0f;
+		for (int ch = 0; ch < samples.GetNumChannels(); ++ch) {
+			float value = samples.GetSamples(ch)[0];
 
 			int numChars = std::min(int(width), int(width*value));
 			numChars = std::max(0, numChars);
@@ -47,6 +50,7 @@ public:
 	}
 
 private:
+	exc::StreamReader m_reader;
 	HANDLE hConsole;
 	int width = 0, height = 0;
 };
\ No newline at end of file
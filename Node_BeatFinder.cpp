@@ -2,55 +2,41 @@
 
 using namespace mathter;
 
-BeatFinder::BeatFinder() {
-	m_buffers.resize(NumKickBands + NumSnareBands);
-}
+BeatFinder::BeatFinder()
+	: m_writer(2)
+{}
 
 
 void BeatFinder::Update() {
 	int sampleRate = GetInput<0>().Get();
-	auto signal = GetInput<1>().Get();
-	auto wavelet = GetInput<2>().Get();
 	int downsample = 1;
 
 	if (sampleRate != m_sampleRate) {
 		m_sampleRate = sampleRate;
 		ResizeBuffers();
 	}
-	if (wavelet.size() == 0) {
+
+	// Both readers look back the full history, right into the streams
+	exc::StreamWindow signal = m_signalReader.Read(GetInput<1>().Get());
+	exc::StreamWindow wavelet = m_waveletReader.Read(GetInput<2>().Get());
+	if (wavelet.IsEmpty()) {
 		GetOutput<0>().Set(sampleRate / downsample);
 		return;
 	}
-	if (wavelet.size() != NumKickBands + NumSnareBands) {
+	if (wavelet.GetNumChannels() != NumKickBands + NumSnareBands) {
 		throw std::logic_error("Wavelet band count does not match with expected band counts.");
 	}
-	
-	// Create working sets
-	std::vector<float> signalSet;
-	std::vector<std::vector<float>> workingSet(m_buffers.size());
-
-	signalSet.resize(m_signalBuffer.GetSize() + signal.size());
-	memcpy(signalSet.data(), m_signalBuffer.GetSamples(), m_signalBuffer.GetSize() * sizeof(float));
-	memcpy(signalSet.data() + m_signalBuffer.GetSize(), signal.data(), signal.size() * sizeof(float));
-	m_signalBuffer.AddSamples(signal.data(), signal.size());
-
-	for (int i = 0; i < m_buffers.size(); ++i) {
-		workingSet[i].resize(m_buffers[i].GetSize() + wavelet[i].size());
-		memcpy(workingSet[i].data(), m_buffers[i].GetSamples(), m_buffers[i].GetSize() * sizeof(float));
-		memcpy(workingSet[i].data() + m_buffers[i].GetSize(), wavelet[i].data(), wavelet[i].size() * sizeof(float));
-		m_buffers[i].AddSamples(wavelet[i].data(), wavelet[i].size());
+	if (signal.GetNumSamples() != wavelet.GetNumSamples()) {
+		throw std::logic_error("Signal and wavelet blocks differ in length.");
 	}
-	if (signal.size() != wavelet[0].size()) {
-		__debugbreak();
-	}
-	int numSamples = signal.size();
+	int numSamples = wavelet.GetNumSamples();
 
 
 	// Helper function for statistical stuff
 	auto CalcMeanKick = [&](int numPoints, int sample) -> Vector<float, NumKickBands> {
 		Vector<float, NumKickBands> ret;
 		for (int i = 0; i < NumKickBands; ++i) {
-			float* psignal = &workingSet[i].back() - numSamples - numPoints + sample + 1;
+			const float* psignal = wavelet.GetSamples(i) - numPoints + sample;
 			ret[i] = Mean(psignal, numPoints);
 		}
 		return ret;
@@ -59,8 +45,8 @@ void BeatFinder::Update() {
 		Matrix<float, NumKickBands, NumKickBands> ret;
 		for (int i = 0; i < NumKickBands; ++i) {
 			for (int j = 0; j < NumKickBands; ++j) {
-				float* psignal1 = &workingSet[i].back() - numSamples - numPoints + sample + 1;
-				float* psignal2 = &workingSet[j].back() - numSamples - numPoints + sample + 1;
+				const float* psignal1 = wavelet.GetSamples(i) - numPoints + sample;
+				const float* psignal2 = wavelet.GetSamples(j) - numPoints + sample;
 				ret(i, j) = Covariance(psignal1, psignal2, means[i], means[j], numPoints);
 			}
 		}
@@ -68,10 +54,13 @@ void BeatFinder::Update() {
 	};
 
 
-	std::vector<std::vector<float>> output(2);
+	m_writer.BeginBlock((numSamples + downsample - 1) / downsample);
+	// the kick filter is centred half its length before the newest wavelet sample
+	int64_t kickDelay = int64_t(m_kickFilter.size() - 1) / 2;
+	m_writer.SetTimestamp(wavelet.GetTimestamp().Advanced(-kickDelay).Decimated(downsample));
 
 	// Loop through each input sample
-	for (int sample = 0; sample < signal.size(); sample += downsample) {
+	for (int sample = 0; sample < numSamples; sample += downsample) {
 		// IDEA:
 		// try to least-squares fit a second degree polynomial to the kick wavelet tracks
 		// kick beat spectrum looks like this:
@@ -90,7 +79,7 @@ void BeatFinder::Update() {
 		float volume;
 
 		// calculate volume
-		float* psignal = signalSet.data() + sample;
+		const float* psignal = signal.GetChannel(0) + sample;
 		volume = Volume(psignal, m_sampleRate * 2);
 		
 
@@ -126,14 +115,14 @@ void BeatFinder::Update() {
 			sum += m_kickFilter[i] * m_kickBuffer.GetSamples()[i];
 		}
 
-		//output[0].push_back(derivative / 20);
-		output[0].push_back(sum / 15);
-		//output[1].push_back(kickProbability);
-		output[1].push_back(0);
+		//m_writer.Write(0, sample / downsample, derivative / 20);
+		m_writer.Write(0, sample / downsample, sum / 15);
+		//m_writer.Write(1, sample / downsample, kickProbability);
+		m_writer.Write(1, sample / downsample, 0);
 	}
 
 	GetOutput<0>().Set(sampleRate / downsample);
-	GetOutput<1>().Set(output);
+	GetOutput<1>().Set(m_writer.EndBlock());
 }
 
 
@@ -142,10 +131,8 @@ void BeatFinder::Update() {
 void BeatFinder::ResizeBuffers() {
 	m_historySize = m_sampleRate * 2;
 
-	for (auto& buffer : m_buffers) {
-		buffer.SetSize(m_historySize - 1);
-	}
-	m_signalBuffer.SetSize(m_historySize - 1);
+	m_signalReader.SetHistory(m_historySize - 1);
+	m_waveletReader.SetHistory(m_historySize - 1);
 
 	// kick filter
 	float kickFilterLength = 0.13f;
@@ -14,9 +14,9 @@
 
 class BeatFinder
 	// sample rate, signal, wavelet
-	: public exc::InputPortConfig<int, std::vector<float>, std::vector<std::vector<float>>>,
-	// samnple rate, beat probability
-	public exc::OutputPortConfig<int, std::vector<std::vector<float>>>
+	: public exc::InputPortConfig<int, exc::StreamChunk, exc::StreamChunk>,
+	// samnple rate, beat probability: kick, snare
+	public exc::OutputPortConfig<int, exc::StreamChunk>
 {
 	static constexpr int NumKickBands = 8;
 	static constexpr int NumSnareBands = 6;
@@ -33,8 +33,9 @@ public:
 	static float Covariance(const float* signal1, const float* signal2, float mean1, float mean2, int numSamples);
 	static float Covariance(const float* signal1, const float* signal2, int numSamples);
 private:
-	ConvolutionBuffer m_signalBuffer;
-	std::vector<ConvolutionBuffer> m_buffers;
+	exc::StreamReader m_signalReader;
+	exc::StreamReader m_waveletReader;
+	exc::StreamWriter m_writer;
 	ConvolutionBuffer m_kickBuffer;
 	std::vector<float> m_kickFilter;
 	int m_sampleRate = 1;
@@ -1,7 +1,7 @@
 #include "Node_DownSample.hpp"
 #include "Convolution.hpp"
 
-#include <Mathter\Utility.hpp>
+#include <Mathter/Utility.hpp>
 #include <numeric>
 
 using namespace mathter;
@@ -9,11 +9,25 @@ constexpr float Pi = Constants<float>::Pi;
 
 
 void DownSample::Update() {
+	BeginKernel(GetInput<1>().Get().GetNumChannels());
+
+	// the filter looks back its own length into the input stream
+	exc::StreamWindow window = ReadKernelInput();
+	size_t numSamples = window.GetNumSamples();
+
+	m_outSamples.resize(numSamples / m_currentFactor + 1);
+	float* output = m_outSamples.data();
+	m_writer.SetTimestamp(GetKernelTimestamp(window.GetTimestamp()));
+	size_t count = RunKernel(window.GetChannels(), numSamples, &output);
+	if (count > 0) {
+		GetOutput<1>().Set(m_writer.Write(output, count));
+	}
+}
+
+
+void DownSample::BeginKernel(size_t numInputChannels) {
 	int sampleRate = GetInput<0>().Get();
-	std::vector<float> inSamples = GetInput<1>().Get();
 	int factor = GetInput<2>().Get();
-	std::vector<float> workingSet;
-	std::vector<float> outSamples;
 
 	if (m_currentSampleRate != sampleRate || m_currentFactor != factor) {
 		m_currentSampleRate = sampleRate;
@@ -21,27 +35,48 @@ void DownSample::Update() {
 		RecomputeFilters();
 		m_offsetCarry = 0;
 	}
+	GetOutput<0>().Set(m_currentSampleRate / m_currentFactor);
+}
 
 
-	// prepare working set
-	workingSet.resize(m_buffer.GetSize() + inSamples.size());
-	memcpy(workingSet.data(), m_buffer.GetSamples(), m_buffer.GetSize() * sizeof(float));
-	memcpy(workingSet.data() + m_buffer.GetSize(), inSamples.data(), inSamples.size() * sizeof(float));
-	m_buffer.AddSamples(inSamples.data(), inSamples.size());
+exc::StreamWindow DownSample::ReadKernelInput() {
+	return m_reader.Read(GetInput<1>().Get());
+}
 
-	// apply convolution filter
-	std::vector<float> signalBuffer(workingSet.size());
-	for (size_t i = m_offsetCarry; i < inSamples.size(); i+=m_currentFactor) {
-		size_t dim = m_lpf.size();
-		float* signal = workingSet.data() + m_buffer.GetSize() - dim + i;
-		memcpy(signalBuffer.data(), signal, sizeof(float)*dim);
 
-		outSamples.push_back(ScalarProduct(m_lpf.data(), signalBuffer.data(), dim));
+exc::StreamTimestamp DownSample::GetKernelTimestamp(const exc::StreamTimestamp& input) const {
+	// the first output is centred half the filter before the input sample at the decimation phase
+	int64_t delay = int64_t(m_lpf.size() + 1) / 2;
+	return input.Advanced(m_offsetCarry - delay).Decimated(m_currentFactor);
+}
+
+
+size_t DownSample::RunKernel(const float* const* input, size_t numSamples, float* const* output) {
+	// apply convolution filter
+	size_t dim = m_lpf.size();
+	size_t count = 0;
+	size_t i = m_offsetCarry;
+	for (; i < numSamples; i+=m_currentFactor) {
+		const float* signal = input[0] + i;
+		output[0][count++] = ScalarProduct(m_lpf.data(), signal, dim);
 	}
-	m_offsetCarry = (inSamples.size() - m_offsetCarry) % m_currentFactor; // this formula might be totally wrong
+	// decimation phase of the next call, always 0 for blocks that are a multiple of the factor
+	m_offsetCarry = int(i - numSamples);
+	return count;
+}
 
-	GetOutput<0>().Set(m_currentSampleRate / m_currentFactor);
-	GetOutput<1>().Set(outSamples);
+
+exc::RateRatio DownSample::GetRateRatio() const {
+	int factor = GetInput<2>().Get();
+	exc::RateRatio ratio;
+	ratio.denominator = factor > 0 ? factor : 1;
+	return ratio;
+}
+
+
+void DownSample::SetBlockSize(size_t numInputSamples) {
+	int factor = GetInput<2>().Get();
+	m_outSamples.reserve(numInputSamples / (factor > 0 ? factor : 1) + 1);
 }
 
 
@@ -52,7 +87,7 @@ void DownSample::RecomputeFilters() {
 	float cutoff = newNyquistLimit * 0.85f;
 
 	m_lpf = CreateLPF(m_currentSampleRate, cutoff, 0.002f);
-	m_buffer.SetSize(m_lpf.size());
+	m_reader.SetHistory(m_lpf.size());
 }
 
 
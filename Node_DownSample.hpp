@@ -2,25 +2,39 @@
 
 #include "Graph_All.hpp"
 
-#include "ConvolutionBuffer.hpp"
-
 
 class DownSample
 	// sample rate, channel samples, decimation factor
-	: public exc::InputPortConfig<int, std::vector<float>, int>,
+	: public exc::InputPortConfig<int, exc::StreamChunk, int>,
 	// sample rate, channel samples
-	public exc::OutputPortConfig<int, std::vector<float>>
+	public exc::OutputPortConfig<int, exc::StreamChunk>,
+	public exc::FusableNode
 {
 public:
 	void Notify(exc::InputPortBase* sender) override {}
 	void Update() override;
 
+	exc::RateRatio GetRateRatio() const override;
+	void SetBlockSize(size_t numInputSamples) override;
+
+	size_t GetKernelInput() const override { return 1; }
+	void BeginKernel(size_t numInputChannels) override;
+	exc::StreamWindow ReadKernelInput() override;
+	size_t GetKernelHistory() const override { return m_lpf.size(); }
+	size_t GetNumKernelOutputs() const override { return 1; }
+	exc::KernelOutput GetKernelOutput(size_t index) const override { return { 1, 1 }; }
+	exc::StreamWriter& GetKernelWriter(size_t index) override { return m_writer; }
+	exc::StreamTimestamp GetKernelTimestamp(const exc::StreamTimestamp& input) const override;
+	size_t RunKernel(const float* const* input, size_t numSamples, float* const* output) override;
+
 private:
 	void RecomputeFilters();
 	static std::vector<float> CreateLPF(int sampleRate, float cutoff, float length);
 
 private:
-	ConvolutionBuffer m_buffer;
+	exc::StreamReader m_reader;
+	exc::StreamWriter m_writer;
+	std::vector<float> m_outSamples;
 	std::vector<float> m_lpf;
 	int m_currentSampleRate = 1;
 	int m_currentFactor = 1;
@@ -3,43 +3,51 @@
 
 
 void FFT::Update() {
-	if (!m_fft) {
+	if (!m_setup.fft) {
 		SetBinCount(1024, 1024);
 	}
 
 	int sampleRate = GetInput<0>().Get();
-	std::vector<float> signal = GetInput<1>().Get();
-	m_buffer.AddSamples(signal.data(), signal.size());
-
 	float maxFreq = sampleRate / 2.0f;
-	int fftSize = m_fft->get_length();
 
-	std::vector<std::complex<float>> fourierTransform(m_fft->get_length()/2);
-	std::vector<float> inputBuffer(fftSize);
-	std::vector<float> outputBuffer(fftSize);
+	// nothing new to transform, the previous spectrum still stands
+	exc::StreamWindow window = m_reader.Read(GetInput<1>().Get());
+	if (window.IsEmpty()) {
+		GetOutput<0>().Set(maxFreq);
+		return;
+	}
+	// the last sampleCount samples end at the newest one
+	const float* signal = window.GetChannel(0) + window.GetNumSamples();
+
+	int fftSize = m_setup.fft->get_length();
 
 	// apply window function
-	memcpy(inputBuffer.data(), m_buffer.GetSamples(), m_sampleCount * sizeof(float));
-	memset(inputBuffer.data() + m_sampleCount, 0, (fftSize - m_sampleCount) * sizeof(float));
-	int N = m_sampleCount - 1;
-	for (int i = 0; i < m_sampleCount; ++i) {
-		float w = 0.54f - 0.46*cos(2.f*3.1415926f*i / N);
-		inputBuffer[i] *= w;
+	float* inputBuffer = m_setup.inputBuffer.data();
+	for (int i = 0; i < m_setup.sampleCount; ++i) {
+		inputBuffer[i] = signal[i] * m_setup.window[i];
 	}
 
-	m_fft->do_fft(outputBuffer.data(), inputBuffer.data());
+	m_setup.fft->do_fft(m_setup.outputBuffer.data(), inputBuffer);
 
+	std::vector<std::complex<float>>& fourierTransform = m_setup.fourierTransform;
 	for (int i = 0; i < fourierTransform.size(); ++i) {
-		fourierTransform[i].real(outputBuffer[i]);
-		fourierTransform[i].imag(outputBuffer[i + fftSize/2]);
+		fourierTransform[i].real(m_setup.outputBuffer[i]);
+		fourierTransform[i].imag(m_setup.outputBuffer[i + fftSize/2]);
 	}
 
+	// copied into the linked inputs, which keep their capacity from the previous update
 	GetOutput<0>().Set(maxFreq);
 	GetOutput<1>().Set(fourierTransform);
 }
 
 
 void FFT::SetBinCount(int sampleCount, int fftBins) {
+	Setup setup = PrepareSetup(sampleCount, fftBins);
+	SwapSetup(setup);
+}
+
+
+auto FFT::PrepareSetup(int sampleCount, int fftBins) -> Setup {
 	if (sampleCount > fftBins) {
 		throw std::logic_error("Sample count must be less or equal to bin count.");
 	}
@@ -48,15 +56,34 @@ void FFT::SetBinCount(int sampleCount, int fftBins) {
 	while (power < fftBins) {
 		power *= 2;
 	}
-	m_fft = std::make_unique<ffft::FFTReal<float>>( power );
-	m_buffer.SetSize(sampleCount);
-	m_sampleCount = sampleCount;
+
+	Setup setup;
+	setup.fft = std::make_unique<ffft::FFTReal<float>>( power );
+	setup.sampleCount = sampleCount;
+
+	// Hamming window, the padding after the samples stays zero
+	setup.window.resize(sampleCount);
+	int N = sampleCount - 1;
+	for (int i = 0; i < sampleCount; ++i) {
+		setup.window[i] = 0.54f - 0.46*cos(2.f*3.1415926f*i / N);
+	}
+	setup.inputBuffer.assign(power, 0.0f);
+	setup.outputBuffer.assign(power, 0.0f);
+	setup.fourierTransform.assign(power / 2, {});
+	return setup;
+}
+
+
+void FFT::SwapSetup(Setup& setup) {
+	std::swap(m_setup, setup);
+	m_reader.SetHistory(m_setup.sampleCount);
 }
 
+
 int FFT::GetBinCount() const {
-	return m_fft ? m_fft->get_length() : 1024;
+	return m_setup.fft ? m_setup.fft->get_length() : 1024;
 }
 
 int FFT::GetSampleCount() const {
-	return m_sampleCount;
+	return m_setup.sampleCount;
 }
\ No newline at end of file
@@ -1,7 +1,6 @@
 #pragma once
 
 #include "Graph_All.hpp"
-#include "ConvolutionBuffer.hpp"
 
 #include <ffft/FFTReal.h>
 #include <complex>
@@ -11,10 +10,21 @@
 
 class FFT
 	// sample rate, channel samples
-	: public exc::InputPortConfig<int, std::vector<float>>,
+	: public exc::InputPortConfig<int, exc::StreamChunk>,
 	// max frequency, fourier transform
 	public exc::OutputPortConfig<float, std::vector<std::complex<float>>>
 {
+public:
+	/// <summary> The transform and the buffers for a sample count and number of bins. It takes a while to set up,
+	///		so it can be prepared on another thread, then swapped in between updates. </summary>
+	struct Setup {
+		std::unique_ptr<ffft::FFTReal<float>> fft;
+		int sampleCount = 1;
+		std::vector<float> window;
+		std::vector<float> inputBuffer;
+		std::vector<float> outputBuffer;
+		std::vector<std::complex<float>> fourierTransform;
+	};
 public:
 	void Notify(exc::InputPortBase* sender) override {}
 	void Update() override;
@@ -22,8 +32,13 @@ public:
 	void SetBinCount(int sampleCount, int fftBins);
 	int GetSampleCount() const;
 	int GetBinCount() const;
+
+	/// <summary> Set up the transform. Doesn't touch any node, safe to call from any thread. </summary>
+	/// <exception cref="std::logic_error"> The sample count is larger than the bin count. </exception>
+	static Setup PrepareSetup(int sampleCount, int fftBins);
+	/// <summary> Exchange the setup with the one in use. Swapping again restores the previous one. </summary>
+	void SwapSetup(Setup& setup);
 private:
-	ConvolutionBuffer m_buffer;
-	std::unique_ptr<ffft::FFTReal<float>> m_fft;
-	int m_sampleCount = 1;
+	exc::StreamReader m_reader;
+	Setup m_setup;
 };
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "Node_FileSource.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+
+namespace {
+
+uint16_t ReadU16(const uint8_t* data) {
+	return uint16_t(data[0] | (data[1] << 8));
+}
+
+uint32_t ReadU32(const uint8_t* data) {
+	return uint32_t(data[0]) | (uint32_t(data[1]) << 8) | (uint32_t(data[2]) << 16) | (uint32_t(data[3]) << 24);
+}
+
+} // namespace
+
+
+FileSource::FileSource(size_t framesPerUpdate)
+	: m_framesPerUpdate(std::max(framesPerUpdate, size_t(1)))
+{}
+
+
+void FileSource::Open(const std::string& path) {
+	MappedFile file(path);
+	const uint8_t* data = file.GetData();
+	size_t size = file.GetSize();
+	if (size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0) {
+		throw std::runtime_error(path + " is not a WAV file.");
+	}
+
+	// walk the chunks for the format and the samples, chunks are padded to an even size
+	const uint8_t* format = nullptr;
+	size_t formatSize = 0;
+	const uint8_t* samples = nullptr;
+	size_t samplesSize = 0;
+	size_t offset = 12;
+	while (offset + 8 <= size && (!format || !samples)) {
+		const uint8_t* chunk = data + offset;
+		size_t chunkSize = ReadU32(chunk + 4);
+		size_t available = std::min(chunkSize, size - offset - 8);
+		if (memcmp(chunk, "fmt ", 4) == 0 && available >= 16) {
+			format = chunk + 8;
+			formatSize = available;
+		}
+		else if (memcmp(chunk, "data", 4) == 0) {
+			// recorders that were cut off leave the size too large, or 0
+			samples = chunk + 8;
+			samplesSize = chunkSize == 0 ? size - offset - 8 : available;
+		}
+		offset += 8 + chunkSize + (chunkSize & 1);
+	}
+	if (!format || !samples) {
+		throw std::runtime_error(path + " has no format or no data chunk.");
+	}
+
+	uint16_t formatTag = ReadU16(format);
+	size_t numChannels = ReadU16(format + 2);
+	int sampleRate = int(ReadU32(format + 4));
+	uint16_t bitsPerSample = ReadU16(format + 14);
+	// WAVE_FORMAT_EXTENSIBLE keeps the actual format tag at the start of the sub-format GUID
+	if (formatTag == 0xFFFE && formatSize >= 40) {
+		formatTag = ReadU16(format + 24);
+	}
+
+	SampleFormat sampleFormat;
+	if (formatTag == 1 && bitsPerSample == 16) {
+		sampleFormat = SampleFormat::Int16;
+	}
+	else if (formatTag == 1 && bitsPerSample == 24) {
+		sampleFormat = SampleFormat::Int24;
+	}
+	else if (formatTag == 3 && bitsPerSample == 32) {
+		sampleFormat = SampleFormat::Float32;
+	}
+	else {
+		throw std::runtime_error(path + " has an unsupported format: tag " + std::to_string(formatTag) + ", " + std::to_string(bitsPerSample) + " bits.");
+	}
+	if (numChannels == 0 || sampleRate <= 0) {
+		throw std::runtime_error(path + " has no channels or no sample rate.");
+	}
+
+	m_file = std::move(file);
+	SetData(samples, samplesSize, sampleFormat, numChannels, sampleRate);
+}
+
+
+void FileSource::OpenRaw(const std::string& path, SampleFormat format, size_t numChannels, int sampleRate) {
+	if (numChannels == 0 || sampleRate <= 0) {
+		throw std::invalid_argument("Raw files need at least one channel and a sample rate.");
+	}
+	MappedFile file(path);
+	m_file = std::move(file);
+	SetData(m_file.GetData(), m_file.GetSize(), format, numChannels, sampleRate);
+}
+
+
+void FileSource::Close() {
+	m_file.Close();
+	SetData(nullptr, 0, SampleFormat::Float32, 0, 0);
+}
+
+
+void FileSource::SetFramesPerUpdate(size_t numFrames) {
+	m_framesPerUpdate = std::max(numFrames, size_t(1));
+}
+
+
+void FileSource::Seek(uint64_t frame) {
+	m_position = std::min(frame, m_numFrames + m_tailLength);
+}
+
+
+void FileSource::Update() {
+	// only on change, so that pull mode can skip the nodes that depend on the rate
+	if (m_sampleRate != m_lastSampleRate) {
+		GetOutput<0>().Set(m_sampleRate);
+		m_lastSampleRate = m_sampleRate;
+	}
+	if (IsEndOfStream()) {
+		return;
+	}
+
+	size_t count = size_t(std::min<uint64_t>(m_framesPerUpdate, m_numFrames + m_tailLength - m_position));
+	size_t numFileFrames = m_position < m_numFrames ? size_t(std::min<uint64_t>(count, m_numFrames - m_position)) : 0;
+	size_t frameSize = m_numChannels * exc::GetSampleSize(m_format);
+	const uint8_t* frames = m_data + m_position * frameSize;
+
+	// deinterleave straight from the mapping into the stream, samples may not be aligned in WAV files
+	m_writer.SetNumChannels(m_numChannels);
+	m_writer.BeginBlock(count);
+	m_channels.resize(m_numChannels);
+	for (size_t channel = 0; channel < m_numChannels; ++channel) {
+		m_channels[channel] = m_writer.GetBlock(channel);
+	}
+	exc::Deinterleave(frames, m_format, m_numChannels, numFileFrames, m_channels.data());
+	for (size_t channel = 0; channel < m_numChannels; ++channel) {
+		std::fill(m_channels[channel] + numFileFrames, m_channels[channel] + count, 0.0f);
+	}
+	// the whole block is read at once, as if its newest frame was captured now
+	int64_t newest = int64_t(m_position + count - 1);
+	m_writer.SetTimestamp(exc::StreamTimestamp::Captured(newest, m_sampleRate, exc::StreamTimestamp::Clock::now()).Advanced(1 - int64_t(count)));
+	m_position += count;
+
+	GetOutput<1>().Set(m_writer.EndBlock());
+}
+
+
+void FileSource::SetData(const uint8_t* data, size_t size, SampleFormat format, size_t numChannels, int sampleRate) {
+	m_data = data;
+	m_format = format;
+	m_numChannels = numChannels;
+	m_sampleRate = sampleRate;
+	m_numFrames = numChannels > 0 ? size / (numChannels * exc::GetSampleSize(format)) : 0;
+	m_position = 0;
+}
+
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Graph_All.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/// <summary>
+/// <para> Plays a WAV or raw PCM file, a block of frames per update. </para>
+/// <para>
+/// The file is memory-mapped, and each block is deinterleaved from the mapping straight into the
+/// output stream. Supports 16 and 24 bit integer and 32 bit float samples, with any number of channels.
+/// After the last frame, and the silent tail if any, updates produce nothing and IsEndOfStream() is true.
+/// </para>
+/// </summary>
+class FileSource
+	: public exc::InputPortConfig<>,
+	// sample rate, channel samples
+	public exc::OutputPortConfig<int, exc::StreamChunk>
+{
+public:
+	using SampleFormat = exc::SampleFormat;
+public:
+	explicit FileSource(size_t framesPerUpdate = 441);
+
+	/// <summary> Open a WAV file, the format is read from its header. </summary>
+	/// <exception cref="std::runtime_error"> The file can't be read, or it's not a WAV file in a supported format. </exception>
+	void Open(const std::string& path);
+	/// <summary> Open a file of interleaved samples without a header. </summary>
+	/// <exception cref="std::runtime_error"> The file can't be read. </exception>
+	/// <exception cref="std::invalid_argument"> No channels or no sample rate. </exception>
+	void OpenRaw(const std::string& path, SampleFormat format, size_t numChannels, int sampleRate);
+	void Close();
+
+	/// <summary> Number of frames produced per update, the last block may be shorter. </summary>
+	void SetFramesPerUpdate(size_t numFrames);
+	size_t GetFramesPerUpdate() const { return m_framesPerUpdate; }
+	/// <summary> Continue from a frame, clamped to the end of the tail. </summary>
+	void Seek(uint64_t frame);
+	/// <summary> The next frame to play. </summary>
+	uint64_t GetPosition() const { return m_position; }
+	/// <summary> Play this many frames of silence after the file, to flush the delay of filters downstream. </summary>
+	void SetTailLength(uint64_t numFrames) { m_tailLength = numFrames; }
+	uint64_t GetTailLength() const { return m_tailLength; }
+
+	/// <summary> Number of frames in the file, without the tail. </summary>
+	uint64_t GetNumFrames() const { return m_numFrames; }
+	size_t GetNumChannels() const { return m_numChannels; }
+	int GetSampleRate() const { return m_sampleRate; }
+	SampleFormat GetSampleFormat() const { return m_format; }
+	bool IsEndOfStream() const { return m_position >= m_numFrames + m_tailLength; }
+
+	void Notify(exc::InputPortBase* sender) override {}
+	void Update() override;
+private:
+	void SetData(const uint8_t* data, size_t size, SampleFormat format, size_t numChannels, int sampleRate);
+private:
+	MappedFile m_file;
+	exc::StreamWriter m_writer;
+	std::vector<float*> m_channels;
+	const uint8_t* m_data = nullptr;
+	SampleFormat m_format = SampleFormat::Float32;
+	size_t m_numChannels = 0;
+	int m_sampleRate = 0;
+	int m_lastSampleRate = -1;
+	uint64_t m_numFrames = 0;
+	uint64_t m_position = 0;
+	uint64_t m_tailLength = 0;
+	size_t m_framesPerUpdate;
+};
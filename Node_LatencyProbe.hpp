@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Graph_All.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+
+/// <summary>
+/// <para> Measures how long ago the newest samples of a stream were captured, every time new samples arrive. </para>
+/// <para>
+/// The latency is the time from the capture of the source sample the newest sample is centred on, to
+/// the update of the probe. It includes the group delay of the filters along the way, and the time the
+/// graph took. Streams without a capture time, such as those written by nodes that don't stamp their
+/// output, are not measured.
+/// </para>
+/// </summary>
+class LatencyProbe
+	// samples
+	: public exc::InputPortConfig<exc::StreamChunk>,
+	// latency in seconds
+	public exc::OutputPortConfig<float>
+{
+public:
+	void Notify(exc::InputPortBase* sender) override {}
+	void Update() override {
+		const exc::StreamChunk& chunk = GetInput<0>().Get();
+		if (chunk.IsEmpty() || chunk.end <= m_lastEnd) {
+			return;
+		}
+		m_lastEnd = chunk.end;
+
+		exc::StreamTimestamp newest = chunk.GetTimestamp(chunk.end - 1);
+		if (!newest.HasCaptureTime()) {
+			return;
+		}
+		std::chrono::duration<double> latency = exc::StreamTimestamp::Clock::now() - newest.GetCaptureTime();
+		m_latency = latency.count();
+		m_minLatency = std::min(m_minLatency, m_latency);
+		m_maxLatency = std::max(m_maxLatency, m_latency);
+		m_totalLatency += m_latency;
+		++m_numMeasurements;
+
+		GetOutput<0>().Set(float(m_latency));
+	}
+
+	/// <summary> Forget the measurements so far. </summary>
+	void Reset() {
+		m_latency = 0.0;
+		m_minLatency = std::numeric_limits<double>::infinity();
+		m_maxLatency = 0.0;
+		m_totalLatency = 0.0;
+		m_numMeasurements = 0;
+	}
+
+	/// <summary> Latency of the last update that got new samples, in seconds. </summary>
+	double GetLatency() const { return m_latency; }
+	double GetMinLatency() const { return m_numMeasurements > 0 ? m_minLatency : 0.0; }
+	double GetMaxLatency() const { return m_maxLatency; }
+	double GetMeanLatency() const { return m_numMeasurements > 0 ? m_totalLatency / m_numMeasurements : 0.0; }
+	uint64_t GetNumMeasurements() const { return m_numMeasurements; }
+private:
+	int64_t m_lastEnd = std::numeric_limits<int64_t>::min();
+	double m_latency = 0.0;
+	double m_minLatency = std::numeric_limits<double>::infinity();
+	double m_maxLatency = 0.0;
+	double m_totalLatency = 0.0;
+	uint64_t m_numMeasurements = 0;
+};
@@ -1,14 +1,18 @@
 #include "Node_LoopbackSource.hpp"
 #include "ScopeGuard.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 
 using Microsoft::WRL::ComPtr;
 
 
-LoopbackSource::LoopbackSource() {
+LoopbackSource::LoopbackSource()
+	: m_captureOrigin(0)
+{
 	GetOutput<0>().Set(11025);
+	m_lastSampleRate = -1;
 }
 
 LoopbackSource::~LoopbackSource() {
@@ -18,6 +22,8 @@ LoopbackSource::~LoopbackSource() {
 void LoopbackSource::Start(std::string deviceName) {
 	ComPtr<IMMDevice> device = GetPlaybackDevice(deviceName);
 	InitializeCaptureClient(device);
+	m_captureOrigin = 0;
+	m_sourcePosition = 0;
 
 	std::promise<void> result;
 	m_threadResult = result.get_future();
@@ -48,19 +54,33 @@ void LoopbackSource::Stop() {
 
 
 void LoopbackSource::Update() {
-	if (m_runThread) {
-		GetOutput<0>().Set((int)m_waveformat.nSamplesPerSec);
-	}
-	else {
-		GetOutput<0>().Set(0);
+	// only set outputs that changed, so that lazy executors can skip the nodes downstream
+	int sampleRate = m_runThread ? (int)m_waveformat.nSamplesPerSec : 0;
+	if (sampleRate != m_lastSampleRate) {
+		GetOutput<0>().Set(sampleRate);
+		m_lastSampleRate = sampleRate;
 	}
 
-	std::lock_guard<std::mutex> lkg(m_mtx);
-	GetOutput<1>().Set(m_samples);
-
-	for (auto& ch : m_samples) {
-		ch.clear();
+	// copy what the capture thread has written straight from its ring into the stream
+	size_t numFrames = m_ring.GetNumReadable();
+	if (numFrames == 0) {
+		return;
+	}
+	m_writer.SetNumChannels(m_ring.GetNumChannels());
+	m_writer.BeginBlock(numFrames);
+	for (size_t channel = 0; channel < m_ring.GetNumChannels(); ++channel) {
+		m_writer.Write(channel, m_ring.GetSamples(channel));
 	}
+	m_ring.Consume(numFrames);
+
+	// the origin may already come from a later packet, that only refines the estimate
+	exc::StreamTimestamp timestamp;
+	timestamp.sourcePosition = m_sourcePosition;
+	timestamp.sourceRate = (int)m_waveformat.nSamplesPerSec;
+	timestamp.sourceOrigin = exc::StreamTimestamp::Clock::time_point(exc::StreamTimestamp::Clock::duration(m_captureOrigin.load()));
+	m_writer.SetTimestamp(timestamp);
+	m_sourcePosition += int64_t(numFrames);
+	GetOutput<1>().Set(m_writer.EndBlock());
 }
 
 
@@ -151,8 +171,7 @@ void LoopbackSource::InitializeCaptureClient(Microsoft::WRL::ComPtr<IMMDevice> d
 
 	m_audioClient = audioClient;
 	m_captureClient = captureClient;
-	m_samples.clear();
-	m_samples.resize(m_waveformat.nChannels);
+	m_ring.Reset(m_waveformat.nChannels, m_waveformat.nSamplesPerSec); // one second of audio
 }
 
 
@@ -190,13 +209,21 @@ void LoopbackSource::CaptureThread(Microsoft::WRL::ComPtr<IMMDevice> device, std
 		IAudioClient* c;
 	} _stopGuard{ m_audioClient.Get() };
 
+	// packets are stamped with the performance counter in 100 ns units, read it together with the
+	// stream clock to map the capture times onto it, their epochs aren't guaranteed to match
+	using Hns = std::chrono::duration<int64_t, std::ratio<1, 10000000>>;
+	LARGE_INTEGER qpcFrequency, qpcNow;
+	QueryPerformanceFrequency(&qpcFrequency);
+	QueryPerformanceCounter(&qpcNow);
+	auto clockNow = exc::StreamTimestamp::Clock::now();
+	Hns qpcNowHns(qpcNow.QuadPart / qpcFrequency.QuadPart * 10000000 + qpcNow.QuadPart % qpcFrequency.QuadPart * 10000000 / qpcFrequency.QuadPart);
+	auto clockOffset = clockNow.time_since_epoch() - std::chrono::duration_cast<exc::StreamTimestamp::Clock::duration>(qpcNowHns);
+
 
 	// data processing loop
-	std::vector<std::vector<float>> samples;
-	std::vector<float> volume(m_waveformat.nChannels, 0.0f);
-	samples.resize(m_waveformat.nChannels);
 	long long numFramesCaptured = 0;
 	long long numSamplesCaptured = 0;
+	long long numFramesStored = 0;
 
 	while (m_runThread) {
 		// pop as many packets as possible
@@ -212,9 +239,10 @@ void LoopbackSource::CaptureThread(Microsoft::WRL::ComPtr<IMMDevice> device, std
 			uint8_t* data;
 			uint32_t numFramesToRead;
 			DWORD flags;
+			UINT64 captureTime;
 			if (hasPacket) {
 				// get buffer to audio data
-				hr = m_captureClient->GetBuffer(&data, &numFramesToRead, &flags, NULL, NULL);
+				hr = m_captureClient->GetBuffer(&data, &numFramesToRead, &flags, NULL, &captureTime);
 				if (FAILED(hr)) {
 					throw std::runtime_error("Failed to get buffer: hr = " + std::to_string(hr));
 				}
@@ -230,35 +258,18 @@ void LoopbackSource::CaptureThread(Microsoft::WRL::ComPtr<IMMDevice> device, std
 					throw std::runtime_error("GetBuffer returned invalid flags: flag = " + std::to_string(flags));
 				}
 
-				// read audio data
-				int channel = 0;
-				float* fData = reinterpret_cast<float*>(data);
-				int numChannels = m_waveformat.nChannels;
-				int numSamples = numFramesToRead * m_waveformat.nBlockAlign / sizeof(float) / numChannels;
-				for (auto& channelSamples : samples) {
-					channelSamples.resize(numSamples);
-				}
-				for (int i = 0; i < numSamples; ++i) {
-					for (int ch = 0; ch < numChannels; ++ch) {
-						samples[ch][i] = fData[i*numChannels + ch];
-					}
-					//samples[channel][i/numChannels] = fData[i + channel];
-					//++channel;
-					//channel %= m_waveformat.nChannels;
+				// deinterleave straight into the ring, never waits for the graph, InitializeCaptureClient asked for floats
+				size_t numStored = m_ring.WriteInterleaved(data, exc::SampleFormat::Float32, numFramesToRead);
+				if (numStored > 0) {
+					auto firstFrameTime = exc::StreamTimestamp::Clock::time_point(std::chrono::duration_cast<exc::StreamTimestamp::Clock::duration>(Hns(captureTime)) + clockOffset);
+					m_captureOrigin = exc::StreamTimestamp::Captured(numFramesStored, (int)m_waveformat.nSamplesPerSec, firstFrameTime).sourceOrigin.time_since_epoch().count();
+					numFramesStored += numStored;
 				}
 
 				// release buffer
 				m_captureClient->ReleaseBuffer(numFramesToRead);
 				numFramesCaptured += numFramesToRead;
-				numSamplesCaptured += numSamples;
-
-				// write data to internal buffers
-				std::lock_guard<std::mutex> lkg(m_mtx);
-				if (m_samples[0].size() < 1048576) {
-					for (int i = 0; i < m_samples.size(); ++i) {
-						m_samples[i].insert(m_samples[i].end(), samples[i].begin(), samples[i].end());
-					}
-				}
+				numSamplesCaptured += numFramesToRead;
 			}
 		} while (hasPacket);
 
@@ -268,4 +279,5 @@ void LoopbackSource::CaptureThread(Microsoft::WRL::ComPtr<IMMDevice> device, std
 
 	std::cout << "Captured " << (double)numSamplesCaptured / m_waveformat.nSamplesPerSec << " seconds of audio (" << numSamplesCaptured << " samples)." << std::endl;
 	std::cout << "numFrames = " << numFramesCaptured << std::endl;
+	std::cout << "Overruns: " << m_ring.GetNumOverruns() << " (" << m_ring.GetNumDroppedFrames() << " frames dropped)" << std::endl;
 }
\ No newline at end of file
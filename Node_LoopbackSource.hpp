@@ -1,10 +1,10 @@
 #pragma once
 
 #include "Graph_All.hpp"
+#include "Graph/SpscSampleRing.hpp"
 
 #include <vector>
 #include <thread>
-#include <mutex>
 #include <atomic>
 #include <future>
 
@@ -21,7 +21,7 @@
 class LoopbackSource 
 	: public exc::InputPortConfig<>,
 	// sample rate, channel samples
-	public exc::OutputPortConfig<int, std::vector<std::vector<float>>>
+	public exc::OutputPortConfig<int, exc::StreamChunk>
 {
 public:
 	LoopbackSource();
@@ -33,6 +33,11 @@ public:
 	void Notify(exc::InputPortBase* sender) override {}
 	void Update() override;
 
+	/// <summary> Number of packets the capture thread could not store completely, because the graph fell behind. </summary>
+	uint64_t GetNumOverruns() const { return m_ring.GetNumOverruns(); }
+	/// <summary> Number of frames lost by overruns. </summary>
+	uint64_t GetNumDroppedFrames() const { return m_ring.GetNumDroppedFrames(); }
+
 protected:
 	static Microsoft::WRL::ComPtr<IMMDevice> GetPlaybackDevice(std::string name);
 	void InitializeCaptureClient(Microsoft::WRL::ComPtr<IMMDevice> device);
@@ -43,8 +48,12 @@ protected:
 	std::thread m_captureThread;
 	std::atomic_bool m_runThread;
 	std::future<void> m_threadResult;
-	std::mutex m_mtx;
-	std::vector<std::vector<float>> m_samples;
+	exc::SpscSampleRing m_ring;
+	exc::StreamWriter m_writer;
+	int m_lastSampleRate;
+	// when frame 0 of the ring would have been captured, in clock ticks, updated for every packet
+	std::atomic<int64_t> m_captureOrigin;
+	int64_t m_sourcePosition = 0;
 
 	Microsoft::WRL::ComPtr<IAudioCaptureClient> m_captureClient;
 	Microsoft::WRL::ComPtr<IAudioClient> m_audioClient;
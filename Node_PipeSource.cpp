@@ -0,0 +1,304 @@
+#include "Node_PipeSource.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+
+enum class WaitResult {
+	Ready,
+	Timeout,
+	Interrupted,
+};
+
+
+#ifdef _WIN32
+
+HANDLE GetHandle(int fd) {
+	HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+	if (handle == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("The descriptor " + std::to_string(fd) + " is not open.");
+	}
+	return handle;
+}
+
+
+// A console read blocks until a line is typed, with no way to time it out, so Stop() could wait forever.
+// Consoles can't carry binary PCM anyway.
+void CheckInput(int fd) {
+	HANDLE handle = GetHandle(fd);
+	DWORD mode = 0;
+	if (GetFileType(handle) == FILE_TYPE_CHAR && GetConsoleMode(handle, &mode)) {
+		throw std::invalid_argument("The descriptor " + std::to_string(fd) + " is a console, redirect a pipe or a file to it.");
+	}
+}
+
+
+// Anonymous pipes can't be waited on, they are peeked until data arrives. Files and devices other than consoles never block.
+WaitResult WaitForInput(int fd, std::chrono::milliseconds timeout) {
+	HANDLE handle = GetHandle(fd);
+	if (GetFileType(handle) != FILE_TYPE_PIPE) {
+		return WaitResult::Ready;
+	}
+	auto deadline = std::chrono::steady_clock::now() + timeout;
+	while (true) {
+		DWORD numAvailable = 0;
+		if (!PeekNamedPipe(handle, nullptr, 0, nullptr, &numAvailable, nullptr)) {
+			// the writer closed its end, the read reports it
+			if (GetLastError() == ERROR_BROKEN_PIPE) {
+				return WaitResult::Ready;
+			}
+			throw std::runtime_error("Failed to wait for the pipe: error " + std::to_string(GetLastError()));
+		}
+		if (numAvailable > 0) {
+			return WaitResult::Ready;
+		}
+		if (std::chrono::steady_clock::now() >= deadline) {
+			return WaitResult::Timeout;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+
+// Bytes read, 0 at the end of the input.
+size_t ReadInput(int fd, uint8_t* buffer, size_t size, WaitResult& result) {
+	DWORD numRead = 0;
+	result = WaitResult::Ready;
+	if (!ReadFile(GetHandle(fd), buffer, DWORD(std::min(size, size_t(MAXDWORD))), &numRead, nullptr)) {
+		if (GetLastError() == ERROR_BROKEN_PIPE) {
+			return 0;
+		}
+		throw std::runtime_error("Failed to read the pipe: error " + std::to_string(GetLastError()));
+	}
+	return numRead;
+}
+
+#else
+
+// Terminals are polled like pipes, Stop() can interrupt them.
+void CheckInput(int fd) {}
+
+
+WaitResult WaitForInput(int fd, std::chrono::milliseconds timeout) {
+	pollfd request = { fd, POLLIN, 0 };
+	int numReady = poll(&request, 1, int(timeout.count()));
+	if (numReady < 0) {
+		if (errno == EINTR) {
+			return WaitResult::Interrupted;
+		}
+		throw std::runtime_error(std::string("Failed to wait for the pipe: ") + strerror(errno));
+	}
+	return numReady > 0 ? WaitResult::Ready : WaitResult::Timeout;
+}
+
+
+// Bytes read, 0 at the end of the input. Reads interrupted before they got anything are to be retried.
+size_t ReadInput(int fd, uint8_t* buffer, size_t size, WaitResult& result) {
+	ssize_t numRead = read(fd, buffer, size);
+	result = WaitResult::Ready;
+	if (numRead < 0) {
+		if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+			result = WaitResult::Interrupted;
+			return 0;
+		}
+		throw std::runtime_error(std::string("Failed to read the pipe: ") + strerror(errno));
+	}
+	return size_t(numRead);
+}
+
+#endif
+
+} // namespace
+
+
+constexpr std::chrono::milliseconds PipeSource::StallTimeout;
+
+
+PipeSource::PipeSource()
+	: m_runThread(false),
+	m_isFinished(false),
+	m_writePosition(0),
+	m_readPosition(0),
+	m_captureOrigin(0),
+	m_numBytesRead(0),
+	m_numFramesRead(0),
+	m_numReads(0),
+	m_numShortReads(0),
+	m_numInputStalls(0),
+	m_numGraphStalls(0)
+{}
+
+
+PipeSource::~PipeSource() {
+	if (m_readThread.joinable()) {
+		m_runThread = false;
+		m_readThread.join();
+	}
+}
+
+
+void PipeSource::Start(int fd, SampleFormat format, size_t numChannels, int sampleRate, double bufferSeconds) {
+	if (m_readThread.joinable()) {
+		throw std::logic_error("The pipe is already being read.");
+	}
+	if (numChannels == 0 || sampleRate <= 0) {
+		throw std::invalid_argument("Pipes need at least one channel and a sample rate.");
+	}
+	CheckInput(fd);
+
+	m_format = format;
+	m_numChannels = numChannels;
+	m_frameSize = numChannels * exc::GetSampleSize(format);
+	m_buffer.resize(std::max(size_t(sampleRate * bufferSeconds), size_t(1)) * m_frameSize);
+	m_writePosition = 0;
+	m_readPosition = 0;
+	m_sampleRate = sampleRate;
+	m_numBytesRead = 0;
+	m_numFramesRead = 0;
+	m_numReads = 0;
+	m_numShortReads = 0;
+	m_numInputStalls = 0;
+	m_numGraphStalls = 0;
+	m_isFinished = false;
+	m_startTime = std::chrono::steady_clock::now();
+	m_captureOrigin = 0;
+	m_sourcePosition = 0;
+
+	std::promise<void> result;
+	m_threadResult = result.get_future();
+	m_runThread = true;
+	m_readThread = std::thread([this, fd, result = std::move(result)]() mutable {
+		try {
+			ReadThread(fd);
+			result.set_value();
+		}
+		catch (...) {
+			result.set_exception(std::current_exception());
+		}
+		m_isFinished = true;
+	});
+}
+
+
+void PipeSource::Stop() {
+	if (m_readThread.joinable()) {
+		m_runThread = false;
+		m_readThread.join();
+		m_threadResult.get();
+	}
+}
+
+
+void PipeSource::Update() {
+	// only set outputs that changed, so that lazy executors can skip the nodes downstream
+	if (m_sampleRate != m_lastSampleRate) {
+		GetOutput<0>().Set(m_sampleRate);
+		m_lastSampleRate = m_sampleRate;
+	}
+
+	// convert the whole frames the read thread has stored straight into the stream, in two runs if they wrap around
+	size_t numFrames = GetNumReadableFrames();
+	if (numFrames == 0) {
+		return;
+	}
+	uint64_t consumed = m_readPosition.load(std::memory_order_relaxed);
+	size_t index = size_t(consumed % m_buffer.size());
+	size_t numFirst = std::min(numFrames, (m_buffer.size() - index) / m_frameSize);
+
+	m_writer.SetNumChannels(m_numChannels);
+	m_writer.BeginBlock(numFrames);
+	m_channels.resize(m_numChannels);
+	for (size_t channel = 0; channel < m_numChannels; ++channel) {
+		m_channels[channel] = m_writer.GetBlock(channel);
+	}
+	exc::Deinterleave(m_buffer.data() + index, m_format, m_numChannels, numFirst, m_channels.data());
+	if (numFirst < numFrames) {
+		for (auto& channel : m_channels) {
+			channel += numFirst;
+		}
+		exc::Deinterleave(m_buffer.data(), m_format, m_numChannels, numFrames - numFirst, m_channels.data());
+	}
+	m_readPosition.store(consumed + numFrames * m_frameSize, std::memory_order_release);
+	m_numFramesRead += numFrames;
+
+	// the origin may already come from a later read, that only refines the estimate
+	exc::StreamTimestamp timestamp;
+	timestamp.sourcePosition = m_sourcePosition;
+	timestamp.sourceRate = m_sampleRate;
+	timestamp.sourceOrigin = exc::StreamTimestamp::Clock::time_point(exc::StreamTimestamp::Clock::duration(m_captureOrigin.load()));
+	m_writer.SetTimestamp(timestamp);
+	m_sourcePosition += int64_t(numFrames);
+	GetOutput<1>().Set(m_writer.EndBlock());
+}
+
+
+double PipeSource::GetThroughput() const {
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_startTime;
+	return elapsed.count() > 0.0 ? m_numFramesRead / elapsed.count() : 0.0;
+}
+
+
+void PipeSource::ReadThread(int fd) {
+	const size_t capacity = m_buffer.size();
+	bool isEndOfInput = false;
+
+	while (m_runThread && !isEndOfInput) {
+		// read into the free space up to the end of the ring, the rest of a long read wraps around on the next call
+		uint64_t written = m_writePosition.load(std::memory_order_relaxed);
+		uint64_t consumed = m_readPosition.load(std::memory_order_acquire);
+		size_t index = size_t(written % capacity);
+		size_t numRequested = std::min(capacity - size_t(written - consumed), capacity - index);
+		if (numRequested == 0) {
+			// the graph is behind, leave the rest in the pipe
+			++m_numGraphStalls;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+
+		// wait with a timeout, so a quiet pipe doesn't keep Stop() waiting
+		WaitResult result = WaitForInput(fd, StallTimeout);
+		if (result == WaitResult::Timeout) {
+			++m_numInputStalls;
+		}
+		if (result != WaitResult::Ready) {
+			continue;
+		}
+
+		size_t numRead = ReadInput(fd, m_buffer.data() + index, numRequested, result);
+		auto readTime = std::chrono::steady_clock::now();
+		if (result != WaitResult::Ready) {
+			continue;
+		}
+		++m_numReads;
+		if (numRead == 0) {
+			// the writer closed its end, a partial frame at the end is dropped
+			isEndOfInput = true;
+			continue;
+		}
+		if (numRead < numRequested) {
+			++m_numShortReads;
+		}
+		m_numBytesRead += uint64_t(numRead);
+
+		// the frames completed by this read arrived now
+		uint64_t numFrames = (written + uint64_t(numRead)) / m_frameSize;
+		if (numFrames > written / m_frameSize) {
+			m_captureOrigin = exc::StreamTimestamp::Captured(int64_t(numFrames - 1), m_sampleRate, readTime).sourceOrigin.time_since_epoch().count();
+		}
+		m_writePosition.store(written + uint64_t(numRead), std::memory_order_release);
+	}
+}
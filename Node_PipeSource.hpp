@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Graph_All.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+
+/// <summary>
+/// <para> Plays interleaved PCM read from a file descriptor: stdin, a pipe, a FIFO or a socket. </para>
+/// <para>
+/// A thread reads the descriptor straight into a ring of raw frames, and the graph converts every whole
+/// frame from the ring into its output stream on update, so each sample is converted and copied only once.
+/// Reads may return any number of bytes, a frame split between two reads is completed by the next one.
+/// When the graph falls behind, the thread stops reading and lets the pipe fill, so the writer waits
+/// instead of losing samples.
+/// </para>
+/// <para>
+/// On Windows, the descriptor's handle is read with ReadFile, and pipes are peeked until data arrives, since they can't be polled.
+/// Consoles are rejected, their reads can't be timed out.
+/// </para>
+/// <para> Frames are timestamped as captured when the read that completed them returned. </para>
+/// </summary>
+class PipeSource
+	: public exc::InputPortConfig<>,
+	// sample rate, channel samples
+	public exc::OutputPortConfig<int, exc::StreamChunk>
+{
+public:
+	using SampleFormat = exc::SampleFormat;
+public:
+	PipeSource();
+	~PipeSource();
+
+	/// <summary> Start reading on a thread. The descriptor stays open, it's still the caller's. </summary>
+	/// <param name="bufferSeconds"> Length of the ring the graph reads from. </param>
+	/// <exception cref="std::invalid_argument"> No channels or no sample rate, or the descriptor is a Windows console. </exception>
+	/// <exception cref="std::logic_error"> Already started. </exception>
+	void Start(int fd, SampleFormat format, size_t numChannels, int sampleRate, double bufferSeconds = 1.0);
+	/// <summary> Stop reading and wait for the thread. </summary>
+	/// <exception cref="std::runtime_error"> Reading the descriptor failed. </exception>
+	void Stop();
+	/// <summary> The writer closed its end or reading failed, and the graph got all frames that were read. </summary>
+	bool IsEndOfStream() const { return m_isFinished && GetNumReadableFrames() == 0; }
+
+	void Notify(exc::InputPortBase* sender) override {}
+	void Update() override;
+
+	/// <summary> Bytes read from the descriptor since Start(). </summary>
+	uint64_t GetNumBytesRead() const { return m_numBytesRead; }
+	/// <summary> Frames handed to the graph since Start(). </summary>
+	uint64_t GetNumFramesRead() const { return m_numFramesRead; }
+	/// <summary> Average frames per second since Start(). </summary>
+	double GetThroughput() const;
+	/// <summary> Number of read calls, and how many of them returned less than asked for. </summary>
+	uint64_t GetNumReads() const { return m_numReads; }
+	uint64_t GetNumShortReads() const { return m_numShortReads; }
+	/// <summary> Number of times nothing arrived on the descriptor for StallTimeout. </summary>
+	uint64_t GetNumInputStalls() const { return m_numInputStalls; }
+	/// <summary> Number of times the reader had to wait because the graph did not empty the ring. </summary>
+	uint64_t GetNumGraphStalls() const { return m_numGraphStalls; }
+
+	static constexpr std::chrono::milliseconds StallTimeout{ 100 };
+protected:
+	void ReadThread(int fd);
+	size_t GetNumReadableFrames() const { return size_t(m_writePosition.load(std::memory_order_acquire) - m_readPosition.load(std::memory_order_relaxed)) / m_frameSize; }
+
+protected:
+	std::thread m_readThread;
+	std::atomic_bool m_runThread;
+	std::atomic_bool m_isFinished;
+	std::future<void> m_threadResult;
+	exc::StreamWriter m_writer;
+	std::vector<float*> m_channels;
+	// raw frames, a whole number of them so that no frame wraps around the end
+	std::vector<uint8_t> m_buffer;
+	alignas(64) std::atomic<uint64_t> m_writePosition;
+	alignas(64) std::atomic<uint64_t> m_readPosition;
+	SampleFormat m_format = SampleFormat::Int16;
+	size_t m_numChannels = 0;
+	size_t m_frameSize = 1;
+	int m_sampleRate = 0;
+	int m_lastSampleRate = -1;
+	std::chrono::steady_clock::time_point m_startTime;
+	// when frame 0 would have arrived, in clock ticks, so the graph can stamp the frames it takes from the ring
+	std::atomic<int64_t> m_captureOrigin;
+	int64_t m_sourcePosition = 0;
+
+	std::atomic<uint64_t> m_numBytesRead;
+	std::atomic<uint64_t> m_numFramesRead;
+	std::atomic<uint64_t> m_numReads;
+	std::atomic<uint64_t> m_numShortReads;
+	std::atomic<uint64_t> m_numInputStalls;
+	std::atomic<uint64_t> m_numGraphStalls;
+};
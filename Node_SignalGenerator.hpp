@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Graph_All.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+
+/// <summary>
+/// Synthetic stereo music: a bass line, a chord, a kick drum on every beat and a bit of noise.
+/// Every update produces a fixed number of samples, the same sequence on every run.
+/// </summary>
+class SignalGenerator
+	: public exc::InputPortConfig<>,
+	// sample rate, channel samples
+	public exc::OutputPortConfig<int, exc::StreamChunk>
+{
+public:
+	explicit SignalGenerator(int sampleRate = 44100, size_t samplesPerUpdate = 441)
+		: m_writer(2), m_sampleRate(sampleRate), m_samplesPerUpdate(samplesPerUpdate)
+	{}
+
+	void Notify(exc::InputPortBase* sender) override {}
+	void Update() override {
+		constexpr double pi = 3.1415926535897932384626;
+		const double beatPeriod = 0.5;
+
+		m_writer.BeginBlock(m_samplesPerUpdate);
+		for (size_t i = 0; i < m_samplesPerUpdate; ++i) {
+			double t = double(m_position + i) / m_sampleRate;
+			double sinceBeat = std::fmod(t, beatPeriod);
+
+			double kick = std::exp(-sinceBeat * 30.0) * std::sin(2 * pi * (50.0 * sinceBeat + 40.0 * (1.0 - std::exp(-sinceBeat * 20.0)) / 20.0));
+			double bass = 0.3 * std::sin(2 * pi * 55.0 * t);
+			double chord = 0.1 * (std::sin(2 * pi * 220.0 * t) + std::sin(2 * pi * 277.2 * t) + std::sin(2 * pi * 329.6 * t));
+
+			m_noise = m_noise * 1664525u + 1013904223u;
+			double noise = 0.02 * (double(m_noise >> 8) / double(1u << 24) - 0.5);
+
+			m_writer.Write(0, i, float(0.5 * (kick + bass + chord) + noise));
+			m_writer.Write(1, i, float(0.5 * (kick + bass - chord) - noise));
+		}
+		int64_t newest = int64_t(m_position + m_samplesPerUpdate - 1);
+		m_writer.SetTimestamp(exc::StreamTimestamp::Captured(newest, m_sampleRate, exc::StreamTimestamp::Clock::now()).Advanced(1 - int64_t(m_samplesPerUpdate)));
+		m_position += m_samplesPerUpdate;
+
+		GetOutput<0>().Set(m_sampleRate);
+		GetOutput<1>().Set(m_writer.EndBlock());
+	}
+private:
+	exc::StreamWriter m_writer;
+	int m_sampleRate;
+	size_t m_samplesPerUpdate;
+	uint64_t m_position = 0;
+	uint32_t m_noise = 1;
+};
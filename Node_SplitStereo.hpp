@@ -2,36 +2,50 @@
 
 #include "Graph_All.hpp"
 
+#include <cstring>
 #include <vector>
 
 
 class SplitStereo
-	// sample rate, channel samples
-	: public exc::InputPortConfig<std::vector<std::vector<float>>>,
-	// sample rate, channel samples
-	public exc::OutputPortConfig<std::vector<float>, std::vector<float>>
+	// channel samples
+	: public exc::InputPortConfig<exc::StreamChunk>,
+	// left samples, right samples
+	public exc::OutputPortConfig<exc::StreamChunk, exc::StreamChunk>,
+	public exc::FusableNode
 {
 public:
 	void Notify(exc::InputPortBase* sender) override {}
 	void Update() override {
-		std::vector<std::vector<float>> channels = GetInput<0>().Get();
+		exc::StreamWindow window = m_reader.Read(GetInput<0>().Get());
+		if (window.IsEmpty()) {
+			return;
+		}
 
-		std::vector<float> left;
-		std::vector<float> right;
+		size_t right = window.GetNumChannels() > 1 ? 1 : 0;
+		m_left.SetTimestamp(window.GetTimestamp());
+		m_right.SetTimestamp(window.GetTimestamp());
+		GetOutput<0>().Set(m_left.Write(window.GetSamples(0), window.GetNumSamples()));
+		GetOutput<1>().Set(m_right.Write(window.GetSamples(right), window.GetNumSamples()));
+	}
 
-		if (channels.size() > 0) {
-			left = channels[0];
-		}
-		if (channels.size() > 1) {
-			right = channels[1];
-		}
-		else {
-			right = left;
-		}
+	exc::RateRatio GetRateRatio() const override { return {}; }
+	void SetBlockSize(size_t numInputSamples) override {}
 
-		GetOutput<0>().Set(left);
-		GetOutput<1>().Set(right);		
+	size_t GetKernelInput() const override { return 0; }
+	void BeginKernel(size_t numInputChannels) override { m_rightChannel = numInputChannels > 1 ? 1 : 0; }
+	exc::StreamWindow ReadKernelInput() override { return m_reader.Read(GetInput<0>().Get()); }
+	size_t GetKernelHistory() const override { return 0; }
+	size_t GetNumKernelOutputs() const override { return 2; }
+	exc::KernelOutput GetKernelOutput(size_t index) const override { return { index, 1 }; }
+	exc::StreamWriter& GetKernelWriter(size_t index) override { return index == 0 ? m_left : m_right; }
+	size_t RunKernel(const float* const* input, size_t numSamples, float* const* output) override {
+		memcpy(output[0], input[0], sizeof(float)*numSamples);
+		memcpy(output[1], input[m_rightChannel], sizeof(float)*numSamples);
+		return numSamples;
 	}
 private:
-	std::vector<float> m_values;
-};
\ No newline at end of file
+	exc::StreamReader m_reader;
+	exc::StreamWriter m_left;
+	exc::StreamWriter m_right;
+	size_t m_rightChannel = 1;
+};
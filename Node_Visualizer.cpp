@@ -134,16 +134,20 @@ void Visualizer::Update() {
 
 	// Get input data
 	auto sampleRate = GetInput<0>().Get();
-	auto fft = GetInput<1>().Get();
-	auto wavelet = GetInput<2>().Get();
-	auto beats = GetInput<3>().Get();
+	const auto& fft = GetInput<1>().Get();
 
 	int fftSize = fft.size();
 
+	// The spectrogram shows the wavelet history straight from the stream
+	int historySize = 2 * sampleRate;
+	m_waveletReader.SetHistory(historySize);
+	exc::StreamWindow wavelet = m_waveletReader.Read(GetInput<2>().Get());
+	int numWaveletChannels = wavelet.IsEmpty() ? m_numWaveletChannels : (int)wavelet.GetNumChannels();
+	exc::StreamWindow beats = m_beatReader.Read(GetInput<3>().Get());
+	int numBeatTracks = beats.IsEmpty() ? m_numBeatTracks : (int)beats.GetNumChannels();
 
 	// Update internal resource to accept input data
-	int historySize = 2 * sampleRate;
-	UpdateDataResources(historySize, fft.size(), wavelet.size(), beats.size());
+	UpdateDataResources(historySize, fft.size(), numWaveletChannels, numBeatTracks);
 
 	if (m_numBeatTracks == 0 || m_numWaveletChannels == 0 || m_numFFtBins == 0) {
 		HRESULT presentHr = m_swapChain->Present(1, 0);
@@ -155,11 +159,8 @@ void Visualizer::Update() {
 
 
 	// Copy input data to internal history buffers
-	for (int i = 0; i < m_beatHistories.size(); ++i) {
-		m_beatHistories[i].AddSamples(beats[i].data(), beats[i].size());
-	}
-	for (int i = 0; i < m_waveletHistories.size(); ++i) {
-		m_waveletHistories[i].AddSamples(wavelet[i].data(), wavelet[i].size());
+	for (int i = 0; i < m_beatHistories.size() && !beats.IsEmpty(); ++i) {
+		m_beatHistories[i].AddSamples(beats.GetSamples(i), beats.GetNumSamples());
 	}
 
 	// Upload input data to GPU buffers
@@ -175,13 +176,13 @@ void Visualizer::Update() {
 
 		m_context->Unmap(m_beatTexture.Get(), 0);
 	}
-	{
+	if (!wavelet.IsEmpty()) {
 		D3D11_MAPPED_SUBRESOURCE mapinfo;
 		m_context->Map(m_waveletTexture.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapinfo);
 
-		for (int i = 0; i < m_waveletHistories.size(); ++i) {
-			void* srcData = m_waveletHistories[i].GetSamples();
-			UINT srcSize = m_waveletHistories[i].GetSize() * sizeof(float);
+		for (int i = 0; i < m_numWaveletChannels; ++i) {
+			const void* srcData = wavelet.GetChannel(i) + wavelet.GetNumSamples();
+			UINT srcSize = m_spectroHistorySize * sizeof(float);
 			memcpy((char*)mapinfo.pData + mapinfo.RowPitch*i, srcData, std::min(srcSize, mapinfo.RowPitch));
 		}
 
@@ -191,8 +192,10 @@ void Visualizer::Update() {
 		D3D11_MAPPED_SUBRESOURCE mapinfo;
 		m_context->Map(m_fftTexture.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapinfo);
 
-		std::vector<float> amplitude(fftSize);
-		std::vector<float> graph(fftSize);
+		std::vector<float>& amplitude = m_fftAmplitude;
+		std::vector<float>& graph = m_fftGraph;
+		amplitude.resize(fftSize);
+		graph.resize(fftSize);
 		float scaler = 1.0f / fftSize;
 		for (int i = 0; i < fftSize; ++i) {
 			amplitude[i] = std::abs(fft[i]) * scaler;
@@ -239,7 +242,7 @@ void Visualizer::Update() {
 	spectroColor.mid = { 0.5f, 0.5f, 0.5f };
 	spectroColor.max = { 1, 1, 1 };
 
-	DrawSpectrogram(m_waveletHistories.size(), m_waveletHistories[0].GetSize(), m_waveletTextureView.Get(), spectroColor, { 0.4, 0.6, 0.6 }, true, true, 0.5f, 0.3f, 20.0f);
+	DrawSpectrogram(m_numWaveletChannels, m_spectroHistorySize, m_waveletTextureView.Get(), spectroColor, { 0.4, 0.6, 0.6 }, true, true, 0.5f, 0.3f, 20.0f);
 
 	DrawSpectrogram(1, m_numFFtBins, m_fftTextureView.Get(), spectroColor, { 0.2, 1.0, 1.0 }, false, true, 0.4f, 0.8f, 0.5f);
 
@@ -416,12 +419,6 @@ void Visualizer::UpdateDataResources(int historySize, int numFftBins, int numWav
 			throw std::runtime_error("Failed to create textures and views.");
 		}
 	}
-	if (m_waveletHistories.size() != numWaveletChannels) {
-		m_waveletHistories.resize(numWaveletChannels);
-		for (auto& v : m_waveletHistories) {
-			v.SetSize(m_spectroHistorySize);
-		}
-	}
 
 	if (m_numFFtBins != numFftBins) {
 		D3D11_TEXTURE2D_DESC desc;
@@ -17,7 +17,7 @@
 
 class Visualizer
 	// sample rate, fft, wavelet, beats
-	: public exc::InputPortConfig<int, std::vector<std::complex<float>>, std::vector<std::vector<float>>, std::vector<std::vector<float>>>,
+	: public exc::InputPortConfig<int, std::vector<std::complex<float>>, exc::StreamChunk, exc::StreamChunk>,
 	public exc::OutputPortConfig<>
 {
 public:
@@ -48,13 +48,16 @@ private:
 	Microsoft::WRL::ComPtr<ID3D11Texture2D> m_beatTexture;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_beatTextureView;
 	std::vector<ConvolutionBuffer> m_beatHistories;
+	exc::StreamReader m_beatReader;
 
 	Microsoft::WRL::ComPtr<ID3D11Texture2D> m_waveletTexture;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_waveletTextureView;
-	std::vector<ConvolutionBuffer> m_waveletHistories;
+	exc::StreamReader m_waveletReader;
 
 	Microsoft::WRL::ComPtr<ID3D11Texture2D> m_fftTexture;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_fftTextureView;
+	std::vector<float> m_fftAmplitude;
+	std::vector<float> m_fftGraph;
 
 	Microsoft::WRL::ComPtr<ID3D11PixelShader> m_psSpectrogram;
 	Microsoft::WRL::ComPtr<ID3D11VertexShader> m_vsQuad;
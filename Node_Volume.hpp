@@ -15,8 +15,11 @@ public:
 	void Notify(exc::InputPortBase* sender) override {}
 	void Update() override {
 		int inputSampleRate = GetInput<0>().Get();
-		std::vector<std::vector<float>> samples = GetInput<1>().Get();
+		const std::vector<std::vector<float>>& input = GetInput<1>().Get();
 
+		// copy assignment keeps the capacity of the channels, so the output allocates only when it grows
+		std::vector<std::vector<float>>& samples = m_samples;
+		samples = input;
 		if (samples.size() != m_values.size()) {
 			m_values.resize(samples.size(), 0.0f);
 		}
@@ -37,4 +40,5 @@ public:
 
 private:
 	std::vector<float> m_values;
+	std::vector<std::vector<float>> m_samples;
 };
\ No newline at end of file
@@ -4,81 +4,117 @@
 #include <complex>
 #include <cassert>
 #include <algorithm>
+#include <stdexcept>
+#include <string>
 
 
 void Wavelet::Update() {
-	int sampleRate = GetInput<0>().Get();
-	if (sampleRate != m_sampleRate) {
-		m_sampleRate = sampleRate;
-		RecalcWavelets();
+	BeginKernel(GetInput<1>().Get().GetNumChannels());
+	exc::StreamWindow window = ReadKernelInput();
+	if (window.IsEmpty()) {
+		return;
 	}
+	size_t numSamples = window.GetNumSamples();
+	size_t numChannels = m_tables->reals.size();
 
-	int downsample = 1;
-	std::vector<float> samples = GetInput<1>().Get();
-	if (samples.size() == 0) {
-		GetOutput<0>().Set(sampleRate / downsample);
-		GetOutput<1>().Set(std::vector<std::vector<float>>(m_waveletReals.size()));
-		return;
+	m_outSamples.resize(numChannels * numSamples);
+	m_outChannels.resize(numChannels);
+	for (size_t channel = 0; channel < numChannels; ++channel) {
+		m_outChannels[channel] = m_outSamples.data() + channel * numSamples;
 	}
+	size_t count = RunKernel(window.GetChannels(), numSamples, m_outChannels.data());
 
-	int delay = 0;
+	m_writer.BeginBlock(count);
+	m_writer.SetTimestamp(GetKernelTimestamp(window.GetTimestamp()));
+	for (size_t channel = 0; channel < numChannels; ++channel) {
+		m_writer.Write(channel, m_outChannels[channel]);
+	}
+	GetOutput<1>().Set(m_writer.EndBlock());
+}
 
-	// prepare working set
-	m_workingSet.resize(m_buffer.GetSize() + samples.size());
-	memcpy(m_workingSet.data(), m_buffer.GetSamples(), m_buffer.GetSize() * sizeof(float));
-	memcpy(m_workingSet.data() + m_buffer.GetSize(), samples.data(), samples.size() * sizeof(float));
-	m_buffer.AddSamples(samples.data(), samples.size());
 
-	// calculate wavelet coefficients
-	std::vector<std::vector<float>> results;
-	std::vector<float> signalBuffer(m_workingSet.size());
+void Wavelet::SetBlockSize(size_t numInputSamples) {
+	m_outSamples.reserve(m_tables->bands.size() * numInputSamples);
+	m_outChannels.reserve(m_tables->bands.size());
+}
+
+
+void Wavelet::BeginKernel(size_t numInputChannels) {
+	int sampleRate = GetInput<0>().Get();
+	if (sampleRate != m_tables->sampleRate) {
+		// a new input rate has to be adapted to here, but tables swapped in for the wrong rate would be a stall on every swap
+		if (sampleRate == m_lastSampleRate) {
+			throw std::logic_error("The wavelet's tables are made for " + std::to_string(m_tables->sampleRate)
+				+ " Hz, but its input runs at " + std::to_string(sampleRate) + " Hz.");
+		}
+		std::shared_ptr<const Tables> tables = PrepareTables(m_tables->bands, sampleRate);
+		SwapTables(tables);
+	}
+	m_lastSampleRate = sampleRate;
+	GetOutput<0>().Set(sampleRate);
+	m_writer.SetNumChannels(m_tables->reals.size());
+}
 
-	int downsampledCount = (samples.size() + downsample - 1) / downsample;
-	for (size_t channel = 0; channel < m_waveletReals.size(); ++channel) {
-		std::vector<float> result(downsampledCount);
 
-		for (size_t sample = 0; sample < samples.size(); sample += downsample) {
+exc::StreamWindow Wavelet::ReadKernelInput() {
+	return m_reader.Read(GetInput<1>().Get());
+}
+
+
+exc::StreamTimestamp Wavelet::GetKernelTimestamp(const exc::StreamTimestamp& input) const {
+	// the delays centre every band on the middle of the longest wavelet
+	return input.Advanced(-int64_t(m_tables->maxWaveLen - 1) / 2);
+}
+
+
+size_t Wavelet::RunKernel(const float* const* input, size_t numSamples, float* const* output) {
+	// calculate wavelet coefficients
+	const Tables& tables = *m_tables;
+	for (size_t channel = 0; channel < tables.reals.size(); ++channel) {
+		for (size_t sample = 0; sample < numSamples; ++sample) {
 			std::complex<float> c;
 
-			float* w_re = m_waveletReals[channel].data();
-			float* w_im = m_waveletImags[channel].data();
-			size_t dim = m_waveletReals[channel].size();
-			float* signal = m_workingSet.data() + m_delays[channel] + 1 + sample;
-			memcpy(signalBuffer.data(), signal, sizeof(float)*dim);
+			const float* w_re = tables.reals[channel].data();
+			const float* w_im = tables.imags[channel].data();
+			size_t dim = tables.reals[channel].size();
+			const float* signal = input[0] + tables.delays[channel] + 1 + sample;
 
-			c.real(ScalarProduct(w_re, signalBuffer.data(), dim));
-			c.imag(ScalarProduct(w_im, signalBuffer.data(), dim));
+			c.real(ScalarProduct(w_re, signal, dim));
+			c.imag(ScalarProduct(w_im, signal, dim));
 
-			result[sample / downsample] = std::abs(c);
+			output[channel][sample] = std::abs(c);
 		}
-		results.push_back(result);
 	}
-	
-	GetOutput<0>().Set(sampleRate / downsample);
-	GetOutput<1>().Set(results);
+	return numSamples;
 }
 
 void Wavelet::SetBands(int numBands, float* frequencies, float* lengths) {
-	m_bands.clear();
+	std::vector<Band> bands;
 	for (int i = 0; i < numBands; ++i) {
-		m_bands.push_back({ frequencies[i], lengths[i] });
+		bands.push_back({ frequencies[i], lengths[i] });
 	}
-	RecalcWavelets();
+	std::shared_ptr<const Tables> tables = PrepareTables(std::move(bands), m_tables->sampleRate);
+	SwapTables(tables);
 }
 
-void Wavelet::RecalcWavelets() {
-	m_waveletReals.clear();
-	m_waveletImags.clear();
 
-	if (m_sampleRate == 0) {
-		m_waveletReals.resize(m_bands.size(), { 1.0f });
-		m_waveletImags.resize(m_bands.size(), { 0.0f });
-		return;
+auto Wavelet::PrepareTables(std::vector<Band> bands, int sampleRate) -> std::shared_ptr<const Tables> {
+	auto prepared = std::make_shared<Tables>();
+	Tables& tables = *prepared;
+	tables.bands = std::move(bands);
+	tables.sampleRate = sampleRate;
+
+	if (sampleRate == 0) {
+		tables.reals.resize(tables.bands.size(), { 1.0f });
+		tables.imags.resize(tables.bands.size(), { 0.0f });
+		tables.delays.assign(tables.bands.size(), 0);
+		tables.maxWaveLen = 1;
+		return prepared;
 	}
 
 	size_t maxWaveLen = 0;
-	for (int i = 0; i < m_bands.size(); ++i) {
-		std::vector<std::complex<float>> coeffs = MorletWavelet(m_bands[i].frequency, m_bands[i].length, m_sampleRate);
+	for (int i = 0; i < tables.bands.size(); ++i) {
+		std::vector<std::complex<float>> coeffs = MorletWavelet(tables.bands[i].frequency, tables.bands[i].length, sampleRate);
 		std::vector<float> reals, imags;
 		reals.resize(coeffs.size());
 		imags.resize(coeffs.size());
@@ -86,17 +122,24 @@ void Wavelet::RecalcWavelets() {
 			reals[j] = coeffs[j].real();
 			imags[j] = coeffs[j].imag();
 		}
-		m_waveletReals.push_back(reals);
-		m_waveletImags.push_back(imags);
-		maxWaveLen = std::max(maxWaveLen, m_waveletReals.back().size());
+		tables.reals.push_back(reals);
+		tables.imags.push_back(imags);
+		maxWaveLen = std::max(maxWaveLen, tables.reals.back().size());
 	}
 
-	m_delays.resize(m_bands.size());
-	for (int i = 0; i < m_bands.size(); ++i) {
-		m_delays[i] = (maxWaveLen - m_waveletReals[i].size()) / 2;
+	tables.delays.resize(tables.bands.size());
+	for (int i = 0; i < tables.bands.size(); ++i) {
+		tables.delays[i] = (maxWaveLen - tables.reals[i].size()) / 2;
 	}
 
-	m_buffer.SetSize(maxWaveLen);
+	tables.maxWaveLen = maxWaveLen;
+	return prepared;
+}
+
+
+void Wavelet::SwapTables(std::shared_ptr<const Tables>& tables) {
+	std::swap(m_tables, tables);
+	m_reader.SetHistory(m_tables->maxWaveLen);
 }
 
 
@@ -124,7 +167,7 @@ std::vector<std::complex<float>> Wavelet::MorletWavelet(float frequency, float l
 	double sum = 0.0f;
 	for (int i = firstTap; i <= lastTap; ++i) {
 		float x = samplePeriod * i;
-		std::complex<float> c = exp(-x*x / varianceSquared) * exp(1if * (frequency * 2.0f * pi * x));
+		std::complex<float> c = std::exp(-x*x / varianceSquared) * exp(1if * (frequency * 2.0f * pi * x));
 		sum += abs(c);
 		coefficients[i - firstTap] = c;
 	}
@@ -2,36 +2,72 @@
 
 #include "Graph_All.hpp"
 
-#include "ConvolutionBuffer.hpp"
-
 #include <vector>
 #include <complex>
+#include <memory>
 
 
 
 class Wavelet
 	// sample rate, samples
-	: public exc::InputPortConfig<int, std::vector<float>>,
-	// sample rate, wavelet amplitudes
-	public exc::OutputPortConfig<int, std::vector<std::vector<float>>>
+	: public exc::InputPortConfig<int, exc::StreamChunk>,
+	// sample rate, wavelet amplitudes, one channel per band
+	public exc::OutputPortConfig<int, exc::StreamChunk>,
+	public exc::FusableNode
 {
+public:
+	struct Band {
+		float frequency, length;
+	};
+
+	/// <summary> The filter bank of a set of bands at a sample rate. It takes a while to compute,
+	///		so it can be prepared on another thread, then swapped in between updates.
+	///		Prepared tables never change, any number of nodes on any threads can share them. </summary>
+	struct Tables {
+		std::vector<Band> bands;
+		int sampleRate = 0;
+		std::vector<std::vector<float>> reals;
+		std::vector<std::vector<float>> imags;
+		std::vector<int> delays;
+		size_t maxWaveLen = 1;
+	};
 public:
 	void Notify(exc::InputPortBase* sender) override {}
 	void Update() override;
 	void SetBands(int numBands, float* frequencies, float* lengths);
+
+	/// <summary> Compute the filter bank. Doesn't touch any node, safe to call from any thread. </summary>
+	static std::shared_ptr<const Tables> PrepareTables(std::vector<Band> bands, int sampleRate);
+	/// <summary> Exchange the filter bank with the one in use. Swapping again restores the previous one.
+	///		Prepare the tables for GetSampleRate(), the rate of the input. Only a change of the input rate
+	///		recomputes them on the update, tables swapped in for another rate make the next update throw std::logic_error. </summary>
+	void SwapTables(std::shared_ptr<const Tables>& tables);
+	/// <summary> The filter bank in use. </summary>
+	const std::shared_ptr<const Tables>& GetTables() const { return m_tables; }
+	/// <summary> The bands in use. </summary>
+	const std::vector<Band>& GetBands() const { return m_tables->bands; }
+	/// <summary> The sample rate the filter bank in use was made for. </summary>
+	int GetSampleRate() const { return m_tables->sampleRate; }
+
+	exc::RateRatio GetRateRatio() const override { return {}; }
+	void SetBlockSize(size_t numInputSamples) override;
+
+	size_t GetKernelInput() const override { return 1; }
+	void BeginKernel(size_t numInputChannels) override;
+	exc::StreamWindow ReadKernelInput() override;
+	size_t GetKernelHistory() const override { return m_tables->maxWaveLen; }
+	size_t GetNumKernelOutputs() const override { return 1; }
+	exc::KernelOutput GetKernelOutput(size_t index) const override { return { 1, m_tables->reals.size() }; }
+	exc::StreamWriter& GetKernelWriter(size_t index) override { return m_writer; }
+	exc::StreamTimestamp GetKernelTimestamp(const exc::StreamTimestamp& input) const override;
+	size_t RunKernel(const float* const* input, size_t numSamples, float* const* output) override;
 private:
 	static std::vector<std::complex<float>> MorletWavelet(float frequency, float length, int sampleRate);
-	void RecalcWavelets();
-	
-	struct Band {
-		float frequency, length;
-	};
 private:
-	std::vector<std::vector<float>> m_waveletReals;
-	std::vector<std::vector<float>> m_waveletImags;
-	std::vector<int> m_delays;
-	std::vector<Band> m_bands;
-	int m_sampleRate = 0;
-	ConvolutionBuffer m_buffer;
-	std::vector<float> m_workingSet;
+	std::shared_ptr<const Tables> m_tables = std::make_shared<Tables>();
+	int m_lastSampleRate = -1;
+	exc::StreamReader m_reader;
+	exc::StreamWriter m_writer;
+	std::vector<float> m_outSamples;
+	std::vector<float*> m_outChannels;
 };
\ No newline at end of file
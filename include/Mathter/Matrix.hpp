@@ -189,7 +189,8 @@ public:
 
 		// If *this and rhs reference the same matrix, aliasing must be resolved.
 		if ((void*)&mat == (void*)&rhs.mat) {
-			Matrix<typename impl::MatrixProperties<MatrixU>::Type, SRows, SColumns> tmpmat;
+			using PropsU = impl::MatrixProperties<MatrixU>;
+			Matrix<typename PropsU::Type, SRows, SColumns, PropsU::Order, PropsU::Layout, PropsU::Packed> tmpmat;
 			tmpmat = rhs;
 			operator=(tmpmat);
 		}
@@ -943,8 +944,8 @@ public:
 	}
 
 	// From vector if applicable (for 1*N and N*1 matrices)
-	template <class U, bool Packed, class = typename std::enable_if<std::min(Rows, Columns) == 1>::type>
-	explicit Matrix(const Vector<U, std::max(Rows, Columns), Packed>& v){
+	template <class U, bool PackedU, class = typename std::enable_if<std::min(Rows, Columns) == 1 && sizeof(U) != 0>::type>
+	explicit Matrix(const Vector<U, std::max(Rows, Columns), PackedU>& v){
 		for (int i = 0; i < v.Dimension(); ++i) {
 			(*this)(i) = v(i);
 		}
@@ -1004,9 +1005,9 @@ public:
 	}
 
 	// Conversion to vector if applicable
-	template <class U, bool Packed, class = typename std::enable_if<std::min(Rows, Columns) == 1>::type>
-	explicit operator Vector<U, std::max(Rows, Columns), Packed>() const {
-		Vector<U, std::max(Rows, Columns), Packed> v;
+	template <class U, bool PackedU, class = typename std::enable_if<std::min(Rows, Columns) == 1 && sizeof(U) != 0>::type>
+	explicit operator Vector<U, std::max(Rows, Columns), PackedU>() const {
+		Vector<U, std::max(Rows, Columns), PackedU> v;
 		int k = 0;
 		for (int i = 0; i < Rows; ++i) {
 			for (int j = 0; j < Columns; ++j) {
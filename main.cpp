@@ -1,22 +1,41 @@
-#include "Node_LoopbackSource.hpp"
+#include "BatchAnalyzer.hpp"
 #include "Node_Volume.hpp"
-#include "Node_VolumeDisplay.hpp"
 #include "Node_Wavelet.hpp"
 #include "Node_SplitStereo.hpp"
 #include "Node_BeatFinder.hpp"
 #include "Node_DownSample.hpp"
-#include "Node_BarDisplay.hpp"
 #include "Node_FFT.hpp"
+#include "Node_LatencyProbe.hpp"
+#include "Node_PipeSource.hpp"
+#include "Node_SignalGenerator.hpp"
 
+#ifdef _WIN32
+#include "Node_LoopbackSource.hpp"
+#include "Node_VolumeDisplay.hpp"
+#include "Node_BarDisplay.hpp"
+#include "Node_Visualizer.hpp"
 #include "ScopeGuard.hpp"
+#else
+#include <unistd.h>
+#endif
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 #include <iostream>
+#include <fstream>
 #include <csignal>
-#include "Node_Visualizer.hpp"
+#include <cstdio>
 
 
+#ifdef _WIN32
 using Microsoft::WRL::ComPtr;
 
 
@@ -24,94 +43,456 @@ std::atomic_bool run = true;
 void InterruptSignalHandler(int signal) {
 	run = false;
 }
+#endif
 
-int main() {
-	try {
-		if (FAILED(CoInitializeEx(NULL, COINIT_MULTITHREADED))) {
-			throw std::runtime_error("CoInitialize failed.");
-		}
-		auto coUninitialize = MakeScopeGuard([] {CoUninitialize(); });
 
-		std::signal(SIGINT, InterruptSignalHandler);
+// The wavelet and beat detection part of the graph, the same in the live and the offline mode.
+void LinkAnalysis(exc::NodeBase& source, SplitStereo& split, DownSample& decimate, Wavelet& wavelet, BeatFinder& beatFinder) {
+	//float freqs[] = { 40, 55, 75, 95, 120, 165, 180, 205, 235, 265 };
+	//float lengths[] = { 0.12, 0.10, 0.09, 0.08, 0.07, 0.12, 0.10, 0.06, 0.05, 0.05 };
+	float freqs[] = { 40, 55, 70, 85, 105, 125, 145, 155, 180, 200, 225, 250, 275, 300 };
+	float lengths[] = { 0.12, 0.10, 0.10, 0.10, 0.09, 0.09, 0.09, 0.08, 0.10, 0.10, 0.08, 0.08, 0.08, 0.08 };
+	wavelet.SetBands(sizeof(freqs) / 4, freqs, lengths);
+	decimate.GetInput<2>().Set(30); // 11 for 4000 Hz
 
-		LoopbackSource source;
-		SplitStereo split;
-		Wavelet wavelet;
-		BeatFinder beatFinder;
-		Volume volume;
-		DownSample decimate;
-		VolumeDisplay volumeDisplay;
-		BarDisplay barDisplay;
-		FFT fft;
-		Visualizer visualizer;
+	source.GetOutput(1)->Link(split.GetInput(0));
+	source.GetOutput(0)->Link(decimate.GetInput(0));
 
-		//float freqs[] = { 40, 55, 75, 95, 120, 165, 180, 205, 235, 265 };
-		//float lengths[] = { 0.12, 0.10, 0.09, 0.08, 0.07, 0.12, 0.10, 0.06, 0.05, 0.05 };
-		float freqs[] = { 40, 55, 70, 85, 105, 125, 145, 155, 180, 200, 225, 250, 275, 300 };
-		float lengths[] = { 0.12, 0.10, 0.10, 0.10, 0.09, 0.09, 0.09, 0.08, 0.10, 0.10, 0.08, 0.08, 0.08, 0.08 };
-		wavelet.SetBands(sizeof(freqs) / 4, freqs, lengths);
-		decimate.GetInput<2>().Set(30); // 11 for 4000 Hz
-		fft.SetBinCount(4096, 16384);
+	split.GetOutput(0)->Link(decimate.GetInput(1));
 
-		
-		source.GetOutput(1)->Link(split.GetInput(0));
-		source.GetOutput(0)->Link(decimate.GetInput(0));
+	decimate.GetOutput(0)->Link(wavelet.GetInput(0));
+	decimate.GetOutput(1)->Link(wavelet.GetInput(1));
+	decimate.GetOutput(1)->Link(beatFinder.GetInput(1));
 
-		split.GetOutput(0)->Link(decimate.GetInput(1));
+	wavelet.GetOutput(0)->Link(beatFinder.GetInput(0));
+	wavelet.GetOutput(1)->Link(beatFinder.GetInput(2));
+}
 
-		decimate.GetOutput(0)->Link(wavelet.GetInput(0));
-		decimate.GetOutput(1)->Link(wavelet.GetInput(1));
-		decimate.GetOutput(1)->Link(beatFinder.GetInput(1));
 
-		//wavelet.GetOutput(0)->Link(volume.GetInput(0));
-		//wavelet.GetOutput(1)->Link(volume.GetInput(1));
+// The spectrum part of the live graph.
+void LinkSpectrum(exc::NodeBase& source, SplitStereo& split, FFT& fft) {
+	fft.SetBinCount(4096, 16384);
+	source.GetOutput(0)->Link(fft.GetInput(0));
+	split.GetOutput(1)->Link(fft.GetInput(1));
+}
 
-		wavelet.GetOutput(0)->Link(beatFinder.GetInput(0));
-		wavelet.GetOutput(1)->Link(beatFinder.GetInput(2));
 
-		//volume.GetOutput(0)->Link(volumeDisplay.GetInput(0));
-		//volume.GetOutput(1)->Link(volumeDisplay.GetInput(1));
+// Analyzes the files as fast as the CPU allows, on all cores.
+int AnalyzeFiles(const std::vector<std::string>& paths) {
+	BatchAnalyzer analyzer(LinkAnalysis);
+	double totalDuration = 0.0;
+	size_t numFailed = 0;
 
-		beatFinder.GetOutput(0)->Link(volumeDisplay.GetInput(0));
-		beatFinder.GetOutput(1)->Link(volumeDisplay.GetInput(1));
+	auto start = std::chrono::steady_clock::now();
+	analyzer.Run(paths, [&](const BatchAnalyzer::Result& result) {
+		if (!result.error.empty()) {
+			std::cout << result.path << ": " << result.error << std::endl;
+			++numFailed;
+			return;
+		}
+		totalDuration += result.duration;
+		std::cout << result.path << ": " << result.duration << " s of audio analyzed in " << result.processingTime << " s, "
+			<< result.duration / result.processingTime << " times realtime, " << result.beats.size() << " kicks." << std::endl;
+	});
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
 
-		beatFinder.GetOutput(0)->Link(barDisplay.GetInput(0));
-		beatFinder.GetOutput(1)->Link(barDisplay.GetInput(1));
+	std::cout << paths.size() - numFailed << " of " << paths.size() << " files, " << totalDuration << " s of audio analyzed in "
+		<< elapsed.count() << " s on " << analyzer.GetNumThreads() << " threads, " << totalDuration / elapsed.count() << " times realtime." << std::endl;
+	return numFailed == 0 ? 0 : 1;
+}
 
-		beatFinder.GetOutput(0)->Link(visualizer.GetInput(0));
-		beatFinder.GetOutput(1)->Link(visualizer.GetInput(3));
-		wavelet.GetOutput(1)->Link(visualizer.GetInput(2));
 
-		source.GetOutput(0)->Link(fft.GetInput(0));
-		split.GetOutput(1)->Link(fft.GetInput(1));
+// Analyzes interleaved PCM from stdin as it arrives, until the writer closes the pipe.
+int AnalyzeStdin(size_t numChannels, int sampleRate, const std::string& formatName) {
+	exc::SampleFormat format;
+	if (formatName == "s16") {
+		format = exc::SampleFormat::Int16;
+	}
+	else if (formatName == "s24") {
+		format = exc::SampleFormat::Int24;
+	}
+	else if (formatName == "f32") {
+		format = exc::SampleFormat::Float32;
+	}
+	else {
+		throw std::invalid_argument("Unknown sample format " + formatName + ", use s16, s24 or f32.");
+	}
 
-		fft.GetOutput(1)->Link(visualizer.GetInput(1));
+	PipeSource source;
+	SplitStereo split;
+	DownSample decimate;
+	Wavelet wavelet;
+	BeatFinder beatFinder;
+	LatencyProbe latency;
+	LinkAnalysis(source, split, decimate, wavelet, beatFinder);
+	beatFinder.GetOutput(1)->Link(latency.GetInput(0));
 
+	exc::SdfExecutor executor = {
+		&source,
+		&split,
+		&decimate,
+		&wavelet,
+		&beatFinder,
+		&latency,
+	};
+	executor.SetBlockSize(441);
+	executor.SetEvaluationMode(exc::GraphExecutor::EvaluationMode::Pull);
+	executor.Compile();
 
-		source.Start("default");
+#ifdef _WIN32
+	source.Start(_fileno(stdin), format, numChannels, sampleRate);
+#else
+	source.Start(STDIN_FILENO, format, numChannels, sampleRate);
+#endif
+	while (!source.IsEndOfStream()) {
+		executor.Run();
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	source.Stop();
 
-		while (run && visualizer.IsOpen()) {
-			auto time = std::chrono::steady_clock::now();
-			source.Update();
-			split.Update();
-			decimate.Update();
-			wavelet.Update();
-			beatFinder.Update();
-			volume.Update();
-			fft.Update();
-			//volumeDisplay.Update();
-			//barDisplay.Update();
+	std::cout << double(source.GetNumFramesRead()) / sampleRate << " s of audio analyzed, " << source.GetThroughput() / sampleRate << " times realtime." << std::endl;
+	std::cout << source.GetNumBytesRead() << " bytes in " << source.GetNumReads() << " reads (" << source.GetNumShortReads() << " short), "
+		<< source.GetNumInputStalls() << " input stalls, " << source.GetNumGraphStalls() << " graph stalls." << std::endl;
+	std::cout << "Capture to beat latency: " << latency.GetMeanLatency() * 1000 << " ms mean, " << latency.GetMinLatency() * 1000 << " to "
+		<< latency.GetMaxLatency() * 1000 << " ms over " << latency.GetNumMeasurements() << " ticks." << std::endl;
+	return 0;
+}
 
-			visualizer.Update();
 
-			std::this_thread::sleep_until(time + std::chrono::milliseconds(16));
+// Passes control events through Any ports and containers, and fails if they still allocate after warm-up.
+int BenchmarkAny() {
+	using Payload = std::array<float, 64>; // too large to be stored inline, comes from the pool
+	constexpr int numWarmupEvents = 1000;
+	constexpr int numEvents = 1000000;
+	constexpr size_t batchSize = 32;
+	constexpr int numBatches = 20000;
+	bool isPassed = true;
+
+	auto Report = [&](const char* what, const exc::Any::AllocationStats& before, int count, double seconds, bool allowClones) {
+		exc::Any::AllocationStats after = exc::Any::GetAllocationStats();
+		uint64_t numHeapAllocations = after.numHeapAllocations - before.numHeapAllocations;
+		uint64_t numClones = after.numClones - before.numClones;
+		std::cout << what << ": " << seconds / count * 1e9 << " ns each, " << numHeapAllocations << " heap allocations, "
+			<< after.numPoolReuses - before.numPoolReuses << " pool reuses, " << after.numInlineStores - before.numInlineStores << " inline stores, "
+			<< numClones << " clones." << std::endl;
+		isPassed = isPassed && numHeapAllocations == 0 && (allowClones || numClones == 0);
+	};
+
+	// events forwarded by LogicAny, which copies its input to the output
+	exc::LogicAny forward;
+	exc::OutputPort<exc::Any> events;
+	exc::InputPort<exc::Any> sink;
+	events.Link(forward.GetInput(0));
+	forward.GetOutput(0)->Link(&sink);
+	auto SendEvents = [&](int count) {
+		for (int i = 0; i < count; ++i) {
+			events.Set(exc::Any(float(i)));
+			forward.Update();
+			Payload payload;
+			payload.fill(float(i));
+			events.Set(exc::Any(payload));
+			forward.Update();
+		}
+	};
+	SendEvents(numWarmupEvents);
+	auto stats = exc::Any::GetAllocationStats();
+	auto start = std::chrono::steady_clock::now();
+	SendEvents(numEvents);
+	Report("Forwarded events", stats, 2 * numEvents, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), true);
+
+	// a growing vector moves its elements when it reallocates, that must not clone them
+	auto GrowVector = [&] {
+		std::vector<exc::Any> grown;
+		for (size_t i = 0; i < batchSize; ++i) {
+			grown.push_back(exc::Any(Payload{}));
+		}
+	};
+	GrowVector();
+	stats = exc::Any::GetAllocationStats();
+	start = std::chrono::steady_clock::now();
+	GrowVector();
+	Report("Vector growth", stats, int(batchSize), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), false);
+
+	// payloads made on one thread and destroyed on another, the producer must get the blocks back
+	std::vector<exc::Any> produced, consumed;
+	produced.reserve(batchSize);
+	consumed.reserve(batchSize);
+	std::mutex mtx;
+	std::condition_variable cv;
+	bool isFull = false;
+	bool isDone = false;
+	std::thread consumer([&] {
+		std::unique_lock<std::mutex> lk(mtx);
+		while (true) {
+			cv.wait(lk, [&] { return isFull || isDone; });
+			if (!isFull) {
+				return;
+			}
+			std::swap(produced, consumed);
+			isFull = false;
+			cv.notify_all();
+			lk.unlock();
+			consumed.clear();
+			lk.lock();
+		}
+	});
+	auto Produce = [&](int count) {
+		for (int batch = 0; batch < count; ++batch) {
+			std::unique_lock<std::mutex> lk(mtx);
+			cv.wait(lk, [&] { return !isFull; });
+			for (size_t i = 0; i < batchSize; ++i) {
+				produced.push_back(exc::Any(Payload{}));
+			}
+			isFull = true;
+			cv.notify_all();
 		}
+	};
+	Produce(numWarmupEvents / int(batchSize));
+	stats = exc::Any::GetAllocationStats();
+	start = std::chrono::steady_clock::now();
+	Produce(numBatches);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	{
+		std::lock_guard<std::mutex> lkg(mtx);
+		isDone = true;
+		cv.notify_all();
+	}
+	consumer.join();
+	Report("Cross-thread payloads", stats, numBatches * int(batchSize), seconds, false);
+
+	return isPassed ? 0 : 1;
+}
+
+
+// Runs the live graph without its displays as fast as it can, on synthetic audio. The first ticks may
+// allocate while buffers grow to their steady-state sizes, afterwards nothing in Run() may allocate at all.
+int CheckAllocations() {
+	constexpr int numWarmupTicks = 300; // 3 seconds, longer than any history the nodes keep
+	constexpr int numTicks = 1000;
+
+	SignalGenerator source;
+	SplitStereo split;
+	DownSample decimate;
+	Wavelet wavelet;
+	BeatFinder beatFinder;
+	Volume volume;
+	FFT fft;
+	LatencyProbe latency;
+	LinkAnalysis(source, split, decimate, wavelet, beatFinder);
+	LinkSpectrum(source, split, fft);
+	beatFinder.GetOutput(1)->Link(latency.GetInput(0));
+
+	exc::SdfExecutor executor = {
+		&source,
+		&split,
+		&decimate,
+		&wavelet,
+		&beatFinder,
+		&volume,
+		&fft,
+		&latency,
+	};
+	executor.SetBlockSize(441);
+	executor.SetEvaluationMode(exc::GraphExecutor::EvaluationMode::Pull);
+	executor.Compile();
+
+	for (int i = 0; i < numWarmupTicks; ++i) {
+		executor.Run();
+	}
+	uint64_t numAllocations = 0;
+	int numAllocatingTicks = 0;
+	for (int i = 0; i < numTicks; ++i) {
+		uint64_t before = exc::AllocationCounter::GetNumAllocations();
+		executor.Run();
+		uint64_t tickAllocations = exc::AllocationCounter::GetNumAllocations() - before;
+		numAllocations += tickAllocations;
+		numAllocatingTicks += tickAllocations > 0 ? 1 : 0;
+	}
+
+#ifdef ENABLE_GRAPH_PROFILER
+	exc::Profiler::WriteSummary(std::cout);
+#endif
+	std::cout << "Allocations after warm-up: " << numAllocations << " in " << numAllocatingTicks << " of " << numTicks << " ticks." << std::endl;
+	return numAllocations == 0 ? 0 : 1;
+}
 
-		source.Stop();
+
+// Mean and worst time of a tick of the live graph without its displays, with the nodes around the
+// multi-rate part updated serially or on a pool.
+std::pair<double, double> MeasureTicks(size_t numThreads) {
+	constexpr int numWarmupTicks = 100;
+	constexpr int numTicks = 1000;
+
+	SignalGenerator source;
+	SplitStereo split;
+	DownSample decimate;
+	Wavelet wavelet;
+	BeatFinder beatFinder;
+	FFT fft;
+	LinkAnalysis(source, split, decimate, wavelet, beatFinder);
+	LinkSpectrum(source, split, fft);
+
+	exc::SdfExecutor executor = {
+		&source,
+		&split,
+		&decimate,
+		&wavelet,
+		&beatFinder,
+		&fft,
+	};
+	executor.SetBlockSize(441);
+	executor.SetNumThreads(numThreads);
+	executor.Compile();
+
+	for (int i = 0; i < numWarmupTicks; ++i) {
+		executor.Run();
+	}
+	double total = 0.0;
+	double worst = 0.0;
+	for (int i = 0; i < numTicks; ++i) {
+		auto start = std::chrono::steady_clock::now();
+		executor.Run();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		total += elapsed.count();
+		worst = std::max(worst, elapsed.count());
+	}
+	return { total / numTicks, worst };
+}
+
+
+// Compares the tick time of the live graph with the spectrum and the beat detection run one after
+// the other and side by side. Side by side, a tick takes about as long as the slower of the two.
+int BenchmarkTicks() {
+	auto serial = MeasureTicks(1);
+	auto parallel = MeasureTicks(0);
+	std::cout << "Serial: " << serial.first * 1000 << " ms mean, " << serial.second * 1000 << " ms worst per tick." << std::endl;
+	std::cout << "Parallel on " << std::max(1u, std::thread::hardware_concurrency()) << " threads: " << parallel.first * 1000 << " ms mean, "
+		<< parallel.second * 1000 << " ms worst per tick, " << serial.first / parallel.first << " times faster." << std::endl;
+	return 0;
+}
+
+
+#ifdef _WIN32
+// Captures what the default device plays, and shows the analysis until the window is closed.
+int RunLive() {
+	if (FAILED(CoInitializeEx(NULL, COINIT_MULTITHREADED))) {
+		throw std::runtime_error("CoInitialize failed.");
+	}
+	auto coUninitialize = MakeScopeGuard([] {CoUninitialize(); });
+
+	std::signal(SIGINT, InterruptSignalHandler);
+
+	LoopbackSource source;
+	SplitStereo split;
+	Wavelet wavelet;
+	BeatFinder beatFinder;
+	Volume volume;
+	DownSample decimate;
+	VolumeDisplay volumeDisplay;
+	BarDisplay barDisplay;
+	FFT fft;
+	Visualizer visualizer;
+	LatencyProbe latency;
+
+	LinkAnalysis(source, split, decimate, wavelet, beatFinder);
+	LinkSpectrum(source, split, fft);
+
+	//wavelet.GetOutput(0)->Link(volume.GetInput(0));
+	//wavelet.GetOutput(1)->Link(volume.GetInput(1));
+
+	//volume.GetOutput(0)->Link(volumeDisplay.GetInput(0));
+	//volume.GetOutput(1)->Link(volumeDisplay.GetInput(1));
+
+	beatFinder.GetOutput(0)->Link(volumeDisplay.GetInput(0));
+	beatFinder.GetOutput(1)->Link(volumeDisplay.GetInput(1));
+
+	beatFinder.GetOutput(0)->Link(barDisplay.GetInput(0));
+	beatFinder.GetOutput(1)->Link(barDisplay.GetInput(1));
+
+	beatFinder.GetOutput(0)->Link(visualizer.GetInput(0));
+	beatFinder.GetOutput(1)->Link(visualizer.GetInput(3));
+	wavelet.GetOutput(1)->Link(visualizer.GetInput(2));
+	beatFinder.GetOutput(1)->Link(latency.GetInput(0));
+
+	fft.GetOutput(1)->Link(visualizer.GetInput(1));
+
+	exc::SdfExecutor executor = {
+		&source,
+		&split,
+		&decimate,
+		&wavelet,
+		&beatFinder,
+		&volume,
+		&fft,
+		//&volumeDisplay,
+		//&barDisplay,
+		&visualizer,
+		&latency,
+	};
+	executor.SetBlockSize(441); // 10 ms of input, rounded up to a whole number of decimated samples
+	executor.SetNumThreads(0); // the spectrum and the beat detection run side by side
+	executor.PinToCallingThread(&visualizer); // owns the window, must pump messages on this thread
+	executor.SetEvaluationMode(exc::GraphExecutor::EvaluationMode::Pull); // nothing to do until the source delivers new samples
+	executor.SetAlwaysUpdate(&visualizer); // keeps drawing between blocks
+	executor.Compile();
+
+	source.Start("default");
+
+	while (run && visualizer.IsOpen()) {
+		auto time = std::chrono::steady_clock::now();
+		executor.Run();
+
+		std::this_thread::sleep_until(time + std::chrono::milliseconds(16));
+	}
+
+	source.Stop();
+	std::cout << "Capture to beat latency: " << latency.GetMeanLatency() * 1000 << " ms mean, " << latency.GetMinLatency() * 1000 << " to "
+		<< latency.GetMaxLatency() * 1000 << " ms over " << latency.GetNumMeasurements() << " ticks." << std::endl;
+
+#ifdef ENABLE_GRAPH_PROFILER
+	std::ofstream trace("graph_trace.json");
+	exc::Profiler::WriteChromeTrace(trace);
+	exc::Profiler::WriteSummary(std::cout);
+#endif
+	return 0;
+}
+#endif
+
+
+int main(int argc, char* argv[]) {
+	std::vector<std::string> args(argv + 1, argv + argc);
+
+	try {
+		if (args.size() >= 2 && args[0] == "--analyze") {
+			return AnalyzeFiles({ args.begin() + 1, args.end() });
+		}
+		if (args.size() == 1 && args[0] == "--check-allocations") {
+			return CheckAllocations();
+		}
+		if (args.size() == 1 && args[0] == "--benchmark-any") {
+			return BenchmarkAny();
+		}
+		if (args.size() == 1 && args[0] == "--benchmark-ticks") {
+			return BenchmarkTicks();
+		}
+		if ((args.size() == 3 || args.size() == 4) && args[0] == "--stdin") {
+			return AnalyzeStdin(std::stoul(args[1]), std::stoi(args[2]), args.size() == 4 ? args[3] : "s16");
+		}
+#ifdef _WIN32
+		return RunLive();
+#else
+		std::cout << "Usage: " << argv[0] << " --analyze <file.wav>..." << std::endl;
+		std::cout << "       " << argv[0] << " --stdin <channels> <sample rate> [s16|s24|f32]" << std::endl;
+		std::cout << "       " << argv[0] << " --check-allocations" << std::endl;
+		std::cout << "       " << argv[0] << " --benchmark-any" << std::endl;
+		std::cout << "       " << argv[0] << " --benchmark-ticks" << std::endl;
+		return 1;
+#endif
 	}
 	catch (std::exception& ex) {
 		std::cout << "Your code did not work, lel.";
 		std::cout << "Inline engine would give you a nice stack trace, but I wont, n00b.";
 		std::cout << ex.what() << std::endl;
+		return 1;
 	}
 }